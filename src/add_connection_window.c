@@ -1,6 +1,6 @@
 #include "add_connection_window.h"
 #include "station_select_window.h"
-#include "persistence.h"
+#include "storage.h"
 #include "main_window.h"
 
 static Window *s_window;
@@ -11,22 +11,18 @@ static bool s_departure_selected = false;
 static AppTimer *s_arrival_timer = NULL;
 
 static void save_connection(void) {
-    SavedConnection connections[MAX_SAVED_CONNECTIONS];
-    int count = load_connections(connections);
-
-    if (count >= MAX_SAVED_CONNECTIONS) {
-        // TODO: Show error
-        return;
-    }
-
-    connections[count] = create_saved_connection(
+    SavedConnection connection = create_saved_connection(
         s_departure_station.id,
         s_departure_station.name,
         s_arrival_station.id,
         s_arrival_station.name
     );
 
-    save_connections(connections, count + 1);
+    if (!storage_add_connection(&connection)) {
+        // TODO: Show error
+        return;
+    }
+
     main_window_refresh();
     window_stack_pop(true);
 }
@@ -1,114 +1,322 @@
 #include "app_message.h"
+#include "log.h"
 #include "station_select_window.h"
 #include "connection_detail_window.h"
 #include "data_models.h"
 #include "error_dialog.h"
-#include "persistence.h"
-
-static FavoriteDestination s_temp_favorites[MAX_FAVORITE_DESTINATIONS];
-static int s_temp_favorites_count = 0;
-
-// State for sending favorites to phone
+#include "storage.h"
+#include "message_codec.h"
+#include "outbox_queue.h"
+#include "string_pool.h"
+#include "trace.h"
+#include "latency.h"
+#include "favorites_sync.h"
+
+// Favorites being sent to the phone; queued messages carry only an index
 static FavoriteDestination s_send_favorites[MAX_FAVORITE_DESTINATIONS];
 static int s_send_favorites_count = 0;
-static int s_send_favorites_index = 0;
-static bool s_sending_favorites = false;
+static int s_send_favorites_changes = 0;
+static FavoritesSync s_send_favorites_sync;
+
+// PebbleKit JS sends numbers as 4 byte integers; accept any width
+static int32_t tuple_int(const Tuple *tuple) {
+    switch (tuple->length) {
+        case 1:
+            return tuple->type == TUPLE_UINT ? tuple->value->uint8 : tuple->value->int8;
+        case 2:
+            return tuple->type == TUPLE_UINT ? tuple->value->uint16 : tuple->value->int16;
+        default:
+            return tuple->value->int32;
+    }
+}
+
+static FavoritesSync read_favorites_sync(DictionaryIterator *iter) {
+    FavoritesSync sync = { 0, 0 };
+    Tuple *version_tuple = dict_find(iter, MESSAGE_KEY_FAVORITES_VERSION);
+    Tuple *hash_tuple = dict_find(iter, MESSAGE_KEY_FAVORITES_HASH);
+    if (version_tuple && hash_tuple) {
+        sync.version = (uint16_t)tuple_int(version_tuple);
+        sync.hash = tuple_int(hash_tuple);
+    }
+    return sync;
+}
+
+static void write_favorites_sync(DictionaryIterator *iter, const FavoritesSync *sync) {
+    dict_write_uint16(iter, MESSAGE_KEY_FAVORITES_VERSION, sync->version);
+    dict_write_int32(iter, MESSAGE_KEY_FAVORITES_HASH, sync->hash);
+}
+
+static void write_num_favorites(DictionaryIterator *iter, const void *payload) {
+    dict_write_int8(iter, MESSAGE_KEY_NUM_FAVORITES, s_send_favorites_count);
+    dict_write_uint8(iter, MESSAGE_KEY_FAVORITE_CHANGES, s_send_favorites_changes);
+    write_favorites_sync(iter, &s_send_favorites_sync);
+}
+
+static void write_favorite(DictionaryIterator *iter, const void *payload) {
+    uint8_t index = *(const uint8_t *)payload;
+    FavoriteDestination *fav = &s_send_favorites[index];
+    dict_write_cstring(iter, MESSAGE_KEY_FAVORITE_DESTINATION_ID, fav->id);
+    dict_write_cstring(iter, MESSAGE_KEY_FAVORITE_DESTINATION_NAME, fav->name);
+    dict_write_cstring(iter, MESSAGE_KEY_FAVORITE_DESTINATION_LABEL, fav->label);
+    dict_write_uint8(iter, MESSAGE_KEY_FAVORITE_INDEX, index);
+    LOG_DEBUG("Sending favorite %d: %s", index + 1, fav->label);
+}
+
+// Only the stamp when the phone's copy is current, the whole list otherwise
+static void send_favorites(const FavoritesSync *phone) {
+    s_send_favorites_count = storage_get_favorite_destinations(s_send_favorites);
+    s_send_favorites_sync = storage_get_favorites_sync();
+    s_send_favorites_changes = favorites_sync_is_current(phone) ? 0 : s_send_favorites_count;
+    LOG_INFO("Sending %d of %d favorites to phone", s_send_favorites_changes, s_send_favorites_count);
+
+    // Count first, then one message per favorite, each sent once the previous is acked
+    outbox_queue_send(OUTBOX_KEY_NUM_FAVORITES, write_num_favorites, NULL, NULL, 0);
+    for (uint8_t i = 0; i < s_send_favorites_changes; i++) {
+        outbox_queue_send(OUTBOX_KEY_FAVORITE_BASE + i, write_favorite, NULL, &i, sizeof(i));
+    }
+}
+
+// A delta against another list was dropped; the stamp alone tells the phone
+// to send everything
+static void write_favorites_rejected(DictionaryIterator *iter, const void *payload) {
+    FavoritesSync sync = storage_get_favorites_sync();
+    write_favorites_sync(iter, &sync);
+}
+
+static void receive_favorites_delta(DictionaryIterator *iter, Tuple *num_favorites_tuple) {
+    FavoritesDelta delta;
+    delta.count = (uint8_t)tuple_int(num_favorites_tuple);
+    delta.sync = read_favorites_sync(iter);
+
+    // Phones without delta sync send the whole list, unstamped
+    Tuple *changes_tuple = dict_find(iter, MESSAGE_KEY_FAVORITE_CHANGES);
+    delta.changes = changes_tuple ? (uint8_t)tuple_int(changes_tuple) : delta.count;
+    Tuple *base_tuple = dict_find(iter, MESSAGE_KEY_FAVORITES_BASE_HASH);
+    delta.has_base = base_tuple != NULL;
+    delta.base_hash = base_tuple ? tuple_int(base_tuple) : 0;
+
+    LOG_INFO("Receiving %d of %d favorites", delta.changes, delta.count);
+    if (favorites_sync_begin(&delta) == FAVORITES_SYNC_REJECTED) {
+        outbox_queue_send(OUTBOX_KEY_FAVORITES_REJECTED, write_favorites_rejected, NULL, NULL, 0);
+    }
+}
 
-static void send_next_favorite(void);
+// Trace chunks are packed when written so the dump reflects the buffer as
+// it is when each message goes out
+static uint8_t s_trace_chunk[TRACE_CHUNK_MAX_SIZE];
 
-static void send_favorites_outbox_sent_callback(DictionaryIterator *iterator, void *context) {
-    if (s_sending_favorites) {
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "Favorite message sent, index %d of %d",
-                s_send_favorites_index, s_send_favorites_count);
+static void write_trace_chunk(DictionaryIterator *iter, const void *payload) {
+    uint8_t chunk = *(const uint8_t *)payload;
+    size_t size = trace_encode_chunk(chunk, s_trace_chunk, sizeof(s_trace_chunk));
+    dict_write_data(iter, MESSAGE_KEY_TRACE_DATA, s_trace_chunk, size);
+}
+
+static void send_trace(void) {
+    // Close the dump with where request time went recently
+    for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        if (latency_count(stage) > 0) {
+            trace(TRACE_LATENCY_SUMMARY, stage,
+                  latency_percentile(stage, 90) << 16 | latency_percentile(stage, 50));
+        }
+    }
 
-        // Send next favorite after a short delay
-        app_timer_register(50, (AppTimerCallback)send_next_favorite, NULL);
+    int chunks = trace_chunk_count();
+    LOG_INFO("Sending %d trace chunks to phone", chunks);
+    for (uint8_t i = 0; i < chunks; i++) {
+        outbox_queue_send(OUTBOX_KEY_TRACE_BASE + i, write_trace_chunk, NULL, &i, sizeof(i));
     }
 }
 
-static void send_next_favorite(void) {
-    if (!s_sending_favorites) {
+// The phone sends the first connection on its own so it renders right away,
+// then packs the rest of the result set into as few messages as fit the inbox
+static void receive_connection_batch(Tuple *tuple) {
+    const uint8_t *data = tuple->value->data;
+    size_t length = tuple->length;
+    ConnectionBatch batch;
+
+    size_t offset = 0;
+    if (tuple->type == TUPLE_BYTE_ARRAY) {
+        offset = message_codec_decode_connection_batch(data, length, &batch);
+    }
+    if (offset == 0) {
+        LOG_ERROR("Malformed connection data (%d bytes)", (int)length);
         return;
     }
 
-    if (s_send_favorites_index < s_send_favorites_count) {
-        DictionaryIterator *iter;
-        AppMessageResult result = app_message_outbox_begin(&iter);
-
-        if (result == APP_MSG_OK) {
-            FavoriteDestination *fav = &s_send_favorites[s_send_favorites_index];
-            dict_write_cstring(iter, MESSAGE_KEY_FAVORITE_DESTINATION_ID, fav->id);
-            dict_write_cstring(iter, MESSAGE_KEY_FAVORITE_DESTINATION_NAME, fav->name);
-            dict_write_cstring(iter, MESSAGE_KEY_FAVORITE_DESTINATION_LABEL, fav->label);
-
-            result = app_message_outbox_send();
-            if (result == APP_MSG_OK) {
-                APP_LOG(APP_LOG_LEVEL_DEBUG, "Sending favorite %d: %s",
-                        s_send_favorites_index + 1, fav->label);
-                s_send_favorites_index++;
-            } else {
-                APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to send favorite %d: %d",
-                        s_send_favorites_index, result);
-                s_sending_favorites = false;
+    // Decode each connection straight from the inbox buffer
+    int received = 0;
+    for (int i = 0; i < batch.count; i++) {
+        Connection conn;
+        size_t consumed = message_codec_decode_connection(data + offset, length - offset, &conn);
+        if (consumed == 0) {
+            LOG_ERROR("Malformed connection %d in batch", batch.first_index + i);
+            break;
+        }
+        connection_detail_window_set_connection(batch.first_index + i, &conn);
+        offset += consumed;
+        received++;
+    }
+
+    if (received > 0) {
+        connection_detail_window_receive_batch(batch.version, batch.first_index, received, batch.total);
+    }
+}
+
+// Refresh patch against the set the phone sent last: kept departures that
+// moved or changed, and new ones each followed by a full connection record
+static void receive_connection_patch(Tuple *tuple) {
+    const uint8_t *data = tuple->value->data;
+    size_t length = tuple->length;
+    ConnectionPatch patch;
+
+    size_t offset = 0;
+    if (tuple->type == TUPLE_BYTE_ARRAY) {
+        offset = message_codec_decode_connection_patch(data, length, &patch);
+    }
+    if (offset == 0 || patch.base_version != connection_detail_window_get_version()) {
+        LOG_ERROR("Ignoring connection patch (%d bytes)", (int)length);
+        return;
+    }
+
+    // Find every entry first so they can be applied in a safe order
+    size_t offsets[MAX_CONNECTION_RESULTS];
+    ConnectionUpdate update;
+    int decoded = 0;
+    while (decoded < patch.count) {
+        size_t consumed = message_codec_decode_connection_update(data + offset, length - offset, &update);
+        if (consumed == 0) {
+            break;
+        }
+        offsets[decoded] = offset;
+        offset += consumed;
+        if (update.from == CONNECTION_UPDATE_ADDED) {
+            Connection conn;
+            consumed = message_codec_decode_connection(data + offset, length - offset, &conn);
+            if (consumed == 0) {
+                break;
             }
-        } else {
-            APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to begin outbox for favorite %d: %d",
-                    s_send_favorites_index, result);
-            s_sending_favorites = false;
+            offset += consumed;
         }
-    } else {
-        // All favorites sent
-        APP_LOG(APP_LOG_LEVEL_INFO, "Finished sending all %d favorites", s_send_favorites_count);
-        s_sending_favorites = false;
+        decoded++;
+    }
+    if (decoded < patch.count) {
+        // Nothing has been applied yet; have the next refresh resend everything
+        LOG_ERROR("Malformed connection patch");
+        connection_detail_window_set_version(0);
+        return;
     }
+
+    // Kept departures never change order, so moves towards the top are
+    // applied top-down and moves towards the bottom bottom-up
+    for (int i = 0; i < patch.count; i++) {
+        message_codec_decode_connection_update(data + offsets[i], length - offsets[i], &update);
+        if (update.from != CONNECTION_UPDATE_ADDED && update.index <= update.from) {
+            connection_detail_window_apply_update(&update);
+        }
+    }
+    for (int i = patch.count - 1; i >= 0; i--) {
+        message_codec_decode_connection_update(data + offsets[i], length - offsets[i], &update);
+        if (update.from != CONNECTION_UPDATE_ADDED && update.index > update.from) {
+            connection_detail_window_apply_update(&update);
+        }
+    }
+    for (int i = 0; i < patch.count; i++) {
+        size_t consumed = message_codec_decode_connection_update(data + offsets[i], length - offsets[i], &update);
+        if (update.from == CONNECTION_UPDATE_ADDED) {
+            Connection conn;
+            size_t start = offsets[i] + consumed;
+            message_codec_decode_connection(data + start, length - start, &conn);
+            connection_detail_window_set_connection(update.index, &conn);
+        }
+    }
+
+    bool changed = patch.count > 0 || patch.version != patch.base_version;
+    connection_detail_window_finish_patch(patch.version, patch.total, changed);
+}
+
+// Stage timings echoed with the first response to a connection request
+static void receive_request_timing(Tuple *tuple) {
+    RequestTiming timing;
+    if (tuple->type != TUPLE_BYTE_ARRAY ||
+        message_codec_decode_request_timing(tuple->value->data, tuple->length, &timing) == 0) {
+        LOG_ERROR("Malformed request timing (%d bytes)", (int)tuple->length);
+        return;
+    }
+
+    uint32_t total = trace_now_ms() - timing.watch_time;
+    uint32_t phone = timing.phone_ms;
+    uint32_t remote = timing.fetch_ms + timing.parse_ms;
+    latency_record(LATENCY_TOTAL, total);
+    latency_record(LATENCY_BLUETOOTH, total > phone ? total - phone : 0);
+    latency_record(LATENCY_PHONE, phone > remote ? phone - remote : 0);
+    latency_record(LATENCY_FETCH, timing.fetch_ms);
+    latency_record(LATENCY_PARSE, timing.parse_ms);
+    trace(TRACE_REQUEST_LATENCY, timing.request_id, total);
+
+    LOG_DEBUG("Request %d: %d ms (p50/p90 total %d/%d, bt %d/%d, fetch %d/%d)",
+            timing.request_id, (int)total,
+            (int)latency_percentile(LATENCY_TOTAL, 50), (int)latency_percentile(LATENCY_TOTAL, 90),
+            (int)latency_percentile(LATENCY_BLUETOOTH, 50), (int)latency_percentile(LATENCY_BLUETOOTH, 90),
+            (int)latency_percentile(LATENCY_FETCH, 50), (int)latency_percentile(LATENCY_FETCH, 90));
+}
+
+// All nearby stations arrive in one message, already sorted by distance
+static void receive_station_list(Tuple *tuple) {
+    const uint8_t *data = tuple->value->data;
+    size_t length = tuple->length;
+    StationList list;
+
+    size_t offset = 0;
+    if (tuple->type == TUPLE_BYTE_ARRAY) {
+        offset = message_codec_decode_station_list(data, length, &list);
+    }
+    if (offset == 0) {
+        LOG_ERROR("Malformed station list (%d bytes)", (int)length);
+        return;
+    }
+
+    int received = 0;
+    for (int i = 0; i < list.count; i++) {
+        Station station;
+        size_t consumed = message_codec_decode_station(data + offset, length - offset, &station);
+        if (consumed == 0) {
+            LOG_ERROR("Malformed station %d in list", i);
+            break;
+        }
+        station_select_window_set_station(i, &station);
+        offset += consumed;
+        received++;
+    }
+
+    station_select_window_update_stations(received);
 }
 
 static void inbox_received_callback(DictionaryIterator *iterator, void *context) {
+    // Every interned name now lives in a registered root; drop the rest
+    // before this message interns new ones
+    string_pool_collect();
+
+    Tuple *first = dict_read_first(iterator);
+    trace(TRACE_INBOX_RECEIVED, first ? first->key : 0, 0);
+
     // Check for request to send favorites back to phone
     Tuple *request_favorites_tuple = dict_find(iterator, MESSAGE_KEY_REQUEST_FAVORITES);
     if (request_favorites_tuple) {
-        APP_LOG(APP_LOG_LEVEL_INFO, "Received request for favorites");
-
-        // Load favorites from storage
-        s_send_favorites_count = load_favorite_destinations(s_send_favorites);
-        s_send_favorites_index = 0;
-        s_sending_favorites = true;
-
-        APP_LOG(APP_LOG_LEVEL_INFO, "Sending %d favorites to phone", s_send_favorites_count);
-
-        // Send count first
-        DictionaryIterator *iter;
-        AppMessageResult result = app_message_outbox_begin(&iter);
-        if (result == APP_MSG_OK) {
-            dict_write_int8(iter, MESSAGE_KEY_NUM_FAVORITES, s_send_favorites_count);
-            result = app_message_outbox_send();
-
-            if (result == APP_MSG_OK) {
-                APP_LOG(APP_LOG_LEVEL_DEBUG, "Sent NUM_FAVORITES successfully");
-                // First favorite will be sent via the outbox_sent callback
-            } else {
-                APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to send NUM_FAVORITES: %d", result);
-                s_sending_favorites = false;
-            }
-        } else {
-            APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to begin outbox for NUM_FAVORITES: %d", result);
-            s_sending_favorites = false;
-        }
+        LOG_INFO("Received request for favorites");
+        FavoritesSync phone = read_favorites_sync(iterator);
+        send_favorites(&phone);
         return;
     }
 
-    // Check for station data
-    Tuple *station_name_tuple = dict_find(iterator, MESSAGE_KEY_STATION_NAME);
-    Tuple *station_id_tuple = dict_find(iterator, MESSAGE_KEY_STATION_ID);
-    Tuple *station_distance_tuple = dict_find(iterator, MESSAGE_KEY_STATION_DISTANCE);
+    if (dict_find(iterator, MESSAGE_KEY_REQUEST_TRACE)) {
+        send_trace();
+        return;
+    }
 
-    if (station_name_tuple && station_id_tuple && station_distance_tuple) {
-        Station station = create_station(
-            station_id_tuple->value->cstring,
-            station_name_tuple->value->cstring,
-            station_distance_tuple->value->int32
-        );
-        station_select_window_add_station(station);
+    // Check for nearby stations
+    Tuple *station_list_tuple = dict_find(iterator, MESSAGE_KEY_STATION_LIST);
+    if (station_list_tuple) {
+        receive_station_list(station_list_tuple);
         return;
     }
 
@@ -119,90 +327,64 @@ static void inbox_received_callback(DictionaryIterator *iterator, void *context)
     Tuple *num_favorites_tuple = dict_find(iterator, MESSAGE_KEY_NUM_FAVORITES);
 
     if (num_favorites_tuple) {
-        // Start receiving new favorites list
-        s_temp_favorites_count = 0;
-        APP_LOG(APP_LOG_LEVEL_INFO, "Receiving %d favorites", num_favorites_tuple->value->int8);
+        receive_favorites_delta(iterator, num_favorites_tuple);
         return;
     }
 
     if (fav_id_tuple && fav_name_tuple && fav_label_tuple) {
-        // Receive individual favorite
-        if (s_temp_favorites_count < MAX_FAVORITE_DESTINATIONS) {
-            FavoriteDestination fav = create_favorite_destination(
-                fav_id_tuple->value->cstring,
-                fav_name_tuple->value->cstring,
-                fav_label_tuple->value->cstring
-            );
-            s_temp_favorites[s_temp_favorites_count++] = fav;
-            APP_LOG(APP_LOG_LEVEL_INFO, "Received favorite: %s - %s",
-                    fav.label, fav.name);
-
-            // If we've received all expected favorites, save them
-            save_favorite_destinations(s_temp_favorites, s_temp_favorites_count);
-        }
+        FavoriteDestination fav = create_favorite_destination(
+            fav_id_tuple->value->cstring,
+            fav_name_tuple->value->cstring,
+            fav_label_tuple->value->cstring
+        );
+        Tuple *index_tuple = dict_find(iterator, MESSAGE_KEY_FAVORITE_INDEX);
+        favorites_sync_receive(index_tuple ? tuple_int(index_tuple) : -1, &fav);
         return;
     }
 
     // Check for connection data
     // Note: Quick route feature reuses this same CONNECTION_DATA message type
     // No separate REQUEST_QUICK_ROUTE handler needed - same flow as regular connections
+    Tuple *timing_tuple = dict_find(iterator, MESSAGE_KEY_REQUEST_TIMING);
+    if (timing_tuple) {
+        receive_request_timing(timing_tuple);
+    }
+
     Tuple *conn_data_tuple = dict_find(iterator, MESSAGE_KEY_CONNECTION_DATA);
     if (conn_data_tuple) {
-        Connection conn;
-        conn.num_sections = 1;  // Simple case for now
-
-        Tuple *dep_time = dict_find(iterator, MESSAGE_KEY_DEPARTURE_TIME);
-        Tuple *arr_time = dict_find(iterator, MESSAGE_KEY_ARRIVAL_TIME);
-        Tuple *platform = dict_find(iterator, MESSAGE_KEY_PLATFORM);
-        Tuple *train_type = dict_find(iterator, MESSAGE_KEY_TRAIN_TYPE);
-        Tuple *delay = dict_find(iterator, MESSAGE_KEY_DELAY_MINUTES);
-        Tuple *num_changes = dict_find(iterator, MESSAGE_KEY_NUM_CHANGES);
-
-        if (dep_time && arr_time) {
-            conn.departure_time = dep_time->value->int32;
-            conn.arrival_time = arr_time->value->int32;
-            conn.total_delay_minutes = delay ? delay->value->int8 : 0;
-            conn.num_changes = num_changes ? num_changes->value->int8 : 0;
-
-            // First section
-            conn.sections[0].departure_time = conn.departure_time;
-            conn.sections[0].arrival_time = conn.arrival_time;
-            conn.sections[0].delay_minutes = conn.total_delay_minutes;
-
-            if (platform) {
-                strncpy(conn.sections[0].platform, platform->value->cstring, MAX_PLATFORM_LENGTH - 1);
-            }
-            if (train_type) {
-                strncpy(conn.sections[0].train_type, train_type->value->cstring, MAX_TRAIN_TYPE_LENGTH - 1);
-            }
+        receive_connection_batch(conn_data_tuple);
+        return;
+    }
 
-            connection_detail_window_update_data(&conn, 1);
-        }
+    Tuple *conn_patch_tuple = dict_find(iterator, MESSAGE_KEY_CONNECTION_PATCH);
+    if (conn_patch_tuple) {
+        receive_connection_patch(conn_patch_tuple);
         return;
     }
 
     // Check for error
     Tuple *error_tuple = dict_find(iterator, MESSAGE_KEY_ERROR_MESSAGE);
     if (error_tuple) {
-        APP_LOG(APP_LOG_LEVEL_ERROR, "Error from JS: %s", error_tuple->value->cstring);
+        LOG_ERROR("Error from JS: %s", error_tuple->value->cstring);
         show_error_dialog("Error", error_tuple->value->cstring);
+        connection_detail_window_request_failed();
         return;
     }
 }
 
 static void inbox_dropped_callback(AppMessageResult reason, void *context) {
-    APP_LOG(APP_LOG_LEVEL_ERROR, "Message dropped: %d", (int)reason);
+    LOG_ERROR("Message dropped: %d", (int)reason);
+    trace(TRACE_INBOX_DROPPED, reason, 0);
 }
 
 static void outbox_failed_callback(DictionaryIterator *iterator, AppMessageResult reason, void *context) {
-    APP_LOG(APP_LOG_LEVEL_ERROR, "Outbox failed: %d", (int)reason);
+    LOG_ERROR("Outbox failed: %d", (int)reason);
+    outbox_queue_handle_failed(reason);
 }
 
 static void outbox_sent_callback(DictionaryIterator *iterator, void *context) {
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "Outbox sent successfully");
-
-    // Handle favorites sending continuation
-    send_favorites_outbox_sent_callback(iterator, context);
+    LOG_DEBUG("Outbox sent successfully");
+    outbox_queue_handle_sent();
 }
 
 void app_message_init(void) {
@@ -215,5 +397,7 @@ void app_message_init(void) {
 }
 
 void app_message_deinit(void) {
+    outbox_queue_reset();
+    favorites_sync_reset();
     app_message_deregister_callbacks();
 }
@@ -1,70 +1,52 @@
 #include "connection_detail_window.h"
+#include "log.h"
 #include "journey_detail_window.h"
 #include "pinned_connection.h"
-#include "persistence.h"
+#include "last_result.h"
+#include "storage.h"
+#include "outbox_queue.h"
+#include "row_model.h"
+#include "marquee.h"
+#include "refresh_scheduler.h"
+#include "trace.h"
 
 static Window *s_window;
 static MenuLayer *s_menu_layer;
 static SavedConnection s_connection;
-static Connection s_connections[5];
+static Connection s_connections[MAX_CONNECTION_RESULTS];
 static int s_num_connections = 0;
+static ConnectionRow s_rows[MAX_CONNECTION_RESULTS];
+static char s_title[64];
+static uint8_t s_result_version = 0;  // 0: nothing the phone can patch
+static uint8_t s_batch_version = 0;   // Result set the last batch belonged to
+static int s_batch_received = 0;      // Its rows received without a gap from index 0
 static TextLayer *s_status_layer;
-static AppTimer *s_refresh_timer;
+static char s_status_text[32];
+// Rows from this index on were restored from the last result and only hold
+// what the row draws; MAX_CONNECTION_RESULTS once the phone sent a full set
+static int s_first_stub = MAX_CONNECTION_RESULTS;
+static time_t s_saved_at = 0;  // When the rows on screen were received, if restored
+static RefreshScheduler s_refresh;
 
-// Text scrolling state
-static AppTimer *s_scroll_timer = NULL;
-static int s_scroll_offset = 0;
-static bool s_scrolling_required = false;
-static bool s_menu_reloading = false;
+// Row layout, fixed once the menu is sized
+static GRect s_header_rect;
+static GRect s_time_rect;
+static GRect s_footer_rect;
+
+static Marquee s_marquee;
 
-#define REFRESH_INTERVAL_MS 60000  // 60 seconds
-#define SCROLL_WAIT_MS 1000
-#define SCROLL_STEP_MS 200
 #define MENU_CHARS_VISIBLE 14  // Shorter due to time text
 
 static void request_connections(void);
 
-static void format_time(time_t timestamp, char *buffer, size_t size) {
-    struct tm *tm_info = localtime(&timestamp);
-    if (tm_info) {
-        strftime(buffer, size, "%H:%M", tm_info);
-    } else {
-        snprintf(buffer, size, "??:??");
-        APP_LOG(APP_LOG_LEVEL_ERROR, "localtime returned NULL for timestamp %d", (int)timestamp);
-    }
-}
-
-static void scroll_menu_callback(void *data) {
-    s_scroll_timer = NULL;
-    s_scroll_offset++;
-
-    if (!s_scrolling_required) {
-        return;
-    }
-
-    s_menu_reloading = true;
-    s_scrolling_required = false;
-    menu_layer_reload_data(s_menu_layer);
-    s_scroll_timer = app_timer_register(SCROLL_STEP_MS, scroll_menu_callback, NULL);
-}
-
-static void initiate_menu_scroll_timer(void) {
-    s_scrolling_required = true;
-    s_scroll_offset = 0;
-    s_menu_reloading = false;
-
-    if (s_scroll_timer) {
-        app_timer_cancel(s_scroll_timer);
+static void build_rows(void) {
+    for (int i = 0; i < s_num_connections; i++) {
+        row_model_build_connection(&s_connections[i], &s_rows[i]);
     }
-    s_scroll_timer = app_timer_register(SCROLL_WAIT_MS, scroll_menu_callback, NULL);
 }
 
 static void menu_selection_changed_callback(MenuLayer *menu_layer, MenuIndex new_index, MenuIndex old_index, void *data) {
-    if (!s_menu_reloading) {
-        initiate_menu_scroll_timer();
-    } else {
-        s_menu_reloading = false;
-    }
+    marquee_restart(&s_marquee);
 }
 
 static uint16_t menu_get_num_sections_callback(MenuLayer *menu_layer, void *data) {
@@ -80,11 +62,7 @@ static int16_t menu_get_header_height_callback(MenuLayer *menu_layer, uint16_t s
 }
 
 static void menu_draw_header_callback(GContext* ctx, const Layer *cell_layer, uint16_t section_index, void *data) {
-    static char header[64];
-    snprintf(header, sizeof(header), "%s - %s",
-             s_connection.departure_station_name,
-             s_connection.arrival_station_name);
-    menu_cell_basic_header_draw(ctx, cell_layer, header);
+    menu_cell_basic_header_draw(ctx, cell_layer, s_title);
 }
 
 static int16_t menu_get_cell_height_callback(MenuLayer *menu_layer, MenuIndex *cell_index, void *data) {
@@ -100,96 +78,41 @@ static void menu_select_callback(MenuLayer *menu_layer, MenuIndex *cell_index, v
         return;  // Out of bounds
     }
 
+    if (cell_index->row >= s_first_stub) {
+        return;  // No journey details until the phone answers
+    }
+
     Connection *selected = &s_connections[cell_index->row];
     journey_detail_window_push(selected);
 }
 
 static void menu_draw_row_callback(GContext* ctx, const Layer *cell_layer, MenuIndex *cell_index, void *data) {
-    APP_LOG(APP_LOG_LEVEL_INFO, "Drawing row %d, total connections: %d", cell_index->row, s_num_connections);
-
     if (s_num_connections == 0) {
-        APP_LOG(APP_LOG_LEVEL_INFO, "No connections, showing loading");
         menu_cell_basic_draw(ctx, cell_layer, "Loading...", "Fetching trains", NULL);
         return;
     }
 
-    APP_LOG(APP_LOG_LEVEL_INFO, "Drawing connection %d", cell_index->row);
-
     // Bounds check to prevent crash
     if (cell_index->row >= s_num_connections) {
-        APP_LOG(APP_LOG_LEVEL_ERROR, "Row %d out of bounds (total: %d)",
-                cell_index->row, s_num_connections);
         menu_cell_basic_draw(ctx, cell_layer, "Error", "Invalid row", NULL);
         return;
     }
 
-    Connection *conn = &s_connections[cell_index->row];
-    GRect bounds = layer_get_bounds(cell_layer);
-
-    char dep_time[6], arr_time[6];
-    format_time(conn->departure_time, dep_time, sizeof(dep_time));
-    format_time(conn->arrival_time, arr_time, sizeof(arr_time));
-    APP_LOG(APP_LOG_LEVEL_INFO, "Formatted times: %s - %s", dep_time, arr_time);
-
-    // Small header: Train type | Platform
-    char header[64];
-    if (conn->sections[0].platform[0] != '\0') {
-        snprintf(header, sizeof(header), "%s | Pl.%s",
-                 conn->sections[0].train_type,
-                 conn->sections[0].platform);
-    } else {
-        snprintf(header, sizeof(header), "%s", conn->sections[0].train_type);
-    }
-
-    // Large middle: Time
-    char time_text[32];
-    if (conn->num_changes > 0) {
-        snprintf(time_text, sizeof(time_text), "%s - %s | %d chg",
-                 dep_time, arr_time, conn->num_changes);
-    } else {
-        snprintf(time_text, sizeof(time_text), "%s - %s",
-                 dep_time, arr_time);
-    }
+    const ConnectionRow *row = &s_rows[cell_index->row];
 
-    // Small footer: Delay status
-    char footer[32];
-    if (conn->total_delay_minutes > 60) {
-        snprintf(footer, sizeof(footer), "+60+ min delay");
-    } else if (conn->total_delay_minutes > 0) {
-        snprintf(footer, sizeof(footer), "+%d min delay", conn->total_delay_minutes);
-    } else {
-        snprintf(footer, sizeof(footer), "On time");
-    }
-
-    APP_LOG(APP_LOG_LEVEL_INFO, "Drawing text - Header: '%s', Time: '%s', Footer: '%s'",
-            header, time_text, footer);
-
-    // Check if selected for scrolling
-    MenuIndex selected_index = menu_layer_get_selected_index(s_menu_layer);
-    bool is_selected = (cell_index->row == selected_index.row);
-
-    const char *time_to_draw = time_text;
-    if (is_selected) {
-        int len = strlen(time_text);
-        if (len > MENU_CHARS_VISIBLE) {
-            if (s_scroll_offset < len - MENU_CHARS_VISIBLE) {
-                time_to_draw += s_scroll_offset;
-                s_scrolling_required = true;
-            }
-        }
-    }
+    const char *time_to_draw = marquee_text(&s_marquee, cell_index, row->time_text, MENU_CHARS_VISIBLE);
 
     // Fill background with white first
     graphics_context_set_fill_color(ctx, GColorWhite);
-    graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+    graphics_fill_rect(ctx, layer_get_bounds(cell_layer), 0, GCornerNone);
 
     // Draw three-line layout with black text
     graphics_context_set_text_color(ctx, GColorBlack);
 
     // Header (small font)
-    graphics_draw_text(ctx, header,
+    graphics_draw_text(ctx, row->header,
                       fonts_get_system_font(FONT_KEY_GOTHIC_18),
-                      GRect(4, 2, bounds.size.w - 8, 20),
+                      s_header_rect,
                       GTextOverflowModeTrailingEllipsis,
                       GTextAlignmentLeft,
                       NULL);
@@ -197,36 +120,88 @@ static void menu_draw_row_callback(GContext* ctx, const Layer *cell_layer, MenuI
     // Time (large font)
     graphics_draw_text(ctx, time_to_draw,
                       fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD),
-                      GRect(4, 20, bounds.size.w - 8, 28),
+                      s_time_rect,
                       GTextOverflowModeTrailingEllipsis,
                       GTextAlignmentLeft,
                       NULL);
 
     // Footer (small font)
-    graphics_draw_text(ctx, footer,
+    graphics_draw_text(ctx, row->footer,
                       fonts_get_system_font(FONT_KEY_GOTHIC_18),
-                      GRect(4, 46, bounds.size.w - 8, 20),
+                      s_footer_rect,
                       GTextOverflowModeTrailingEllipsis,
                       GTextAlignmentLeft,
                       NULL);
+}
 
-    APP_LOG(APP_LOG_LEVEL_INFO, "Finished drawing connection row");
+// Earliest departure still ahead, including its delay; 0 if none
+static time_t next_departure(void) {
+    time_t now = time(NULL);
+    time_t earliest = 0;
+    for (int i = 0; i < s_num_connections; i++) {
+        const Connection *conn = &s_connections[i];
+        time_t departure = conn->departure_time + conn->sections[0].delay_minutes * 60;
+        if (departure >= now && (earliest == 0 || departure < earliest)) {
+            earliest = departure;
+        }
+    }
+    return earliest;
 }
 
-static void refresh_timer_callback(void *data) {
-    request_connections();
-    s_refresh_timer = app_timer_register(REFRESH_INTERVAL_MS, refresh_timer_callback, NULL);
+typedef struct {
+    char departure_station_id[MAX_STATION_ID_LENGTH];
+    char arrival_station_id[MAX_STATION_ID_LENGTH];
+    uint8_t version;
+} ConnectionRequest;
+
+static uint16_t s_request_id = 0;
+
+static void write_connection_request(DictionaryIterator *iter, const void *payload) {
+    const ConnectionRequest *request = payload;
+    dict_write_uint8(iter, MESSAGE_KEY_REQUEST_CONNECTIONS, 1);
+    dict_write_cstring(iter, MESSAGE_KEY_DEPARTURE_STATION_ID, request->departure_station_id);
+    dict_write_cstring(iter, MESSAGE_KEY_ARRIVAL_STATION_ID, request->arrival_station_id);
+    dict_write_uint8(iter, MESSAGE_KEY_CONNECTION_VERSION, request->version);
+    // Stamped when actually written so outbox retries don't count as latency;
+    // the phone echoes both back in REQUEST_TIMING
+    dict_write_uint16(iter, MESSAGE_KEY_REQUEST_ID, ++s_request_id);
+    dict_write_uint32(iter, MESSAGE_KEY_REQUEST_TIME, trace_now_ms());
+}
+
+// Restored rows say when they were received so they aren't taken for live data
+static void set_status(const char *text) {
+    if (s_saved_at == 0) {
+        text_layer_set_text(s_status_layer, text);
+        return;
+    }
+    char saved[6];
+    row_model_format_time(s_saved_at, saved, sizeof(saved));
+    snprintf(s_status_text, sizeof(s_status_text), "Saved %s | %s", saved, text);
+    text_layer_set_text(s_status_layer, s_status_text);
+}
+
+static void connection_request_failed(const void *payload) {
+    // The next refresh tries again, a bit later each time
+    if (s_menu_layer) {
+        set_status("Phone unreachable");
+        refresh_scheduler_failed(&s_refresh);
+    }
 }
 
 static void request_connections(void) {
-    APP_LOG(APP_LOG_LEVEL_INFO, "Requesting connections: %s → %s",
+    LOG_INFO("Requesting connections: %s → %s",
             s_connection.departure_station_id, s_connection.arrival_station_id);
-    DictionaryIterator *iter;
-    app_message_outbox_begin(&iter);
-    dict_write_uint8(iter, MESSAGE_KEY_REQUEST_CONNECTIONS, 1);
-    dict_write_cstring(iter, MESSAGE_KEY_DEPARTURE_STATION_ID, s_connection.departure_station_id);
-    dict_write_cstring(iter, MESSAGE_KEY_ARRIVAL_STATION_ID, s_connection.arrival_station_id);
-    app_message_outbox_send();
+    ConnectionRequest request;
+    memset(&request, 0, sizeof(request));
+    strncpy(request.departure_station_id, s_connection.departure_station_id, MAX_STATION_ID_LENGTH - 1);
+    strncpy(request.arrival_station_id, s_connection.arrival_station_id, MAX_STATION_ID_LENGTH - 1);
+    // Only a complete result set can be patched by the phone
+    request.version = s_num_connections > 0 ? s_result_version : 0;
+    trace(TRACE_CONNECTIONS_REQUESTED, request.version, 0);
+
+    // A refresh tick and a fresh push for the same route collapse into one request
+    outbox_queue_send(OUTBOX_KEY_REQUEST_CONNECTIONS, write_connection_request,
+                      connection_request_failed, &request, sizeof(request));
 }
 
 static TextLayer *s_confirmation_layer = NULL;
@@ -266,18 +241,13 @@ static void select_long_click_handler(ClickRecognizerRef recognizer, void *conte
         s_connection.arrival_station_name
     );
 
-    SavedConnection connections[MAX_SAVED_CONNECTIONS];
-    int count = load_connections(connections);
-
-    if (count < MAX_SAVED_CONNECTIONS) {
-        connections[count++] = new_connection;
-        save_connections(connections, count);
+    if (storage_add_connection(&new_connection)) {
         show_confirmation("Connection saved");
-        APP_LOG(APP_LOG_LEVEL_INFO, "Saved connection: %s -> %s",
+        LOG_INFO("Saved connection: %s -> %s",
                 new_connection.departure_station_name, new_connection.arrival_station_name);
     } else {
         show_confirmation("Max connections reached");
-        APP_LOG(APP_LOG_LEVEL_WARNING, "Cannot save: max connections reached");
+        LOG_WARNING("Cannot save: max connections reached");
     }
 }
 
@@ -285,7 +255,7 @@ static void down_long_click_handler(ClickRecognizerRef recognizer, void *context
     // Pin current connection
     MenuIndex selected = menu_layer_get_selected_index(s_menu_layer);
 
-    if (selected.row >= s_num_connections) {
+    if (selected.row >= s_num_connections || selected.row >= s_first_stub) {
         return;
     }
 
@@ -297,9 +267,9 @@ static void down_long_click_handler(ClickRecognizerRef recognizer, void *context
     pinned.pinned_at = time(NULL);
     pinned.is_active = true;
 
-    save_pinned_connection(&pinned);
+    storage_set_pinned_connection(&pinned);
     show_confirmation("Connection pinned");
-    APP_LOG(APP_LOG_LEVEL_INFO, "Pinned connection: %s -> %s, arrival: %d",
+    LOG_INFO("Pinned connection: %s -> %s, arrival: %d",
             pinned.route.departure_station_name, pinned.route.arrival_station_name,
             (int)pinned.connection.arrival_time);
 }
@@ -310,20 +280,24 @@ static void click_config_provider(void *context) {
 }
 
 static void window_load(Window *window) {
-    APP_LOG(APP_LOG_LEVEL_INFO, "Connection detail window_load called");
+    LOG_INFO("Connection detail window_load called");
     Layer *window_layer = window_get_root_layer(window);
     GRect bounds = layer_get_bounds(window_layer);
 
     // Status layer
     s_status_layer = text_layer_create(GRect(0, bounds.size.h - 20, bounds.size.w, 20));
-    text_layer_set_text(s_status_layer, "Updating...");
     text_layer_set_text_alignment(s_status_layer, GTextAlignmentCenter);
     text_layer_set_font(s_status_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+    set_status("Updating...");
     layer_add_child(window_layer, text_layer_get_layer(s_status_layer));
 
     // Menu layer
     GRect menu_bounds = GRect(0, 0, bounds.size.w, bounds.size.h - 20);
+    s_header_rect = GRect(4, 2, bounds.size.w - 8, 20);
+    s_time_rect = GRect(4, 20, bounds.size.w - 8, 28);
+    s_footer_rect = GRect(4, 46, bounds.size.w - 8, 20);
     s_menu_layer = menu_layer_create(menu_bounds);
+    marquee_init(&s_marquee, s_menu_layer);
     menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks){
         .get_num_sections = menu_get_num_sections_callback,
         .get_num_rows = menu_get_num_rows_callback,
@@ -342,64 +316,204 @@ static void window_load(Window *window) {
 
     layer_add_child(window_layer, menu_layer_get_layer(s_menu_layer));
 
-    APP_LOG(APP_LOG_LEVEL_INFO, "Menu layer configured with colors");
+    LOG_INFO("Menu layer configured with colors");
 
     // Register click config provider for long-press handlers
     window_set_click_config_provider(s_window, click_config_provider);
 
-    // Request initial data
+    // Request initial data; later refreshes follow the departures on screen
     request_connections();
+    refresh_scheduler_init(&s_refresh, request_connections);
+}
 
-    // Start refresh timer
-    s_refresh_timer = app_timer_register(REFRESH_INTERVAL_MS, refresh_timer_callback, NULL);
+static void window_appear(Window *window) {
+    marquee_restart(&s_marquee);
+    refresh_scheduler_resume(&s_refresh, REFRESH_PAUSE_HIDDEN);
 }
 
+static void window_disappear(Window *window) {
+    marquee_pause(&s_marquee);
+    refresh_scheduler_pause(&s_refresh, REFRESH_PAUSE_HIDDEN);
+}
+
+static void mark_strings(void);
+
 static void window_unload(Window *window) {
-    if (s_refresh_timer) {
-        app_timer_cancel(s_refresh_timer);
-        s_refresh_timer = NULL;
-    }
-    if (s_scroll_timer) {
-        app_timer_cancel(s_scroll_timer);
-        s_scroll_timer = NULL;
-    }
+    string_pool_unregister_root(mark_strings);
+    refresh_scheduler_deinit(&s_refresh);
+    marquee_deinit(&s_marquee);
     if (s_confirmation_layer) {
         text_layer_destroy(s_confirmation_layer);
         s_confirmation_layer = NULL;
     }
     text_layer_destroy(s_status_layer);
     menu_layer_destroy(s_menu_layer);
+    s_menu_layer = NULL;
+    storage_flush();
 }
 
-void connection_detail_window_push(SavedConnection *connection) {
-    APP_LOG(APP_LOG_LEVEL_INFO, "Connection detail window push: %s → %s",
+// Keeps the station names of the rows on screen alive in the string pool
+static void mark_strings(void) {
+    for (int i = 0; i < s_num_connections; i++) {
+        connection_mark_strings(&s_connections[i]);
+    }
+}
+
+void connection_detail_window_push(const SavedConnection *connection) {
+    LOG_INFO("Connection detail window push: %s → %s",
             connection->departure_station_name, connection->arrival_station_name);
     s_connection = *connection;
+    snprintf(s_title, sizeof(s_title), "%s - %s",
+             connection->departure_station_name, connection->arrival_station_name);
     s_num_connections = 0;
+    s_result_version = 0;
+    s_batch_version = 0;
+    s_batch_received = 0;
+    s_first_stub = MAX_CONNECTION_RESULTS;
+    s_saved_at = 0;
+    string_pool_register_root(mark_strings);
+
+    // Show what the phone sent last time right away; the request made on
+    // load replaces it. Version 0 stays, stubs can't be patched.
+    LastResult last;
+    if (storage_get_last_result(connection, &last)) {
+        s_num_connections = last_result_restore(&last, time(NULL), s_connections);
+        if (s_num_connections > 0) {
+            s_first_stub = 0;
+            s_saved_at = last.received_at;
+            build_rows();
+        }
+    }
 
     if (!s_window) {
         s_window = window_create();
         window_set_window_handlers(s_window, (WindowHandlers) {
             .load = window_load,
+            .appear = window_appear,
+            .disappear = window_disappear,
             .unload = window_unload,
         });
     }
-    APP_LOG(APP_LOG_LEVEL_INFO, "Pushing connection detail window");
+    LOG_INFO("Pushing connection detail window");
     window_stack_push(s_window, true);
 }
 
-void connection_detail_window_update_data(Connection *connections, int count) {
-    APP_LOG(APP_LOG_LEVEL_INFO, "Connection detail update: received %d connections", count);
-    s_num_connections = count;
-    if (count > 5) s_num_connections = 5;
+void connection_detail_window_set_connection(int index, const Connection *connection) {
+    if (index < 0 || index >= MAX_CONNECTION_RESULTS) {
+        return;
+    }
+    s_connections[index] = *connection;
+    LOG_INFO("Connection %d: dep=%d arr=%d", index,
+            (int)connection->departure_time, (int)connection->arrival_time);
+}
 
-    for (int i = 0; i < s_num_connections; i++) {
-        s_connections[i] = connections[i];
-        APP_LOG(APP_LOG_LEVEL_INFO, "Connection %d: dep=%d arr=%d", i,
-                (int)connections[i].departure_time, (int)connections[i].arrival_time);
+void connection_detail_window_set_version(uint8_t version) {
+    s_result_version = version;
+}
+
+uint8_t connection_detail_window_get_version(void) {
+    return s_result_version;
+}
+
+// Patch entries arrive with moves up before moves down, and new departures
+// last, so each copy lands in a slot whose old content is no longer needed
+void connection_detail_window_apply_update(const ConnectionUpdate *update) {
+    if (update->index >= MAX_CONNECTION_RESULTS || update->from >= MAX_CONNECTION_RESULTS) {
+        return;
+    }
+    Connection *conn = &s_connections[update->index];
+    if (update->from != update->index) {
+        *conn = s_connections[update->from];
+    }
+    conn->total_delay_minutes = update->total_delay_minutes;
+    if (update->num_sections == conn->num_sections) {
+        for (int i = 0; i < update->num_sections; i++) {
+            conn->sections[i].delay_minutes = update->sections[i].delay_minutes;
+            strncpy(conn->sections[i].platform, update->sections[i].platform, MAX_PLATFORM_LENGTH - 1);
+            conn->sections[i].platform[MAX_PLATFORM_LENGTH - 1] = '\0';
+        }
     }
+}
 
-    APP_LOG(APP_LOG_LEVEL_INFO, "Reloading menu layer with %d connections", s_num_connections);
-    menu_layer_reload_data(s_menu_layer);
+// A complete, fresh set replaces the restored one and is kept for next time
+static void result_complete(void) {
+    s_first_stub = MAX_CONNECTION_RESULTS;
+    s_saved_at = 0;
+    LastResult last;
+    last_result_build(&last, &s_connection, s_connections, s_num_connections, time(NULL));
+    storage_set_last_result(&last);
+}
+
+void connection_detail_window_finish_patch(uint8_t version, int total, bool changed) {
+    LOG_INFO("Connection patch applied: version %d, %d connections", version, total);
+    trace(TRACE_PATCH_APPLIED, version, total);
+    s_result_version = version;
+    s_num_connections = total > MAX_CONNECTION_RESULTS ? MAX_CONNECTION_RESULTS : total;
+    if (changed) {
+        build_rows();
+    }
+    result_complete();
+
+    if (!s_menu_layer) {
+        return;
+    }
+    if (changed) {
+        menu_layer_reload_data(s_menu_layer);
+    }
     text_layer_set_text(s_status_layer, "Updated");
+    refresh_scheduler_succeeded(&s_refresh, next_departure());
+}
+
+static void update_data(int count, int total) {
+    LOG_INFO("Connection detail update: %d of %d connections", count, total);
+
+    // A refresh starts over at index 0; keep the rows already on screen until
+    // the rest of the new result set arrives so the selection doesn't jump
+    int shown = count;
+    if (shown < s_num_connections && total >= s_num_connections) {
+        shown = s_num_connections;
+    }
+    if (shown > total) shown = total;
+    if (shown > MAX_CONNECTION_RESULTS) shown = MAX_CONNECTION_RESULTS;
+    s_num_connections = shown;
+    if (count >= total) {
+        result_complete();
+    } else if (s_first_stub < count) {
+        s_first_stub = count;
+    }
+    build_rows();
+    trace(TRACE_CONNECTIONS_SHOWN, shown, total);
+
+    if (!s_menu_layer) {
+        return;  // Window was closed while the request was in flight
+    }
+
+    LOG_INFO("Reloading menu layer with %d connections", s_num_connections);
+    menu_layer_reload_data(s_menu_layer);
+    set_status(count < total ? "Loading more..." : "Updated");
+    if (count >= total) {
+        refresh_scheduler_succeeded(&s_refresh, next_departure());
+    }
+}
+
+void connection_detail_window_request_failed(void) {
+    if (s_menu_layer) {
+        refresh_scheduler_failed(&s_refresh);
+    }
+}
+
+void connection_detail_window_receive_batch(uint8_t version, int first_index, int count, int total) {
+    // A set starts over at index 0; if its first message was lost, the next
+    // one still carries a version other than the set before
+    if (first_index == 0 || version != s_batch_version) {
+        s_batch_version = version;
+        s_batch_received = 0;
+    }
+    if (first_index <= s_batch_received && first_index + count > s_batch_received) {
+        s_batch_received = first_index + count;
+    }
+
+    // A patch against a set with missing rows would leave them out
+    s_result_version = s_batch_received >= total ? version : 0;
+    update_data(s_batch_received, total);
 }
@@ -2,5 +2,18 @@
 #include <pebble.h>
 #include "data_models.h"
 
-void connection_detail_window_push(SavedConnection *connection);
-void connection_detail_window_update_data(Connection *connections, int count);
+void connection_detail_window_push(const SavedConnection *connection);
+void connection_detail_window_set_connection(int index, const Connection *connection);
+// Rows first_index .. first_index + count - 1 of a result set were stored
+// with set_connection. The set's version is only kept once every row of it
+// arrived; until then the phone is asked for the whole set again.
+void connection_detail_window_receive_batch(uint8_t version, int first_index, int count, int total);
+
+// Delta refresh: the phone patches the set it sent last (see app_message.c)
+void connection_detail_window_set_version(uint8_t version);
+uint8_t connection_detail_window_get_version(void);
+void connection_detail_window_apply_update(const ConnectionUpdate *update);
+void connection_detail_window_finish_patch(uint8_t version, int total, bool changed);
+
+// The phone reported an error; backs off the next refresh
+void connection_detail_window_request_failed(void);
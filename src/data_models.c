@@ -63,3 +63,11 @@ FavoriteDestination create_favorite_destination(
 
     return favorite;
 }
+
+// Root marker helper: keeps the interned station names of a connection alive
+void connection_mark_strings(const Connection *connection) {
+    for (int i = 0; i < connection->num_sections && i < 5; i++) {
+        string_pool_mark(connection->sections[i].departure_station);
+        string_pool_mark(connection->sections[i].arrival_station);
+    }
+}
@@ -2,6 +2,7 @@
 #ifndef PEBBLE_H
 #include <pebble.h>
 #endif
+#include "string_pool.h"
 
 #define MAX_STATION_NAME_LENGTH 32
 #define MAX_STATION_ID_LENGTH 16
@@ -9,6 +10,8 @@
 #define MAX_PLATFORM_LENGTH 8
 #define MAX_SAVED_CONNECTIONS 10
 #define MAX_FAVORITE_STATIONS 20
+#define MAX_CONNECTION_RESULTS 5
+#define MAX_NEARBY_STATIONS 10
 
 // Station structure
 typedef struct {
@@ -26,6 +29,14 @@ typedef struct {
 
 #define MAX_FAVORITE_DESTINATIONS 10
 
+// Identifies the favorites list the phone last sent: a version it bumps on
+// every change and a hash it computed over the list. Both are 0 for a list
+// that was never synced.
+typedef struct {
+    uint16_t version;
+    int32_t hash;
+} FavoritesSync;
+
 // Saved connection structure
 typedef struct {
     char departure_station_id[MAX_STATION_ID_LENGTH];
@@ -36,8 +47,8 @@ typedef struct {
 
 // Journey section (leg) structure
 typedef struct {
-    char departure_station[MAX_STATION_NAME_LENGTH];
-    char arrival_station[MAX_STATION_NAME_LENGTH];
+    StringRef departure_station;  // Interned, see string_pool.h
+    StringRef arrival_station;
     time_t departure_time;
     time_t arrival_time;
     char platform[MAX_PLATFORM_LENGTH];
@@ -55,7 +66,25 @@ typedef struct {
     int num_changes;
 } Connection;
 
+// Refresh patch entries (see CONNECTION_PATCH in protocol/messages.json)
+#define CONNECTION_UPDATE_ADDED 0xFF  // "from" of a departure not in the previous set
+
+typedef struct {
+    int delay_minutes;
+    char platform[MAX_PLATFORM_LENGTH];
+} SectionUpdate;
+
+typedef struct {
+    uint8_t index;        // Position in the new result set
+    uint8_t from;         // Position in the previous set, or CONNECTION_UPDATE_ADDED
+    int total_delay_minutes;
+    SectionUpdate sections[5];  // Empty when the sections are unchanged
+    int num_sections;
+} ConnectionUpdate;
+
 // Function declarations
+void connection_mark_strings(const Connection *connection);
+
 SavedConnection create_saved_connection(
     const char *dep_id, const char *dep_name,
     const char *arr_id, const char *arr_name
@@ -0,0 +1,80 @@
+#include "favorites_sync.h"
+#include "log.h"
+#include "storage.h"
+
+static FavoriteDestination s_favorites[MAX_FAVORITE_DESTINATIONS];
+static FavoritesDelta s_delta;
+static int s_received = 0;
+static int s_next_index = 0;
+static bool s_open = false;
+
+static FavoritesSyncResult commit(void) {
+    storage_set_favorite_destinations(s_favorites, s_delta.count, &s_delta.sync);
+    storage_flush();
+    s_open = false;
+    LOG_INFO("Favorites now at version %d (%d entries, %d changed)",
+             s_delta.sync.version, s_delta.count, s_delta.changes);
+    return FAVORITES_SYNC_COMMITTED;
+}
+
+bool favorites_sync_is_current(const FavoritesSync *phone) {
+    FavoritesSync stored = storage_get_favorites_sync();
+    return stored.hash != 0 && stored.hash == phone->hash && stored.version == phone->version;
+}
+
+FavoritesSyncResult favorites_sync_begin(const FavoritesDelta *delta) {
+    s_open = false;
+    if (delta->has_base && delta->base_hash != storage_get_favorites_sync().hash) {
+        LOG_WARNING("Favorites delta against an old list, need the full list");
+        return FAVORITES_SYNC_REJECTED;
+    }
+
+    s_delta = *delta;
+    if (s_delta.count > MAX_FAVORITE_DESTINATIONS) {
+        s_delta.count = MAX_FAVORITE_DESTINATIONS;
+    }
+    if (s_delta.changes > s_delta.count) {
+        s_delta.changes = s_delta.count;
+    }
+
+    // Unchanged entries keep their place; entries past the old end are
+    // among the changes
+    memset(s_favorites, 0, sizeof(s_favorites));
+    if (s_delta.has_base) {
+        FavoriteDestination stored[MAX_FAVORITE_DESTINATIONS];
+        int stored_count = storage_get_favorite_destinations(stored);
+        int kept = stored_count < s_delta.count ? stored_count : s_delta.count;
+        memcpy(s_favorites, stored, sizeof(FavoriteDestination) * kept);
+    }
+
+    s_received = 0;
+    s_next_index = 0;
+    s_open = true;
+    if (s_delta.changes == 0) {
+        return commit();
+    }
+    return FAVORITES_SYNC_WAITING;
+}
+
+FavoritesSyncResult favorites_sync_receive(int index, const FavoriteDestination *favorite) {
+    if (index < 0) {
+        index = s_next_index;
+    }
+    if (!s_open || index >= s_delta.count) {
+        return FAVORITES_SYNC_REJECTED;
+    }
+
+    s_favorites[index] = *favorite;
+    s_next_index = index + 1;
+    LOG_INFO("Received favorite %d: %s - %s", index, favorite->label, favorite->name);
+
+    // Write the list once, after the whole delta arrived
+    if (++s_received == s_delta.changes) {
+        return commit();
+    }
+    return FAVORITES_SYNC_WAITING;
+}
+
+void favorites_sync_reset(void) {
+    s_open = false;
+}
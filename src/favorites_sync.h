@@ -0,0 +1,35 @@
+#pragma once
+#ifndef PEBBLE_H
+#include <pebble.h>
+#endif
+#include "data_models.h"
+
+// Applies favorites the phone sends as a delta against the stored list.
+// The phone keeps the stamp (FavoritesSync) of the list it last sent; a
+// delta names the hash it was made against and carries only the entries
+// that differ, so an unchanged list costs no messages and no flash writes.
+
+typedef struct {
+    uint8_t count;        // Entries in the new list
+    uint8_t changes;      // Entries that follow in their own messages
+    FavoritesSync sync;   // Stamp of the new list
+    bool has_base;        // Delta against base_hash; otherwise every entry follows
+    int32_t base_hash;
+} FavoritesDelta;
+
+typedef enum {
+    FAVORITES_SYNC_WAITING,    // More entries to come
+    FAVORITES_SYNC_COMMITTED,  // The new list is stored
+    FAVORITES_SYNC_REJECTED,   // Not made against the stored list, or no delta open
+} FavoritesSyncResult;
+
+// True if the phone's copy (its stamp) matches the stored list
+bool favorites_sync_is_current(const FavoritesSync *phone);
+
+FavoritesSyncResult favorites_sync_begin(const FavoritesDelta *delta);
+
+// index < 0 places the entry after the previous one (phones that send the
+// full list without indices)
+FavoritesSyncResult favorites_sync_receive(int index, const FavoriteDestination *favorite);
+
+void favorites_sync_reset(void);
@@ -0,0 +1,145 @@
+#include "last_result.h"
+#include "log.h"
+#include "persistence.h"
+
+#define LAST_RESULTS_VERSION 1
+
+static void copy_text(char *buffer, size_t size, const char *text) {
+    strncpy(buffer, text, size - 1);
+    buffer[size - 1] = '\0';
+}
+
+void last_result_build(LastResult *result, const SavedConnection *route,
+                       const Connection *connections, int count, time_t now) {
+    memset(result, 0, sizeof(LastResult));
+    copy_text(result->departure_station_id, sizeof(result->departure_station_id),
+              route->departure_station_id);
+    copy_text(result->arrival_station_id, sizeof(result->arrival_station_id),
+              route->arrival_station_id);
+    result->received_at = now;
+    result->count = count > MAX_CONNECTION_RESULTS ? MAX_CONNECTION_RESULTS : (count < 0 ? 0 : count);
+
+    for (int i = 0; i < result->count; i++) {
+        const Connection *conn = &connections[i];
+        LastResultRow *row = &result->rows[i];
+        row->departure_time = conn->departure_time;
+        row->arrival_time = conn->arrival_time;
+        row->total_delay_minutes = conn->total_delay_minutes;
+        row->num_changes = conn->num_changes;
+        if (conn->num_sections > 0) {
+            row->delay_minutes = conn->sections[0].delay_minutes;
+            copy_text(row->platform, sizeof(row->platform), conn->sections[0].platform);
+            copy_text(row->train_type, sizeof(row->train_type), conn->sections[0].train_type);
+        }
+    }
+}
+
+bool last_result_matches(const LastResult *result, const char *departure_station_id,
+                         const char *arrival_station_id) {
+    return strcmp(result->departure_station_id, departure_station_id) == 0 &&
+           strcmp(result->arrival_station_id, arrival_station_id) == 0;
+}
+
+int last_result_restore(const LastResult *result, time_t now, Connection *connections) {
+    int restored = 0;
+    for (int i = 0; i < result->count && i < MAX_CONNECTION_RESULTS; i++) {
+        const LastResultRow *row = &result->rows[i];
+        if (row->departure_time + row->delay_minutes * 60 < now) {
+            continue;  // Already gone
+        }
+
+        Connection *conn = &connections[restored++];
+        memset(conn, 0, sizeof(Connection));
+        conn->departure_time = row->departure_time;
+        conn->arrival_time = row->arrival_time;
+        conn->total_delay_minutes = row->total_delay_minutes;
+        conn->num_changes = row->num_changes;
+
+        // Enough of the first leg for row_model_build_connection
+        JourneySection *first = &conn->sections[0];
+        conn->num_sections = 1;
+        first->departure_station = STRING_REF_NONE;
+        first->arrival_station = STRING_REF_NONE;
+        first->departure_time = row->departure_time;
+        first->arrival_time = row->arrival_time;
+        first->delay_minutes = row->delay_minutes;
+        copy_text(first->platform, sizeof(first->platform), row->platform);
+        copy_text(first->train_type, sizeof(first->train_type), row->train_type);
+    }
+    return restored;
+}
+
+void save_last_results(const LastResult *results, int count) {
+    if (count > LAST_RESULT_ROUTES) {
+        count = LAST_RESULT_ROUTES;
+    }
+
+    PersistRecord record;
+    persist_record_begin_write(&record, PERSIST_RECORD_LAST_RESULTS, LAST_RESULTS_VERSION);
+    persist_record_write_u8(&record, count);
+    for (int i = 0; i < count; i++) {
+        const LastResult *result = &results[i];
+        persist_record_write_string(&record, result->departure_station_id);
+        persist_record_write_string(&record, result->arrival_station_id);
+        persist_record_write_i32(&record, result->received_at);
+        persist_record_write_u8(&record, result->count);
+        for (int j = 0; j < result->count; j++) {
+            const LastResultRow *row = &result->rows[j];
+            persist_record_write_i32(&record, row->departure_time);
+            persist_record_write_i32(&record, row->arrival_time);
+            persist_record_write_i16(&record, row->total_delay_minutes);
+            persist_record_write_i16(&record, row->delay_minutes);
+            persist_record_write_u8(&record, row->num_changes);
+            persist_record_write_string(&record, row->platform);
+            persist_record_write_string(&record, row->train_type);
+        }
+    }
+    persist_record_end_write(&record);
+    LOG_INFO("Saved last results for %d routes", count);
+}
+
+int load_last_results(LastResult *results) {
+    PersistRecord record;
+    if (!persist_record_begin_read(&record, PERSIST_RECORD_LAST_RESULTS)) {
+        return 0;
+    }
+    if (record.version != LAST_RESULTS_VERSION) {
+        LOG_WARNING("Unknown last results version %d", record.version);
+        return 0;
+    }
+
+    int count = persist_record_read_u8(&record);
+    if (count > LAST_RESULT_ROUTES) {
+        count = LAST_RESULT_ROUTES;
+    }
+    for (int i = 0; i < count; i++) {
+        LastResult *result = &results[i];
+        memset(result, 0, sizeof(LastResult));
+        persist_record_read_string(&record, result->departure_station_id,
+                                   sizeof(result->departure_station_id));
+        persist_record_read_string(&record, result->arrival_station_id,
+                                   sizeof(result->arrival_station_id));
+        result->received_at = persist_record_read_i32(&record);
+        result->count = persist_record_read_u8(&record);
+        if (result->count > MAX_CONNECTION_RESULTS) {
+            result->count = MAX_CONNECTION_RESULTS;
+        }
+        for (int j = 0; j < result->count; j++) {
+            LastResultRow *row = &result->rows[j];
+            row->departure_time = persist_record_read_i32(&record);
+            row->arrival_time = persist_record_read_i32(&record);
+            row->total_delay_minutes = persist_record_read_i16(&record);
+            row->delay_minutes = persist_record_read_i16(&record);
+            row->num_changes = persist_record_read_u8(&record);
+            persist_record_read_string(&record, row->platform, sizeof(row->platform));
+            persist_record_read_string(&record, row->train_type, sizeof(row->train_type));
+        }
+    }
+
+    if (!persist_record_end_read(&record)) {
+        LOG_WARNING("Dropping damaged last results");
+        return 0;
+    }
+    LOG_INFO("Loaded last results for %d routes", count);
+    return count;
+}
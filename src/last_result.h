@@ -0,0 +1,46 @@
+#pragma once
+#ifndef PEBBLE_H
+#include <pebble.h>
+#endif
+#include "data_models.h"
+
+// Last connection set received for recently opened routes, kept so the
+// detail window can show it at once while the phone is asked for a fresh
+// one. Only what a connection row draws is stored; legs, station names and
+// later delays need the phone.
+
+// Most recently opened first. Not one per saved route (MAX_SAVED_CONNECTIONS):
+// ten sets take 2.4 KB of RAM and, at up to 220 bytes each, can outgrow the
+// 8 chunks of a record. Routes opened recently are the ones opened again.
+#define LAST_RESULT_ROUTES 4
+
+typedef struct {
+    time_t departure_time;
+    time_t arrival_time;
+    int16_t total_delay_minutes;
+    int16_t delay_minutes;  // First leg
+    uint8_t num_changes;
+    char platform[MAX_PLATFORM_LENGTH];      // First leg
+    char train_type[MAX_TRAIN_TYPE_LENGTH];  // First leg
+} LastResultRow;
+
+typedef struct {
+    char departure_station_id[MAX_STATION_ID_LENGTH];
+    char arrival_station_id[MAX_STATION_ID_LENGTH];
+    time_t received_at;
+    uint8_t count;
+    LastResultRow rows[MAX_CONNECTION_RESULTS];
+} LastResult;
+
+void last_result_build(LastResult *result, const SavedConnection *route,
+                       const Connection *connections, int count, time_t now);
+bool last_result_matches(const LastResult *result, const char *departure_station_id,
+                         const char *arrival_station_id);
+
+// Rows whose departure, delay included, is not yet past at `now`, as
+// one-section connections without station names; returns how many
+int last_result_restore(const LastResult *result, time_t now, Connection *connections);
+
+// Persistence
+void save_last_results(const LastResult *results, int count);
+int load_last_results(LastResult *results);
@@ -0,0 +1,51 @@
+#include "latency.h"
+
+static uint16_t s_buckets[LATENCY_STAGE_COUNT][LATENCY_BUCKETS];
+static uint16_t s_counts[LATENCY_STAGE_COUNT];
+
+static int bucket_for(uint32_t ms) {
+    for (int i = 0; i < LATENCY_BUCKETS - 1; i++) {
+        if (ms < (uint32_t)LATENCY_BUCKET_BASE_MS << i) {
+            return i;
+        }
+    }
+    return LATENCY_BUCKETS - 1;
+}
+
+void latency_record(LatencyStage stage, uint32_t ms) {
+    uint16_t *buckets = s_buckets[stage];
+    if (s_counts[stage] >= LATENCY_WINDOW) {
+        s_counts[stage] = 0;
+        for (int i = 0; i < LATENCY_BUCKETS; i++) {
+            buckets[i] /= 2;
+            s_counts[stage] += buckets[i];
+        }
+    }
+    buckets[bucket_for(ms)]++;
+    s_counts[stage]++;
+}
+
+int latency_count(LatencyStage stage) {
+    return s_counts[stage];
+}
+
+uint32_t latency_percentile(LatencyStage stage, int percent) {
+    if (s_counts[stage] == 0) {
+        return 0;
+    }
+    // Smallest bucket that covers at least percent of the samples
+    int needed = (s_counts[stage] * percent + 99) / 100;
+    int seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += s_buckets[stage][i];
+        if (seen >= needed && seen > 0) {
+            return (uint32_t)LATENCY_BUCKET_BASE_MS << i;
+        }
+    }
+    return (uint32_t)LATENCY_BUCKET_BASE_MS << (LATENCY_BUCKETS - 1);
+}
+
+void latency_reset(void) {
+    memset(s_buckets, 0, sizeof(s_buckets));
+    memset(s_counts, 0, sizeof(s_counts));
+}
@@ -0,0 +1,34 @@
+#pragma once
+#ifndef PEBBLE_H
+#include <pebble.h>
+#endif
+
+// Rolling latency histograms for connection requests, one per stage. The
+// phone echoes its own stage timings with the first response message (see
+// REQUEST_TIMING in protocol/messages.json); the watch derives the rest
+// from the timestamp it sent with the request.
+
+typedef enum {
+    LATENCY_TOTAL,      // Request written to the outbox until the first response
+    LATENCY_BLUETOOTH,  // Total minus the time spent on the phone
+    LATENCY_PHONE,      // On the phone, outside fetch and parse
+    LATENCY_FETCH,      // API request until the response headers arrived
+    LATENCY_PARSE,      // Reading and parsing the JSON body
+    LATENCY_STAGE_COUNT
+} LatencyStage;
+
+// Bucket i counts samples below LATENCY_BUCKET_BASE_MS << i; the last
+// bucket takes everything slower
+#define LATENCY_BUCKETS 12
+#define LATENCY_BUCKET_BASE_MS 16
+
+// Once a stage holds this many samples every bucket is halved, so older
+// requests fade out and the histogram follows the recent ones
+#define LATENCY_WINDOW 64
+
+void latency_record(LatencyStage stage, uint32_t ms);
+int latency_count(LatencyStage stage);
+// Upper bound in ms of the bucket holding the given percentile, or 0 when
+// the stage has no samples
+uint32_t latency_percentile(LatencyStage stage, int percent);
+void latency_reset(void);
@@ -0,0 +1,33 @@
+#pragma once
+#ifndef PEBBLE_H
+#include <pebble.h>
+#endif
+
+// Logging facade over APP_LOG. Calls above LOG_LEVEL are compiled out, so
+// release builds (RELEASE=1 pebble build, see wscript) neither format nor
+// send them. Arguments stay type-checked in every build.
+//
+// For timing-sensitive paths use trace() from trace.h instead: it records a
+// binary event without formatting anything.
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#ifdef RELEASE
+#define LOG_LEVEL LOG_LEVEL_WARNING
+#else
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+#define LOG_AT(enabled, level, ...) \
+    do { if (enabled) { APP_LOG(level, __VA_ARGS__); } } while (0)
+
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL >= LOG_LEVEL_ERROR, APP_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(LOG_LEVEL >= LOG_LEVEL_WARNING, APP_LOG_LEVEL_WARNING, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL >= LOG_LEVEL_INFO, APP_LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL >= LOG_LEVEL_DEBUG, APP_LOG_LEVEL_DEBUG, __VA_ARGS__)
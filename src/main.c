@@ -1,15 +1,34 @@
 #include <pebble.h>
 #include "main_window.h"
 #include "app_message.h"
+#include "storage.h"
+#include "trace.h"
+#include "pin_worker.h"
+#include "connection_detail_window.h"
 
 static void init(void) {
+    trace(TRACE_APP_START, launch_reason(), 0);
     app_message_init();
     main_window_push();
+
+    // The pin worker woke us shortly before departure: go straight to live
+    // departures for the pinned route so delays and platforms are fresh
+    if (launch_reason() == APP_LAUNCH_WORKER) {
+        PinnedConnection pinned = storage_get_pinned_connection();
+        if (pinned.is_active) {
+            vibes_short_pulse();
+            connection_detail_window_push(&pinned.route);
+        }
+    }
 }
 
 static void deinit(void) {
     main_window_pop();
     app_message_deinit();
+    storage_flush();
+
+    PinnedConnection pinned = storage_get_pinned_connection();
+    pin_worker_sync(&pinned);
 }
 
 int main(void) {
@@ -1,16 +1,17 @@
 #include "main_window.h"
+#include "log.h"
 #include "data_models.h"
-#include "persistence.h"
 #include "add_connection_window.h"
 #include "connection_detail_window.h"
 #include "quick_route_window.h"
 #include "station_select_window.h"
 #include "pinned_connection.h"
+#include "storage.h"
 #include "journey_detail_window.h"
 
 static Window *s_window;
 static MenuLayer *s_menu_layer;
-static SavedConnection s_connections[MAX_SAVED_CONNECTIONS];
+static const SavedConnection *s_connections;
 static int s_num_connections = 0;
 static PinnedConnection s_pinned_connection;
 static bool s_has_pinned = false;
@@ -77,7 +78,7 @@ static void menu_draw_row_callback(GContext* ctx, const Layer *cell_layer, MenuI
     if (s_num_connections == 0) {
         menu_cell_basic_draw(ctx, cell_layer, "Add Connection", "Long-press UP", NULL);
     } else {
-        SavedConnection *conn = &s_connections[cell_index->row];
+        const SavedConnection *conn = &s_connections[cell_index->row];
         static char title[64];
         snprintf(title, sizeof(title), "%s → %s",
                  conn->departure_station_name,
@@ -98,13 +99,13 @@ static void menu_select_callback(MenuLayer *menu_layer, MenuIndex *cell_index, v
         add_connection_window_push();
         return;
     }
-    SavedConnection *conn = &s_connections[cell_index->row];
+    const SavedConnection *conn = &s_connections[cell_index->row];
     connection_detail_window_push(conn);
 }
 
 // Quick route functions
 static void quick_route_selected_callback(Station *departure, FavoriteDestination *destination) {
-    APP_LOG(APP_LOG_LEVEL_INFO, "Quick route: %s to %s",
+    LOG_INFO("Quick route: %s to %s",
             departure->name, destination->label);
 
     // Create temporary saved connection for display
@@ -120,9 +121,9 @@ static void quick_route_selected_callback(Station *departure, FavoriteDestinatio
 }
 
 static void quick_route_departure_selected(Station *station) {
-    APP_LOG(APP_LOG_LEVEL_INFO, "Departure selected: %s", station->name);
+    LOG_INFO("Departure selected: %s", station->name);
     quick_route_window_push(station, quick_route_selected_callback);
-    APP_LOG(APP_LOG_LEVEL_INFO, "Quick route window pushed");
+    LOG_INFO("Quick route window pushed");
 }
 
 static void start_quick_route(void) {
@@ -138,21 +139,28 @@ static void click_config_provider(void *context) {
     window_long_click_subscribe(BUTTON_ID_UP, 700, up_long_click_handler, NULL);
 }
 
+static void mark_strings(void) {
+    if (s_has_pinned) {
+        connection_mark_strings(&s_pinned_connection.connection);
+    }
+}
+
 // Window lifecycle
 static void window_load(Window *window) {
     Layer *window_layer = window_get_root_layer(window);
     GRect bounds = layer_get_bounds(window_layer);
 
     // Load and check pinned connection
-    s_pinned_connection = load_pinned_connection();
+    s_pinned_connection = storage_get_pinned_connection();
 
     if (s_pinned_connection.is_active && is_pinned_connection_expired(&s_pinned_connection)) {
-        clear_pinned_connection();
+        storage_clear_pinned_connection();
         s_pinned_connection.is_active = false;
     }
 
     s_has_pinned = s_pinned_connection.is_active;
-    APP_LOG(APP_LOG_LEVEL_INFO, "Main window: has_pinned=%d", s_has_pinned);
+    string_pool_register_root(mark_strings);
+    LOG_INFO("Main window: has_pinned=%d", s_has_pinned);
 
     s_menu_layer = menu_layer_create(bounds);
     menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks){
@@ -170,11 +178,13 @@ static void window_load(Window *window) {
     window_set_click_config_provider(s_window, click_config_provider);
 
     // Load saved connections
-    s_num_connections = load_connections(s_connections);
+    s_connections = storage_get_connections(&s_num_connections);
 }
 
 static void window_unload(Window *window) {
+    string_pool_unregister_root(mark_strings);
     menu_layer_destroy(s_menu_layer);
+    storage_flush();
 }
 
 void main_window_push(void) {
@@ -193,6 +203,6 @@ void main_window_pop(void) {
 }
 
 void main_window_refresh(void) {
-    s_num_connections = load_connections(s_connections);
+    s_connections = storage_get_connections(&s_num_connections);
     menu_layer_reload_data(s_menu_layer);
 }
@@ -0,0 +1,86 @@
+#include "marquee.h"
+
+// Station names are UTF-8; count and skip whole characters, not bytes
+static int utf8_length(const char *text) {
+    int length = 0;
+    for (; *text; text++) {
+        if ((*text & 0xC0) != 0x80) {
+            length++;
+        }
+    }
+    return length;
+}
+
+static const char *utf8_skip(const char *text, int chars) {
+    while (*text && chars > 0) {
+        text++;
+        while ((*text & 0xC0) == 0x80) {
+            text++;
+        }
+        chars--;
+    }
+    return text;
+}
+
+static void step_callback(void *data) {
+    Marquee *marquee = data;
+    marquee->timer = NULL;
+
+    // Nothing to scroll, or the last redraw, one step past the end, showed
+    // the text from the start again: done
+    if (marquee->overflow <= 0 || marquee->offset > marquee->overflow) {
+        return;
+    }
+
+    marquee->offset++;
+    marquee->overflow = 0;  // Measured again by the redraw
+    layer_mark_dirty(menu_layer_get_layer(marquee->menu_layer));
+    marquee->timer = app_timer_register(MARQUEE_STEP_MS, step_callback, marquee);
+}
+
+void marquee_init(Marquee *marquee, MenuLayer *menu_layer) {
+    marquee->menu_layer = menu_layer;
+    marquee->timer = NULL;
+    marquee->offset = 0;
+    marquee->overflow = 0;
+}
+
+void marquee_deinit(Marquee *marquee) {
+    marquee_pause(marquee);
+    marquee->menu_layer = NULL;
+}
+
+void marquee_restart(Marquee *marquee) {
+    marquee_pause(marquee);
+    if (marquee->offset > 0) {
+        // Show the text from the start while waiting
+        layer_mark_dirty(menu_layer_get_layer(marquee->menu_layer));
+    }
+    marquee->offset = 0;
+    marquee->overflow = 0;
+    marquee->timer = app_timer_register(MARQUEE_WAIT_MS, step_callback, marquee);
+}
+
+void marquee_pause(Marquee *marquee) {
+    if (marquee->timer) {
+        app_timer_cancel(marquee->timer);
+        marquee->timer = NULL;
+    }
+}
+
+const char *marquee_text(Marquee *marquee, const MenuIndex *cell_index,
+                         const char *text, int chars_visible) {
+    MenuIndex selected = menu_layer_get_selected_index(marquee->menu_layer);
+    if (cell_index->section != selected.section || cell_index->row != selected.row) {
+        return text;
+    }
+
+    int overflow = utf8_length(text) - chars_visible;
+    if (overflow > marquee->overflow) {
+        marquee->overflow = overflow;
+    }
+    if (marquee->offset > overflow) {
+        return text;
+    }
+    return utf8_skip(text, marquee->offset);
+}
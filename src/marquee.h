@@ -0,0 +1,33 @@
+#pragma once
+#ifndef PEBBLE_H
+#include <pebble.h>
+#endif
+
+// Scrolls the text of the selected menu cell that does not fit. Each step
+// only marks the menu layer dirty so the visible cells are redrawn; the menu
+// is never reloaded or relaid out. Scrolling stops once the longest text of
+// the selected cell has been shown to the end, and is paused while the
+// window is covered.
+
+#define MARQUEE_WAIT_MS 1000  // Pause on a new selection before scrolling
+#define MARQUEE_STEP_MS 200
+
+typedef struct {
+    MenuLayer *menu_layer;
+    AppTimer *timer;
+    int offset;     // Characters scrolled so far
+    int overflow;   // Characters the selected cell's longest text doesn't fit by
+} Marquee;
+
+void marquee_init(Marquee *marquee, MenuLayer *menu_layer);
+void marquee_deinit(Marquee *marquee);
+
+// From the selection_changed callback and the window's appear handler
+void marquee_restart(Marquee *marquee);
+// From the window's disappear handler
+void marquee_pause(Marquee *marquee);
+
+// From draw_row: returns the part of text to draw in this cell. Only the
+// selected cell scrolls; everything else gets text back unchanged.
+const char *marquee_text(Marquee *marquee, const MenuIndex *cell_index,
+                         const char *text, int chars_visible);
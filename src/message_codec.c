@@ -0,0 +1,229 @@
+// Generated by tools/gen_codec.js from protocol/messages.json - do not edit.
+#include "message_codec.h"
+#include "string_pool.h"
+#include <string.h>
+
+typedef struct {
+    const uint8_t *pos;
+    const uint8_t *end;
+    bool ok;
+} CodecReader;
+
+static bool reader_has(CodecReader *reader, size_t count) {
+    if (!reader->ok || (size_t)(reader->end - reader->pos) < count) {
+        reader->ok = false;
+        return false;
+    }
+    return true;
+}
+
+static uint8_t read_u8(CodecReader *reader) {
+    if (!reader_has(reader, 1)) {
+        return 0;
+    }
+    return *reader->pos++;
+}
+
+static uint16_t read_u16(CodecReader *reader) {
+    if (!reader_has(reader, 2)) {
+        return 0;
+    }
+    uint16_t value = (uint16_t)(reader->pos[0] | (reader->pos[1] << 8));
+    reader->pos += 2;
+    return value;
+}
+
+static uint32_t read_u32(CodecReader *reader) {
+    if (!reader_has(reader, 4)) {
+        return 0;
+    }
+    uint32_t value = (uint32_t)reader->pos[0] |
+                     ((uint32_t)reader->pos[1] << 8) |
+                     ((uint32_t)reader->pos[2] << 16) |
+                     ((uint32_t)reader->pos[3] << 24);
+    reader->pos += 4;
+    return value;
+}
+
+// Strings are a length byte followed by UTF-8 without terminator
+static void read_string(CodecReader *reader, char *dest, size_t dest_size) {
+    uint8_t length = read_u8(reader);
+    if (!reader_has(reader, length)) {
+        dest[0] = '\0';
+        return;
+    }
+    size_t copy = length < dest_size ? length : dest_size - 1;
+    memcpy(dest, reader->pos, copy);
+    dest[copy] = '\0';
+    reader->pos += length;
+}
+
+static void read_section(CodecReader *reader, JourneySection *out) {
+    {
+        char departure_station[32];
+        read_string(reader, departure_station, sizeof(departure_station));
+        out->departure_station = string_pool_intern(departure_station);
+    }
+    {
+        char arrival_station[32];
+        read_string(reader, arrival_station, sizeof(arrival_station));
+        out->arrival_station = string_pool_intern(arrival_station);
+    }
+    out->departure_time = read_u32(reader);
+    out->arrival_time = read_u32(reader);
+    read_string(reader, out->platform, sizeof(out->platform));
+    read_string(reader, out->train_type, sizeof(out->train_type));
+    out->delay_minutes = (int16_t)read_u16(reader);
+}
+
+static void read_connection(CodecReader *reader, Connection *out) {
+    out->departure_time = read_u32(reader);
+    out->arrival_time = read_u32(reader);
+    out->total_delay_minutes = (int16_t)read_u16(reader);
+    out->num_changes = read_u8(reader);
+    uint8_t num_sections = read_u8(reader);
+    if (num_sections > sizeof(out->sections) / sizeof(out->sections[0])) {
+        reader->ok = false;
+        return;
+    }
+    out->num_sections = num_sections;
+    for (int i = 0; i < num_sections && reader->ok; i++) {
+        read_section(reader, &out->sections[i]);
+    }
+}
+
+static void read_connection_batch(CodecReader *reader, ConnectionBatch *out) {
+    out->first_index = read_u8(reader);
+    out->total = read_u8(reader);
+    out->version = read_u8(reader);
+    out->count = read_u8(reader);
+    if (out->count > 5) {
+        reader->ok = false;
+    }
+}
+
+static void read_section_update(CodecReader *reader, SectionUpdate *out) {
+    out->delay_minutes = (int16_t)read_u16(reader);
+    read_string(reader, out->platform, sizeof(out->platform));
+}
+
+static void read_connection_update(CodecReader *reader, ConnectionUpdate *out) {
+    out->index = read_u8(reader);
+    out->from = read_u8(reader);
+    out->total_delay_minutes = (int16_t)read_u16(reader);
+    uint8_t num_sections = read_u8(reader);
+    if (num_sections > sizeof(out->sections) / sizeof(out->sections[0])) {
+        reader->ok = false;
+        return;
+    }
+    out->num_sections = num_sections;
+    for (int i = 0; i < num_sections && reader->ok; i++) {
+        read_section_update(reader, &out->sections[i]);
+    }
+}
+
+static void read_connection_patch(CodecReader *reader, ConnectionPatch *out) {
+    out->base_version = read_u8(reader);
+    out->version = read_u8(reader);
+    out->total = read_u8(reader);
+    out->count = read_u8(reader);
+    if (out->count > 5) {
+        reader->ok = false;
+    }
+}
+
+static void read_station(CodecReader *reader, Station *out) {
+    read_string(reader, out->id, sizeof(out->id));
+    read_string(reader, out->name, sizeof(out->name));
+    out->distance_meters = read_u16(reader);
+}
+
+static void read_station_list(CodecReader *reader, StationList *out) {
+    out->count = read_u8(reader);
+    if (out->count > 10) {
+        reader->ok = false;
+    }
+}
+
+static void read_request_timing(CodecReader *reader, RequestTiming *out) {
+    out->request_id = read_u16(reader);
+    out->watch_time = read_u32(reader);
+    out->phone_ms = read_u16(reader);
+    out->fetch_ms = read_u16(reader);
+    out->parse_ms = read_u16(reader);
+}
+
+size_t message_codec_decode_section(const uint8_t *data, size_t length, JourneySection *out) {
+    CodecReader reader = { data, data + length, data != NULL };
+    memset(out, 0, sizeof(*out));
+    read_section(&reader, out);
+    return reader.ok ? (size_t)(reader.pos - data) : 0;
+}
+
+size_t message_codec_decode_connection(const uint8_t *data, size_t length, Connection *out) {
+    CodecReader reader = { data, data + length, data != NULL };
+    memset(out, 0, sizeof(*out));
+    read_connection(&reader, out);
+    return reader.ok ? (size_t)(reader.pos - data) : 0;
+}
+
+size_t message_codec_decode_connection_batch(const uint8_t *data, size_t length, ConnectionBatch *out) {
+    CodecReader reader = { data, data + length, data != NULL };
+    memset(out, 0, sizeof(*out));
+    if (read_u8(&reader) != MESSAGE_CODEC_VERSION) {
+        return 0;
+    }
+    read_connection_batch(&reader, out);
+    return reader.ok ? (size_t)(reader.pos - data) : 0;
+}
+
+size_t message_codec_decode_section_update(const uint8_t *data, size_t length, SectionUpdate *out) {
+    CodecReader reader = { data, data + length, data != NULL };
+    memset(out, 0, sizeof(*out));
+    read_section_update(&reader, out);
+    return reader.ok ? (size_t)(reader.pos - data) : 0;
+}
+
+size_t message_codec_decode_connection_update(const uint8_t *data, size_t length, ConnectionUpdate *out) {
+    CodecReader reader = { data, data + length, data != NULL };
+    memset(out, 0, sizeof(*out));
+    read_connection_update(&reader, out);
+    return reader.ok ? (size_t)(reader.pos - data) : 0;
+}
+
+size_t message_codec_decode_connection_patch(const uint8_t *data, size_t length, ConnectionPatch *out) {
+    CodecReader reader = { data, data + length, data != NULL };
+    memset(out, 0, sizeof(*out));
+    if (read_u8(&reader) != MESSAGE_CODEC_VERSION) {
+        return 0;
+    }
+    read_connection_patch(&reader, out);
+    return reader.ok ? (size_t)(reader.pos - data) : 0;
+}
+
+size_t message_codec_decode_station(const uint8_t *data, size_t length, Station *out) {
+    CodecReader reader = { data, data + length, data != NULL };
+    memset(out, 0, sizeof(*out));
+    read_station(&reader, out);
+    return reader.ok ? (size_t)(reader.pos - data) : 0;
+}
+
+size_t message_codec_decode_station_list(const uint8_t *data, size_t length, StationList *out) {
+    CodecReader reader = { data, data + length, data != NULL };
+    memset(out, 0, sizeof(*out));
+    if (read_u8(&reader) != MESSAGE_CODEC_VERSION) {
+        return 0;
+    }
+    read_station_list(&reader, out);
+    return reader.ok ? (size_t)(reader.pos - data) : 0;
+}
+
+size_t message_codec_decode_request_timing(const uint8_t *data, size_t length, RequestTiming *out) {
+    CodecReader reader = { data, data + length, data != NULL };
+    memset(out, 0, sizeof(*out));
+    if (read_u8(&reader) != MESSAGE_CODEC_VERSION) {
+        return 0;
+    }
+    read_request_timing(&reader, out);
+    return reader.ok ? (size_t)(reader.pos - data) : 0;
+}
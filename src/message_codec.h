@@ -0,0 +1,46 @@
+// Generated by tools/gen_codec.js from protocol/messages.json - do not edit.
+#pragma once
+#include "data_models.h"
+
+#define MESSAGE_CODEC_VERSION 4
+
+typedef struct {
+    uint8_t first_index;
+    uint8_t total;
+    uint8_t version;
+    uint8_t count;  // connection records that follow
+} ConnectionBatch;
+
+typedef struct {
+    uint8_t base_version;
+    uint8_t version;
+    uint8_t total;
+    uint8_t count;  // connection_update records that follow
+} ConnectionPatch;
+
+typedef struct {
+    uint8_t count;  // station records that follow
+} StationList;
+
+typedef struct {
+    uint16_t request_id;
+    uint32_t watch_time;
+    uint16_t phone_ms;
+    uint16_t fetch_ms;
+    uint16_t parse_ms;
+} RequestTiming;
+
+// Each decoder reads one packed record straight out of an AppMessage byte
+// array and returns the number of bytes consumed, or 0 if the payload is
+// truncated, malformed or was encoded with a different schema version.
+// Streamed lists are not decoded: the return value is the offset of the
+// first list item, which the caller decodes one at a time.
+size_t message_codec_decode_section(const uint8_t *data, size_t length, JourneySection *out);
+size_t message_codec_decode_connection(const uint8_t *data, size_t length, Connection *out);
+size_t message_codec_decode_connection_batch(const uint8_t *data, size_t length, ConnectionBatch *out);
+size_t message_codec_decode_section_update(const uint8_t *data, size_t length, SectionUpdate *out);
+size_t message_codec_decode_connection_update(const uint8_t *data, size_t length, ConnectionUpdate *out);
+size_t message_codec_decode_connection_patch(const uint8_t *data, size_t length, ConnectionPatch *out);
+size_t message_codec_decode_station(const uint8_t *data, size_t length, Station *out);
+size_t message_codec_decode_station_list(const uint8_t *data, size_t length, StationList *out);
+size_t message_codec_decode_request_timing(const uint8_t *data, size_t length, RequestTiming *out);
@@ -0,0 +1,154 @@
+#include "outbox_queue.h"
+#include "log.h"
+#include "trace.h"
+#include <string.h>
+
+typedef struct {
+    uint32_t key;
+    OutboxWriter writer;
+    OutboxFailedHandler failed;
+    uint8_t payload[OUTBOX_MAX_PAYLOAD];
+    uint8_t size;
+    uint8_t attempts;
+} OutboxEntry;
+
+// Entry 0 is the head; it is the only one ever in flight
+static OutboxEntry s_entries[OUTBOX_QUEUE_SIZE];
+static int s_count = 0;
+static bool s_in_flight = false;
+static AppTimer *s_retry_timer = NULL;
+
+static void process_queue(void);
+
+static void pop_head(void) {
+    s_count--;
+    memmove(&s_entries[0], &s_entries[1], sizeof(OutboxEntry) * s_count);
+}
+
+static void retry_timer_callback(void *data) {
+    (void)data;
+    s_retry_timer = NULL;
+    process_queue();
+}
+
+static void schedule_retry(AppMessageResult reason) {
+    OutboxEntry *head = &s_entries[0];
+    head->attempts++;
+
+    if (head->attempts > OUTBOX_MAX_RETRIES) {
+        LOG_ERROR("Outbox: dropping message key %d after %d attempts (%d)",
+                (int)head->key, head->attempts, (int)reason);
+        trace(TRACE_OUTBOX_GAVE_UP, reason, head->key);
+        OutboxEntry dropped = *head;
+        pop_head();
+        if (dropped.failed) {
+            dropped.failed(dropped.payload);
+        }
+        process_queue();
+        return;
+    }
+
+    uint32_t delay = OUTBOX_RETRY_BASE_MS << (head->attempts - 1);
+    LOG_WARNING("Outbox: retrying key %d in %d ms (%d)",
+            (int)head->key, (int)delay, (int)reason);
+    trace(TRACE_OUTBOX_RETRY, reason, head->attempts);
+    s_retry_timer = app_timer_register(delay, retry_timer_callback, NULL);
+}
+
+static void process_queue(void) {
+    if (s_count == 0 || s_in_flight || s_retry_timer) {
+        return;
+    }
+
+    DictionaryIterator *iter;
+    AppMessageResult result = app_message_outbox_begin(&iter);
+    if (result != APP_MSG_OK) {
+        schedule_retry(result);
+        return;
+    }
+
+    OutboxEntry *head = &s_entries[0];
+    head->writer(iter, head->payload);
+
+    result = app_message_outbox_send();
+    if (result != APP_MSG_OK) {
+        schedule_retry(result);
+        return;
+    }
+    s_in_flight = true;
+}
+
+bool outbox_queue_send(uint32_t key, OutboxWriter writer, OutboxFailedHandler failed,
+                       const void *payload, size_t size) {
+    if (size > OUTBOX_MAX_PAYLOAD) {
+        LOG_ERROR("Outbox: payload of %d bytes too large", (int)size);
+        return false;
+    }
+
+    OutboxEntry *entry = NULL;
+    if (key != OUTBOX_KEY_NONE) {
+        // The in-flight head only absorbs exact duplicates; anything else
+        // with its key goes behind it so the newer payload still gets sent
+        if (s_in_flight && s_entries[0].key == key && s_entries[0].size == size &&
+            (size == 0 || memcmp(s_entries[0].payload, payload, size) == 0)) {
+            return true;
+        }
+        for (int i = s_in_flight ? 1 : 0; i < s_count; i++) {
+            if (s_entries[i].key == key) {
+                entry = &s_entries[i];
+                break;
+            }
+        }
+    }
+
+    if (!entry) {
+        if (s_count >= OUTBOX_QUEUE_SIZE) {
+            LOG_ERROR("Outbox: queue full, dropping key %d", (int)key);
+            return false;
+        }
+        entry = &s_entries[s_count++];
+        entry->attempts = 0;
+    }
+
+    entry->key = key;
+    entry->writer = writer;
+    entry->failed = failed;
+    entry->size = size;
+    if (size > 0) {
+        memcpy(entry->payload, payload, size);
+    }
+
+    process_queue();
+    return true;
+}
+
+int outbox_queue_pending(void) {
+    return s_count;
+}
+
+void outbox_queue_reset(void) {
+    if (s_retry_timer) {
+        app_timer_cancel(s_retry_timer);
+        s_retry_timer = NULL;
+    }
+    s_count = 0;
+    s_in_flight = false;
+}
+
+void outbox_queue_handle_sent(void) {
+    if (!s_in_flight) {
+        return;
+    }
+    s_in_flight = false;
+    pop_head();
+    trace(TRACE_OUTBOX_SENT, s_count, 0);
+    process_queue();
+}
+
+void outbox_queue_handle_failed(AppMessageResult reason) {
+    if (!s_in_flight) {
+        return;
+    }
+    s_in_flight = false;
+    schedule_retry(reason);
+}
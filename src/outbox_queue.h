@@ -0,0 +1,37 @@
+#pragma once
+#ifndef PEBBLE_H
+#include <pebble.h>
+#endif
+
+// Single outbound AppMessage scheduler. Every window enqueues here instead of
+// calling app_message_outbox_begin directly; the queue sends one message at a
+// time, waits for the ack, and retries busy or failed sends with backoff.
+
+#define OUTBOX_QUEUE_SIZE 16
+#define OUTBOX_MAX_PAYLOAD 40
+#define OUTBOX_MAX_RETRIES 5
+#define OUTBOX_RETRY_BASE_MS 100
+
+// Pending entries with the same non-zero key are coalesced: enqueueing again
+// replaces the queued payload instead of sending a duplicate request
+#define OUTBOX_KEY_NONE 0
+#define OUTBOX_KEY_REQUEST_CONNECTIONS 1
+#define OUTBOX_KEY_REQUEST_NEARBY_STATIONS 2
+#define OUTBOX_KEY_NUM_FAVORITES 3
+#define OUTBOX_KEY_FAVORITES_REJECTED 4
+#define OUTBOX_KEY_FAVORITE_BASE 16  // + favorite index
+#define OUTBOX_KEY_TRACE_BASE 32     // + trace chunk index
+
+// Writes the message tuples from the queued copy of the payload
+typedef void (*OutboxWriter)(DictionaryIterator *iter, const void *payload);
+// Called once a message is dropped after OUTBOX_MAX_RETRIES attempts
+typedef void (*OutboxFailedHandler)(const void *payload);
+
+bool outbox_queue_send(uint32_t key, OutboxWriter writer, OutboxFailedHandler failed,
+                       const void *payload, size_t size);
+int outbox_queue_pending(void);
+void outbox_queue_reset(void);
+
+// Forwarded from the AppMessage outbox callbacks in app_message.c
+void outbox_queue_handle_sent(void);
+void outbox_queue_handle_failed(AppMessageResult reason);
@@ -1,82 +1,394 @@
 #include "persistence.h"
+#include "log.h"
+
+#define RECORD_HEADER_SIZE 6  // version, chunk count, length (u16), checksum (u16)
+
+// Schema versions of the packed records
+#define CONNECTIONS_VERSION 1
+#define FAVORITES_VERSION 1
+#define FAVORITE_DESTINATIONS_VERSION 2  // 1: no sync stamp
+
+static void checksum_add(PersistRecord *record, uint8_t byte) {
+    record->sum1 = (record->sum1 + byte) % 255;
+    record->sum2 = (record->sum2 + record->sum1) % 255;
+}
+
+static void flush_chunk(PersistRecord *record) {
+    if (record->num_chunks >= PERSIST_RECORD_MAX_CHUNKS) {
+        LOG_ERROR("Record %d exceeds %d chunks",
+                (int)record->base_key, PERSIST_RECORD_MAX_CHUNKS);
+        record->failed = true;
+        return;
+    }
+    uint32_t key = record->base_key + 1 + record->num_chunks;
+    int written = persist_write_data(key, record->chunk, record->position);
+    if (written != (int)record->position) {
+        LOG_ERROR("Failed to write chunk %d: %d", (int)key, written);
+        record->failed = true;
+        return;
+    }
+    record->num_chunks++;
+    record->position = 0;
+}
+
+void persist_record_begin_write(PersistRecord *record, uint32_t base_key, uint8_t version) {
+    memset(record, 0, sizeof(PersistRecord));
+    record->base_key = base_key;
+    record->version = version;
+}
+
+void persist_record_write_u8(PersistRecord *record, uint8_t value) {
+    if (record->failed) {
+        return;
+    }
+    if (record->position == sizeof(record->chunk)) {
+        flush_chunk(record);
+        if (record->failed) {
+            return;
+        }
+    }
+    record->chunk[record->position++] = value;
+    record->length++;
+    checksum_add(record, value);
+}
+
+void persist_record_write_i16(PersistRecord *record, int16_t value) {
+    persist_record_write_u8(record, (uint16_t)value & 0xFF);
+    persist_record_write_u8(record, (uint16_t)value >> 8);
+}
+
+void persist_record_write_i32(PersistRecord *record, int32_t value) {
+    for (int i = 0; i < 4; i++) {
+        persist_record_write_u8(record, ((uint32_t)value >> (8 * i)) & 0xFF);
+    }
+}
+
+void persist_record_write_string(PersistRecord *record, const char *str) {
+    size_t length = strlen(str);
+    if (length > 255) {
+        length = 255;
+    }
+    persist_record_write_u8(record, length);
+    for (size_t i = 0; i < length; i++) {
+        persist_record_write_u8(record, str[i]);
+    }
+}
+
+static int read_chunk_count(uint32_t base_key) {
+    uint8_t header[RECORD_HEADER_SIZE];
+    if (persist_read_data(base_key, header, sizeof(header)) != RECORD_HEADER_SIZE) {
+        return 0;
+    }
+    return header[1];
+}
+
+bool persist_record_end_write(PersistRecord *record) {
+    if (record->position > 0 && !record->failed) {
+        flush_chunk(record);
+    }
+    if (record->failed) {
+        return false;
+    }
+
+    // The header goes last: until it is written, a reader sees the old
+    // header and rejects the new chunks by checksum
+    int old_chunks = read_chunk_count(record->base_key);
+    for (int i = record->num_chunks; i < old_chunks && i < PERSIST_RECORD_MAX_CHUNKS; i++) {
+        persist_delete(record->base_key + 1 + i);
+    }
+
+    uint16_t checksum = (record->sum2 << 8) | record->sum1;
+    uint8_t header[RECORD_HEADER_SIZE] = {
+        record->version,
+        record->num_chunks,
+        record->length & 0xFF,
+        record->length >> 8,
+        checksum & 0xFF,
+        checksum >> 8
+    };
+    if (persist_write_data(record->base_key, header, sizeof(header)) != RECORD_HEADER_SIZE) {
+        LOG_ERROR("Failed to write record header %d", (int)record->base_key);
+        return false;
+    }
+    return true;
+}
+
+bool persist_record_begin_read(PersistRecord *record, uint32_t base_key) {
+    memset(record, 0, sizeof(PersistRecord));
+    record->base_key = base_key;
+
+    uint8_t header[RECORD_HEADER_SIZE];
+    if (!persist_exists(base_key) ||
+        persist_read_data(base_key, header, sizeof(header)) != RECORD_HEADER_SIZE) {
+        return false;
+    }
+    record->version = header[0];
+    record->num_chunks = header[1];
+    record->length = header[2] | (header[3] << 8);
+    record->checksum = header[4] | (header[5] << 8);
+
+    if (record->num_chunks > PERSIST_RECORD_MAX_CHUNKS ||
+        record->length > (size_t)record->num_chunks * sizeof(record->chunk)) {
+        LOG_WARNING("Invalid record header %d", (int)base_key);
+        return false;
+    }
+    return true;
+}
+
+uint8_t persist_record_read_u8(PersistRecord *record) {
+    if (record->failed || record->length == 0) {
+        record->failed = true;
+        return 0;
+    }
+    if (record->position == record->available) {
+        if (record->next_chunk >= record->num_chunks) {
+            record->failed = true;
+            return 0;
+        }
+        uint32_t key = record->base_key + 1 + record->next_chunk;
+        int read = persist_read_data(key, record->chunk, sizeof(record->chunk));
+        if (read <= 0) {
+            record->failed = true;
+            return 0;
+        }
+        record->available = read;
+        record->position = 0;
+        record->next_chunk++;
+    }
+    uint8_t value = record->chunk[record->position++];
+    record->length--;
+    checksum_add(record, value);
+    return value;
+}
+
+int16_t persist_record_read_i16(PersistRecord *record) {
+    uint16_t value = persist_record_read_u8(record);
+    value |= (uint16_t)persist_record_read_u8(record) << 8;
+    return (int16_t)value;
+}
+
+int32_t persist_record_read_i32(PersistRecord *record) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t)persist_record_read_u8(record) << (8 * i);
+    }
+    return (int32_t)value;
+}
+
+void persist_record_read_string(PersistRecord *record, char *buffer, size_t size) {
+    uint8_t length = persist_record_read_u8(record);
+    size_t copied = 0;
+    for (int i = 0; i < length; i++) {
+        char c = persist_record_read_u8(record);
+        if (copied + 1 < size) {
+            buffer[copied++] = c;
+        }
+    }
+    buffer[copied] = '\0';
+}
+
+bool persist_record_end_read(PersistRecord *record) {
+    uint16_t checksum = (record->sum2 << 8) | record->sum1;
+    if (record->failed || record->length != 0 || checksum != record->checksum) {
+        LOG_WARNING("Record %d is corrupt, ignoring it", (int)record->base_key);
+        return false;
+    }
+    return true;
+}
+
+void persist_record_delete(uint32_t base_key) {
+    int chunks = read_chunk_count(base_key);
+    for (int i = 0; i < chunks && i < PERSIST_RECORD_MAX_CHUNKS; i++) {
+        persist_delete(base_key + 1 + i);
+    }
+    persist_delete(base_key);
+}
+
+// Reads a pre-record raw struct dump and deletes it. Dumps larger than one
+// key were truncated on the watch, so only whole items are returned.
+static int load_legacy(uint32_t count_key, uint32_t data_key, void *items,
+                       size_t item_size, int max_count) {
+    int count = 0;
+    if (persist_exists(count_key)) {
+        count = persist_read_int(count_key);
+    }
+    if (count < 0 || count > max_count) {
+        count = 0;
+    }
+    if (count > 0 && persist_exists(data_key)) {
+        int read = persist_read_data(data_key, items, item_size * count);
+        int whole = read > 0 ? read / (int)item_size : 0;
+        if (whole < count) {
+            LOG_WARNING("Legacy key %d truncated, kept %d of %d",
+                    (int)data_key, whole, count);
+            count = whole;
+        }
+    } else {
+        count = 0;
+    }
+    persist_delete(count_key);
+    persist_delete(data_key);
+    return count;
+}
 
 void save_connections(SavedConnection *connections, int count) {
     if (count > MAX_SAVED_CONNECTIONS) {
         count = MAX_SAVED_CONNECTIONS;
     }
-    persist_write_int(PERSIST_KEY_NUM_CONNECTIONS, count);
-    persist_write_data(PERSIST_KEY_CONNECTIONS, connections,
-                       sizeof(SavedConnection) * count);
+    PersistRecord record;
+    persist_record_begin_write(&record, PERSIST_RECORD_CONNECTIONS, CONNECTIONS_VERSION);
+    persist_record_write_u8(&record, count);
+    for (int i = 0; i < count; i++) {
+        persist_record_write_string(&record, connections[i].departure_station_id);
+        persist_record_write_string(&record, connections[i].departure_station_name);
+        persist_record_write_string(&record, connections[i].arrival_station_id);
+        persist_record_write_string(&record, connections[i].arrival_station_name);
+    }
+    persist_record_end_write(&record);
 }
 
 int load_connections(SavedConnection *connections) {
-    if (!persist_exists(PERSIST_KEY_NUM_CONNECTIONS)) {
+    PersistRecord record;
+    if (!persist_record_begin_read(&record, PERSIST_RECORD_CONNECTIONS)) {
+        if (!persist_exists(PERSIST_KEY_NUM_CONNECTIONS)) {
+            return 0;
+        }
+        int count = load_legacy(PERSIST_KEY_NUM_CONNECTIONS, PERSIST_KEY_CONNECTIONS,
+                                connections, sizeof(SavedConnection), MAX_SAVED_CONNECTIONS);
+        save_connections(connections, count);
+        return count;
+    }
+    if (record.version != CONNECTIONS_VERSION) {
+        LOG_WARNING("Unknown connections version %d", record.version);
         return 0;
     }
-    int count = persist_read_int(PERSIST_KEY_NUM_CONNECTIONS);
+
+    int count = persist_record_read_u8(&record);
     // Validate count to prevent buffer overflow
-    if (count < 0 || count > MAX_SAVED_CONNECTIONS) {
+    if (count > MAX_SAVED_CONNECTIONS) {
         return 0;
     }
-    persist_read_data(PERSIST_KEY_CONNECTIONS, connections,
-                      sizeof(SavedConnection) * count);
-    return count;
+    for (int i = 0; i < count; i++) {
+        SavedConnection *conn = &connections[i];
+        persist_record_read_string(&record, conn->departure_station_id, sizeof(conn->departure_station_id));
+        persist_record_read_string(&record, conn->departure_station_name, sizeof(conn->departure_station_name));
+        persist_record_read_string(&record, conn->arrival_station_id, sizeof(conn->arrival_station_id));
+        persist_record_read_string(&record, conn->arrival_station_name, sizeof(conn->arrival_station_name));
+    }
+    return persist_record_end_read(&record) ? count : 0;
 }
 
 void save_favorites(Station *stations, int count) {
     if (count > MAX_FAVORITE_STATIONS) {
         count = MAX_FAVORITE_STATIONS;
     }
-    persist_write_int(PERSIST_KEY_NUM_FAVORITES, count);
-    persist_write_data(PERSIST_KEY_FAVORITES, stations,
-                       sizeof(Station) * count);
+    PersistRecord record;
+    persist_record_begin_write(&record, PERSIST_RECORD_FAVORITES, FAVORITES_VERSION);
+    persist_record_write_u8(&record, count);
+    for (int i = 0; i < count; i++) {
+        persist_record_write_string(&record, stations[i].id);
+        persist_record_write_string(&record, stations[i].name);
+        persist_record_write_i32(&record, stations[i].distance_meters);
+    }
+    persist_record_end_write(&record);
 }
 
 int load_favorites(Station *stations) {
-    if (!persist_exists(PERSIST_KEY_NUM_FAVORITES)) {
+    PersistRecord record;
+    if (!persist_record_begin_read(&record, PERSIST_RECORD_FAVORITES)) {
+        if (!persist_exists(PERSIST_KEY_NUM_FAVORITES)) {
+            return 0;
+        }
+        int count = load_legacy(PERSIST_KEY_NUM_FAVORITES, PERSIST_KEY_FAVORITES,
+                                stations, sizeof(Station), MAX_FAVORITE_STATIONS);
+        save_favorites(stations, count);
+        return count;
+    }
+    if (record.version != FAVORITES_VERSION) {
+        LOG_WARNING("Unknown favorites version %d", record.version);
         return 0;
     }
-    int count = persist_read_int(PERSIST_KEY_NUM_FAVORITES);
+
+    int count = persist_record_read_u8(&record);
     // Validate count to prevent buffer overflow
-    if (count < 0 || count > MAX_FAVORITE_STATIONS) {
+    if (count > MAX_FAVORITE_STATIONS) {
         return 0;
     }
-    persist_read_data(PERSIST_KEY_FAVORITES, stations,
-                      sizeof(Station) * count);
-    return count;
+    for (int i = 0; i < count; i++) {
+        persist_record_read_string(&record, stations[i].id, sizeof(stations[i].id));
+        persist_record_read_string(&record, stations[i].name, sizeof(stations[i].name));
+        stations[i].distance_meters = persist_record_read_i32(&record);
+    }
+    return persist_record_end_read(&record) ? count : 0;
 }
 
 bool is_connection_limit_reached(void) {
-    if (!persist_exists(PERSIST_KEY_NUM_CONNECTIONS)) {
-        return false;
+    PersistRecord record;
+    if (!persist_record_begin_read(&record, PERSIST_RECORD_CONNECTIONS)) {
+        // Not migrated yet
+        if (!persist_exists(PERSIST_KEY_NUM_CONNECTIONS)) {
+            return false;
+        }
+        return persist_read_int(PERSIST_KEY_NUM_CONNECTIONS) >= MAX_SAVED_CONNECTIONS;
     }
-    int count = persist_read_int(PERSIST_KEY_NUM_CONNECTIONS);
-    return count >= MAX_SAVED_CONNECTIONS;
+    // The count is the first payload byte, no need to read the rest
+    return persist_record_read_u8(&record) >= MAX_SAVED_CONNECTIONS;
 }
 
-void save_favorite_destinations(FavoriteDestination *favorites, int count) {
+void save_favorite_destinations(FavoriteDestination *favorites, int count, const FavoritesSync *sync) {
     if (count > MAX_FAVORITE_DESTINATIONS) {
         count = MAX_FAVORITE_DESTINATIONS;
     }
-    persist_write_int(PERSIST_KEY_NUM_FAVORITE_DESTINATIONS, count);
-    if (count > 0) {
-        persist_write_data(PERSIST_KEY_FAVORITE_DESTINATIONS, favorites,
-                          sizeof(FavoriteDestination) * count);
+    PersistRecord record;
+    persist_record_begin_write(&record, PERSIST_RECORD_FAVORITE_DESTINATIONS,
+                               FAVORITE_DESTINATIONS_VERSION);
+    persist_record_write_u8(&record, count);
+    persist_record_write_i16(&record, sync ? (int16_t)sync->version : 0);
+    persist_record_write_i32(&record, sync ? sync->hash : 0);
+    for (int i = 0; i < count; i++) {
+        persist_record_write_string(&record, favorites[i].id);
+        persist_record_write_string(&record, favorites[i].name);
+        persist_record_write_string(&record, favorites[i].label);
     }
+    persist_record_end_write(&record);
 }
 
-int load_favorite_destinations(FavoriteDestination *favorites) {
-    if (!persist_exists(PERSIST_KEY_NUM_FAVORITE_DESTINATIONS)) {
+int load_favorite_destinations(FavoriteDestination *favorites, FavoritesSync *sync) {
+    FavoritesSync unused;
+    if (!sync) {
+        sync = &unused;
+    }
+    memset(sync, 0, sizeof(FavoritesSync));
+
+    PersistRecord record;
+    if (!persist_record_begin_read(&record, PERSIST_RECORD_FAVORITE_DESTINATIONS)) {
+        if (!persist_exists(PERSIST_KEY_NUM_FAVORITE_DESTINATIONS)) {
+            return 0;
+        }
+        int count = load_legacy(PERSIST_KEY_NUM_FAVORITE_DESTINATIONS, PERSIST_KEY_FAVORITE_DESTINATIONS,
+                                favorites, sizeof(FavoriteDestination), MAX_FAVORITE_DESTINATIONS);
+        save_favorite_destinations(favorites, count, NULL);
+        return count;
+    }
+    if (record.version != FAVORITE_DESTINATIONS_VERSION && record.version != 1) {
+        LOG_WARNING("Unknown favorite destinations version %d", record.version);
         return 0;
     }
-    int count = persist_read_int(PERSIST_KEY_NUM_FAVORITE_DESTINATIONS);
+
+    int count = persist_record_read_u8(&record);
     // Validate count to prevent buffer overflow
-    if (count < 0 || count > MAX_FAVORITE_DESTINATIONS) {
+    if (count > MAX_FAVORITE_DESTINATIONS) {
         return 0;
     }
-    if (count > 0 && persist_exists(PERSIST_KEY_FAVORITE_DESTINATIONS)) {
-        persist_read_data(PERSIST_KEY_FAVORITE_DESTINATIONS, favorites,
-                         sizeof(FavoriteDestination) * count);
+    // Version 1 lists were never synced; the next save stamps them
+    if (record.version == FAVORITE_DESTINATIONS_VERSION) {
+        sync->version = (uint16_t)persist_record_read_i16(&record);
+        sync->hash = persist_record_read_i32(&record);
     }
-    return count;
+    for (int i = 0; i < count; i++) {
+        persist_record_read_string(&record, favorites[i].id, sizeof(favorites[i].id));
+        persist_record_read_string(&record, favorites[i].name, sizeof(favorites[i].name));
+        persist_record_read_string(&record, favorites[i].label, sizeof(favorites[i].label));
+    }
+    return persist_record_end_read(&record) ? count : 0;
 }
@@ -1,6 +1,8 @@
 #pragma once
 #include "data_models.h"
 
+// Legacy keys: raw struct dumps written before the record store. Only read
+// once to migrate, then deleted.
 #define PERSIST_KEY_CONNECTIONS 1
 #define PERSIST_KEY_FAVORITES 2
 #define PERSIST_KEY_NUM_CONNECTIONS 3
@@ -8,6 +10,52 @@
 #define PERSIST_KEY_FAVORITE_DESTINATIONS 5
 #define PERSIST_KEY_NUM_FAVORITE_DESTINATIONS 6
 
+// Record store. A record is a packed payload split across consecutive keys:
+// the base key holds a small header (schema version, chunk count, length,
+// checksum) and base + 1 .. base + n hold up to PERSIST_DATA_MAX_LENGTH bytes
+// each. Records are streamed through one chunk buffer, never built in full.
+#define PERSIST_RECORD_CONNECTIONS 16
+#define PERSIST_RECORD_FAVORITES 32
+#define PERSIST_RECORD_FAVORITE_DESTINATIONS 48
+#define PERSIST_RECORD_PINNED_CONNECTION 64
+#define PERSIST_RECORD_LAST_RESULTS 112  // Past the legacy pin key (100)
+#define PERSIST_RECORD_MAX_CHUNKS 8  // Keys reserved after each base key
+
+typedef struct {
+    uint32_t base_key;
+    uint8_t chunk[PERSIST_DATA_MAX_LENGTH];
+    size_t position;    // Offset into chunk
+    size_t available;   // Bytes loaded into chunk (reading)
+    int num_chunks;     // Chunks flushed so far, or in the record (reading)
+    int next_chunk;     // Next chunk to load (reading)
+    size_t length;      // Payload bytes written, or left to read
+    uint16_t sum1;      // Fletcher-16 over the payload
+    uint16_t sum2;
+    uint16_t checksum;  // Stored checksum (reading)
+    uint8_t version;
+    bool failed;        // Overflow, short read or storage error
+} PersistRecord;
+
+void persist_record_begin_write(PersistRecord *record, uint32_t base_key, uint8_t version);
+void persist_record_write_u8(PersistRecord *record, uint8_t value);
+void persist_record_write_i16(PersistRecord *record, int16_t value);
+void persist_record_write_i32(PersistRecord *record, int32_t value);
+void persist_record_write_string(PersistRecord *record, const char *str);
+// Flushes the last chunk, writes the header and drops stale chunks
+bool persist_record_end_write(PersistRecord *record);
+
+// Returns false if there is no valid header; record->version is the schema
+// version the record was written with
+bool persist_record_begin_read(PersistRecord *record, uint32_t base_key);
+uint8_t persist_record_read_u8(PersistRecord *record);
+int16_t persist_record_read_i16(PersistRecord *record);
+int32_t persist_record_read_i32(PersistRecord *record);
+void persist_record_read_string(PersistRecord *record, char *buffer, size_t size);
+// True if every byte was read and the checksum matches
+bool persist_record_end_read(PersistRecord *record);
+
+void persist_record_delete(uint32_t base_key);
+
 // Save/load saved connections
 void save_connections(SavedConnection *connections, int count);
 int load_connections(SavedConnection *connections);
@@ -19,6 +67,7 @@ int load_favorites(Station *stations);
 // Check if connection limit reached
 bool is_connection_limit_reached(void);
 
-// Save/load favorite destinations
-void save_favorite_destinations(FavoriteDestination *favorites, int count);
-int load_favorite_destinations(FavoriteDestination *favorites);
+// Save/load favorite destinations with the sync stamp of the list; sync may
+// be NULL, which saves an unsynced list or skips reading the stamp
+void save_favorite_destinations(FavoriteDestination *favorites, int count, const FavoritesSync *sync);
+int load_favorite_destinations(FavoriteDestination *favorites, FavoritesSync *sync);
@@ -0,0 +1,49 @@
+#pragma once
+
+// Compact copy of the pinned journey for the background worker, which can't
+// afford the record store or the string pool. Shared by src/pin_worker.c and
+// worker_src/worker.c; include after pebble.h or pebble_worker.h.
+
+#define PIN_SUMMARY_KEY 80  // After the record store's keys, see persistence.h
+#define PIN_SUMMARY_VERSION 1
+#define PIN_SUMMARY_PLATFORM_LENGTH 8
+
+// Wake the app this long before the (delayed) departure
+#define PIN_SUMMARY_IMMINENT_SECONDS (5 * 60)
+
+// The app was open inside the imminent window; don't wake it again for
+// this departure
+#define PIN_SUMMARY_FLAG_SEEN 0x01
+
+// Sent by the app when it rewrote the summary
+#define PIN_WORKER_MSG_CHANGED 1
+
+typedef struct {
+    uint8_t version;
+    uint8_t flags;
+    int16_t delay_minutes;
+    int32_t departure_time;  // Scheduled departure of the first leg
+    int32_t arrival_time;    // Scheduled arrival of the last leg
+    char platform[PIN_SUMMARY_PLATFORM_LENGTH];
+} PinSummary;
+
+typedef enum {
+    PIN_SUMMARY_WAITING,
+    PIN_SUMMARY_IMMINENT,
+    PIN_SUMMARY_DEPARTED,
+    PIN_SUMMARY_EXPIRED,  // Same rule as is_pinned_connection_expired()
+} PinSummaryState;
+
+static inline PinSummaryState pin_summary_state(const PinSummary *summary, time_t now) {
+    if (summary->arrival_time < now) {
+        return PIN_SUMMARY_EXPIRED;
+    }
+    time_t departure = summary->departure_time + summary->delay_minutes * 60;
+    if (departure <= now) {
+        return PIN_SUMMARY_DEPARTED;
+    }
+    if (departure - now <= PIN_SUMMARY_IMMINENT_SECONDS) {
+        return PIN_SUMMARY_IMMINENT;
+    }
+    return PIN_SUMMARY_WAITING;
+}
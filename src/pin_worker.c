@@ -0,0 +1,54 @@
+#include "pin_worker.h"
+#include "log.h"
+#include <string.h>
+
+bool pin_worker_build_summary(const PinnedConnection *pinned, time_t now, PinSummary *summary) {
+    const Connection *connection = &pinned->connection;
+    if (!pinned->is_active || connection->num_sections == 0) {
+        return false;
+    }
+
+    memset(summary, 0, sizeof(*summary));
+    summary->version = PIN_SUMMARY_VERSION;
+    summary->delay_minutes = connection->sections[0].delay_minutes;
+    summary->departure_time = connection->departure_time;
+    summary->arrival_time = connection->arrival_time;
+    strncpy(summary->platform, connection->sections[0].platform, PIN_SUMMARY_PLATFORM_LENGTH - 1);
+
+    PinSummaryState state = pin_summary_state(summary, now);
+    if (state == PIN_SUMMARY_EXPIRED) {
+        return false;
+    }
+    if (state != PIN_SUMMARY_WAITING) {
+        summary->flags |= PIN_SUMMARY_FLAG_SEEN;
+    }
+    return true;
+}
+
+void pin_worker_sync(const PinnedConnection *pinned) {
+    PinSummary summary;
+    if (!pin_worker_build_summary(pinned, time(NULL), &summary)) {
+        if (persist_exists(PIN_SUMMARY_KEY)) {
+            persist_delete(PIN_SUMMARY_KEY);
+        }
+        if (app_worker_is_running()) {
+            app_worker_kill();
+        }
+        return;
+    }
+
+    PinSummary stored;
+    bool unchanged = persist_read_data(PIN_SUMMARY_KEY, &stored, sizeof(stored)) == (int)sizeof(stored) &&
+                     memcmp(&stored, &summary, sizeof(summary)) == 0;
+    if (!unchanged) {
+        persist_write_data(PIN_SUMMARY_KEY, &summary, sizeof(summary));
+    }
+
+    if (!app_worker_is_running()) {
+        LOG_INFO("Starting pin worker");
+        app_worker_launch();
+    } else if (!unchanged) {
+        AppWorkerMessage message = { 0 };
+        app_worker_send_message(PIN_WORKER_MSG_CHANGED, &message);
+    }
+}
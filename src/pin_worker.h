@@ -0,0 +1,17 @@
+#pragma once
+#ifndef PEBBLE_H
+#include <pebble.h>
+#endif
+#include "pinned_connection.h"
+#include "pin_summary.h"
+
+// Hands the pinned journey to the background worker (worker_src/), which
+// counts down to departure while the app is closed and launches it shortly
+// before the train leaves.
+
+// Fills `summary`; false if there is nothing left to track
+bool pin_worker_build_summary(const PinnedConnection *pinned, time_t now, PinSummary *summary);
+
+// Call when the app closes: writes the summary if it changed and starts,
+// updates or stops the worker
+void pin_worker_sync(const PinnedConnection *pinned);
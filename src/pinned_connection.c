@@ -1,23 +1,186 @@
 #include "pinned_connection.h"
+#include "log.h"
+#include "persistence.h"
 
-#define PINNED_CONNECTION_KEY 100
+#define PINNED_CONNECTION_VERSION 1
+#define LEGACY_PINNED_CONNECTION_KEY 100
+
+// Layout of the raw dump stored under LEGACY_PINNED_CONNECTION_KEY before the
+// record store; only read to migrate it
+typedef struct {
+    char departure_station[MAX_STATION_NAME_LENGTH];
+    char arrival_station[MAX_STATION_NAME_LENGTH];
+    time_t departure_time;
+    time_t arrival_time;
+    char platform[MAX_PLATFORM_LENGTH];
+    char train_type[MAX_TRAIN_TYPE_LENGTH];
+    int delay_minutes;
+} LegacyJourneySection;
+
+typedef struct {
+    LegacyJourneySection sections[5];
+    int num_sections;
+    time_t departure_time;
+    time_t arrival_time;
+    int total_delay_minutes;
+    int num_changes;
+} LegacyConnection;
+
+typedef struct {
+    LegacyConnection connection;
+    SavedConnection route;
+    time_t pinned_at;
+    bool is_active;
+} LegacyPinnedConnection;
+
+static int clamp_sections(int num_sections) {
+    return num_sections < 0 ? 0 : (num_sections > 5 ? 5 : num_sections);
+}
+
+// Interned names are only valid for this run, so the record spells them out
+static void write_section(PersistRecord *record, const JourneySection *section) {
+    persist_record_write_string(record, string_pool_get(section->departure_station));
+    persist_record_write_string(record, string_pool_get(section->arrival_station));
+    persist_record_write_i32(record, section->departure_time);
+    persist_record_write_i32(record, section->arrival_time);
+    persist_record_write_string(record, section->platform);
+    persist_record_write_string(record, section->train_type);
+    persist_record_write_i16(record, section->delay_minutes);
+}
+
+static void read_section(PersistRecord *record, JourneySection *section) {
+    char name[MAX_STATION_NAME_LENGTH];
+    persist_record_read_string(record, name, sizeof(name));
+    section->departure_station = string_pool_intern(name);
+    persist_record_read_string(record, name, sizeof(name));
+    section->arrival_station = string_pool_intern(name);
+    section->departure_time = persist_record_read_i32(record);
+    section->arrival_time = persist_record_read_i32(record);
+    persist_record_read_string(record, section->platform, sizeof(section->platform));
+    persist_record_read_string(record, section->train_type, sizeof(section->train_type));
+    section->delay_minutes = persist_record_read_i16(record);
+}
+
+static void write_route(PersistRecord *record, const SavedConnection *route) {
+    persist_record_write_string(record, route->departure_station_id);
+    persist_record_write_string(record, route->departure_station_name);
+    persist_record_write_string(record, route->arrival_station_id);
+    persist_record_write_string(record, route->arrival_station_name);
+}
+
+static void read_route(PersistRecord *record, SavedConnection *route) {
+    persist_record_read_string(record, route->departure_station_id, sizeof(route->departure_station_id));
+    persist_record_read_string(record, route->departure_station_name, sizeof(route->departure_station_name));
+    persist_record_read_string(record, route->arrival_station_id, sizeof(route->arrival_station_id));
+    persist_record_read_string(record, route->arrival_station_name, sizeof(route->arrival_station_name));
+}
 
 void save_pinned_connection(PinnedConnection *pinned) {
-    persist_write_data(PINNED_CONNECTION_KEY, pinned, sizeof(PinnedConnection));
-    APP_LOG(APP_LOG_LEVEL_INFO, "Pinned connection saved, is_active=%d", pinned->is_active);
+    if (!pinned->is_active) {
+        // Nothing worth keeping; a missing record loads as inactive
+        persist_record_delete(PERSIST_RECORD_PINNED_CONNECTION);
+        LOG_INFO("Pinned connection saved, is_active=0");
+        return;
+    }
+
+    const Connection *conn = &pinned->connection;
+    int num_sections = clamp_sections(conn->num_sections);
+
+    PersistRecord record;
+    persist_record_begin_write(&record, PERSIST_RECORD_PINNED_CONNECTION, PINNED_CONNECTION_VERSION);
+    persist_record_write_u8(&record, pinned->is_active);
+    persist_record_write_i32(&record, pinned->pinned_at);
+    write_route(&record, &pinned->route);
+    persist_record_write_i32(&record, conn->departure_time);
+    persist_record_write_i32(&record, conn->arrival_time);
+    persist_record_write_i16(&record, conn->total_delay_minutes);
+    persist_record_write_u8(&record, conn->num_changes);
+    persist_record_write_u8(&record, num_sections);
+    for (int i = 0; i < num_sections; i++) {
+        write_section(&record, &conn->sections[i]);
+    }
+    persist_record_end_write(&record);
+    LOG_INFO("Pinned connection saved, is_active=%d", pinned->is_active);
+}
+
+// Full-size dumps only exist where the per-key limit was not enforced; a
+// truncated one cannot be recovered and is dropped
+static bool migrate_legacy_pin(PinnedConnection *pinned) {
+    LegacyPinnedConnection legacy;
+    memset(&legacy, 0, sizeof(legacy));
+    int read = persist_read_data(LEGACY_PINNED_CONNECTION_KEY, &legacy, sizeof(legacy));
+    persist_delete(LEGACY_PINNED_CONNECTION_KEY);
+    if (read != (int)sizeof(legacy)) {
+        LOG_WARNING("Dropping truncated legacy pin (%d bytes)", read);
+        return false;
+    }
+
+    const LegacyConnection *conn = &legacy.connection;
+    pinned->connection.num_sections = clamp_sections(conn->num_sections);
+    for (int i = 0; i < pinned->connection.num_sections; i++) {
+        const LegacyJourneySection *stored = &conn->sections[i];
+        JourneySection *section = &pinned->connection.sections[i];
+        char name[MAX_STATION_NAME_LENGTH];
+        snprintf(name, sizeof(name), "%s", stored->departure_station);
+        section->departure_station = string_pool_intern(name);
+        snprintf(name, sizeof(name), "%s", stored->arrival_station);
+        section->arrival_station = string_pool_intern(name);
+        section->departure_time = stored->departure_time;
+        section->arrival_time = stored->arrival_time;
+        snprintf(section->platform, sizeof(section->platform), "%.*s",
+                 MAX_PLATFORM_LENGTH - 1, stored->platform);
+        snprintf(section->train_type, sizeof(section->train_type), "%.*s",
+                 MAX_TRAIN_TYPE_LENGTH - 1, stored->train_type);
+        section->delay_minutes = stored->delay_minutes;
+    }
+    pinned->connection.departure_time = conn->departure_time;
+    pinned->connection.arrival_time = conn->arrival_time;
+    pinned->connection.total_delay_minutes = conn->total_delay_minutes;
+    pinned->connection.num_changes = conn->num_changes;
+    pinned->route = legacy.route;
+    pinned->pinned_at = legacy.pinned_at;
+    pinned->is_active = legacy.is_active;
+
+    save_pinned_connection(pinned);
+    return true;
+}
+
+static bool read_pin(PinnedConnection *pinned) {
+    PersistRecord record;
+    if (!persist_record_begin_read(&record, PERSIST_RECORD_PINNED_CONNECTION)) {
+        return persist_exists(LEGACY_PINNED_CONNECTION_KEY) && migrate_legacy_pin(pinned);
+    }
+    if (record.version != PINNED_CONNECTION_VERSION) {
+        LOG_WARNING("Unknown pinned connection version %d", record.version);
+        return false;
+    }
+
+    Connection *conn = &pinned->connection;
+    pinned->is_active = persist_record_read_u8(&record);
+    pinned->pinned_at = persist_record_read_i32(&record);
+    read_route(&record, &pinned->route);
+    conn->departure_time = persist_record_read_i32(&record);
+    conn->arrival_time = persist_record_read_i32(&record);
+    conn->total_delay_minutes = persist_record_read_i16(&record);
+    conn->num_changes = persist_record_read_u8(&record);
+    conn->num_sections = clamp_sections(persist_record_read_u8(&record));
+    for (int i = 0; i < conn->num_sections; i++) {
+        read_section(&record, &conn->sections[i]);
+    }
+    return persist_record_end_read(&record);
 }
 
 PinnedConnection load_pinned_connection(void) {
     PinnedConnection pinned;
+    memset(&pinned, 0, sizeof(PinnedConnection));
 
-    if (persist_exists(PINNED_CONNECTION_KEY)) {
-        persist_read_data(PINNED_CONNECTION_KEY, &pinned, sizeof(PinnedConnection));
-        APP_LOG(APP_LOG_LEVEL_INFO, "Loaded pinned connection, is_active=%d", pinned.is_active);
+    if (read_pin(&pinned)) {
+        LOG_INFO("Loaded pinned connection, is_active=%d", pinned.is_active);
     } else {
         // Initialize empty
         memset(&pinned, 0, sizeof(PinnedConnection));
         pinned.is_active = false;
-        APP_LOG(APP_LOG_LEVEL_INFO, "No pinned connection found, initialized empty");
+        LOG_INFO("No pinned connection found, initialized empty");
     }
 
     return pinned;
@@ -28,7 +191,7 @@ void clear_pinned_connection(void) {
     memset(&pinned, 0, sizeof(PinnedConnection));
     pinned.is_active = false;
     save_pinned_connection(&pinned);
-    APP_LOG(APP_LOG_LEVEL_INFO, "Pinned connection cleared");
+    LOG_INFO("Pinned connection cleared");
 }
 
 bool is_pinned_connection_expired(PinnedConnection *pinned) {
@@ -40,7 +203,7 @@ bool is_pinned_connection_expired(PinnedConnection *pinned) {
     bool expired = pinned->connection.arrival_time < now;
 
     if (expired) {
-        APP_LOG(APP_LOG_LEVEL_INFO, "Pinned connection expired (arrival: %d, now: %d)",
+        LOG_INFO("Pinned connection expired (arrival: %d, now: %d)",
                 (int)pinned->connection.arrival_time, (int)now);
     }
 
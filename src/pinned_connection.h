@@ -1,5 +1,7 @@
 #pragma once
+#ifndef PEBBLE_H
 #include <pebble.h>
+#endif
 #include "data_models.h"
 
 typedef struct {
@@ -4,6 +4,15 @@
     var searchTimeout = null;
     var pebbleReady = false;
 
+    // Station search results, least recently used first. A result with fewer
+    // than SEARCH_COMPLETE_BELOW stations holds every match, so a longer
+    // query starting with it is filtered locally instead of fetched.
+    var SEARCH_CACHE_SIZE = 30;
+    var SEARCH_COMPLETE_BELOW = 10;
+    var searchCache = [];
+    var searchController = null;
+    var searchSequence = 0;
+
     // Check for Pebble environment
     function checkPebbleEnvironment() {
         console.log('Checking Pebble environment...');
@@ -51,6 +60,10 @@
     function handleStationSearch(e) {
         var query = e.target.value.trim();
 
+        // Whatever is in flight was for an older query
+        clearTimeout(searchTimeout);
+        cancelSearch();
+
         if (query.length < 2) {
             document.getElementById('autocompleteResults').style.display = 'none';
             selectedStation = null;
@@ -58,25 +71,112 @@
             return;
         }
 
+        var cached = cachedSearch(query);
+        if (cached) {
+            displayAutocompleteResults(cached);
+            return;
+        }
+
         // Debounce search
-        clearTimeout(searchTimeout);
         searchTimeout = setTimeout(function() {
             searchStation(query);
         }, 300);
     }
 
+    // Lowercase without accents, umlauts spelled out as plain vowels, so that
+    // "Zuer" matches "Zürich" the way the API does
+    function normalizeName(text) {
+        var plain = text.toLowerCase();
+        if (plain.normalize) {
+            plain = plain.normalize('NFD').replace(/[\u0300-\u036f]/g, '');
+        }
+        return plain.replace(/ae/g, 'a').replace(/oe/g, 'o').replace(/ue/g, 'u');
+    }
+
+    function cacheKey(query) {
+        return query.toLowerCase();
+    }
+
+    function rememberSearch(query, stations) {
+        var key = cacheKey(query);
+        searchCache = searchCache.filter(function(entry) {
+            return entry.key !== key;
+        });
+        searchCache.push({
+            key: key,
+            stations: stations,
+            complete: stations.length < SEARCH_COMPLETE_BELOW
+        });
+        if (searchCache.length > SEARCH_CACHE_SIZE) {
+            searchCache.shift();
+        }
+    }
+
+    // Stations for the query from the cache, or null if it has to be fetched
+    function cachedSearch(query) {
+        var key = cacheKey(query);
+        var parent = null;
+
+        for (var i = 0; i < searchCache.length; i++) {
+            var entry = searchCache[i];
+            if (entry.key === key) {
+                searchCache.splice(i, 1);
+                searchCache.push(entry);
+                return entry.stations;
+            }
+            if (entry.complete && key.indexOf(entry.key) === 0 &&
+                (!parent || entry.key.length > parent.key.length)) {
+                parent = entry;
+            }
+        }
+
+        if (!parent) {
+            return null;
+        }
+        var wanted = normalizeName(query);
+        var stations = parent.stations.filter(function(station) {
+            return normalizeName(station.name || '').indexOf(wanted) !== -1;
+        });
+        rememberSearch(query, stations);
+        return stations;
+    }
+
+    function cancelSearch() {
+        searchSequence++;
+        if (searchController) {
+            searchController.abort();
+            searchController = null;
+        }
+    }
+
     function searchStation(query) {
         var url = 'https://transport.opendata.ch/v1/locations?query=' + encodeURIComponent(query) + '&type=station';
 
-        fetch(url)
+        cancelSearch();
+        var sequence = searchSequence;
+        var options = {};
+        if (typeof AbortController !== 'undefined') {
+            searchController = new AbortController();
+            options.signal = searchController.signal;
+        }
+
+        fetch(url, options)
             .then(function(response) {
                 return response.json();
             })
             .then(function(data) {
-                displayAutocompleteResults(data.stations || []);
+                if (sequence !== searchSequence) {
+                    return;
+                }
+                searchController = null;
+                var stations = data.stations || [];
+                rememberSearch(query, stations);
+                displayAutocompleteResults(stations);
             })
             .catch(function(error) {
-                console.error('Search error:', error);
+                if (error.name !== 'AbortError') {
+                    console.error('Search error:', error);
+                }
             });
     }
 
@@ -227,6 +327,9 @@
         var configData = {
             favorites: favorites
         };
+        if (document.getElementById('dumpTrace').checked) {
+            configData.dumpTrace = true;
+        }
 
         var url = return_to + encodeURIComponent(JSON.stringify(configData));
         console.log('Closing with URL:', url);
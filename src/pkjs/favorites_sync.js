@@ -0,0 +1,170 @@
+// Favorites delta sync with the watch. The phone keeps a copy of the list
+// the watch stores, stamped with a version and a content hash. Opening the
+// settings page sends the stamp and the watch only sends its list back if
+// the copy is stale; saving sends only the entries that changed, against the
+// hash of the copy, or nothing if the list is the same.
+
+var STORAGE_KEY = 'favoritesSync';
+
+// The update on its way to the watch; the copy only follows once every
+// message of it was acked
+var sending = null;
+
+// FNV-1a over every field, as a signed 32 bit AppMessage integer; 0 is
+// reserved for lists that were never synced
+function hashFavorites(favorites) {
+    var hash = 0x811c9dc5;
+    favorites.forEach(function(fav) {
+        var text = fav.id + '\u0000' + fav.name + '\u0000' + fav.label + '\u0001';
+        for (var i = 0; i < text.length; i++) {
+            hash ^= text.charCodeAt(i);
+            hash = Math.imul(hash, 0x01000193);
+        }
+    });
+    return (hash | 0) || 1;
+}
+
+function sameFavorite(a, b) {
+    return !!a && !!b && a.id === b.id && a.name === b.name && a.label === b.label;
+}
+
+function loadCopy() {
+    if (typeof localStorage === 'undefined') {
+        return null;
+    }
+    try {
+        return JSON.parse(localStorage.getItem(STORAGE_KEY));
+    } catch (e) {
+        return null;
+    }
+}
+
+function saveCopy(copy) {
+    if (typeof localStorage === 'undefined') {
+        return;
+    }
+    if (copy) {
+        localStorage.setItem(STORAGE_KEY, JSON.stringify(copy));
+    } else {
+        localStorage.removeItem(STORAGE_KEY);
+    }
+}
+
+// REQUEST_FAVORITES message; carries the stamp of the copy if there is one
+function buildRequest() {
+    var copy = loadCopy();
+    var message = { 'REQUEST_FAVORITES': 1 };
+    if (copy) {
+        message.FAVORITES_VERSION = copy.version;
+        message.FAVORITES_HASH = copy.hash;
+    }
+    return message;
+}
+
+// Messages that turn the watch's list into `favorites`: a header, then one
+// message per changed entry. Empty if the watch already has this list. With
+// `full` every entry is sent and the watch ignores its own list; its
+// version follows `afterVersion`.
+function buildUpdate(favorites, full, afterVersion) {
+    var copy = full ? null : loadCopy();
+    var hash = hashFavorites(favorites);
+    if (copy && copy.hash === hash && copy.favorites.length === favorites.length) {
+        return [];
+    }
+
+    var entries = [];
+    favorites.forEach(function(fav, index) {
+        if (!copy || !sameFavorite(copy.favorites[index], fav)) {
+            entries.push({
+                'FAVORITE_DESTINATION_ID': fav.id,
+                'FAVORITE_DESTINATION_NAME': fav.name,
+                'FAVORITE_DESTINATION_LABEL': fav.label,
+                'FAVORITE_INDEX': index
+            });
+        }
+    });
+
+    var header = {
+        'NUM_FAVORITES': favorites.length,
+        'FAVORITE_CHANGES': entries.length,
+        'FAVORITES_VERSION': ((copy ? copy.version : afterVersion || 0) + 1) & 0xFFFF,
+        'FAVORITES_HASH': hash
+    };
+    if (copy) {
+        header.FAVORITES_BASE_HASH = copy.hash;
+    }
+    return [header].concat(entries);
+}
+
+// buildUpdate's messages are about to be sent
+function startUpdate(messages, favorites) {
+    sending = { messages: messages, favorites: favorites };
+}
+
+// The watch acked every message of the update, so it stores what was sent;
+// an update a later one replaced leaves the copy alone
+function commitUpdate(messages) {
+    if (!sending || sending.messages !== messages) {
+        return;
+    }
+    saveCopy({
+        version: messages[0].FAVORITES_VERSION,
+        hash: messages[0].FAVORITES_HASH,
+        favorites: sending.favorites
+    });
+    sending = null;
+}
+
+// The watch's answer to REQUEST_FAVORITES: its list, or the copy if the
+// watch found it current
+function receivedList(header, favorites) {
+    var copy = loadCopy();
+    if (header.FAVORITE_CHANGES === 0 && copy && copy.hash === header.FAVORITES_HASH) {
+        return copy.favorites;
+    }
+    if (header.FAVORITES_HASH !== undefined) {
+        saveCopy({
+            version: header.FAVORITES_VERSION,
+            hash: header.FAVORITES_HASH,
+            favorites: favorites
+        });
+    }
+    return favorites;
+}
+
+// The copy's list, for when the watch doesn't answer
+function copiedFavorites() {
+    var copy = loadCopy();
+    return copy ? copy.favorites : [];
+}
+
+// The watch dropped a delta made against another list; `stamp` is the
+// version and hash it has instead. Returns the full update for the list the
+// phone last sent, past both the phone's and the watch's version, or
+// nothing if there is none.
+function handleRejected(stamp) {
+    var copy = loadCopy();
+    saveCopy(null);
+    var favorites = sending ? sending.favorites : copy && copy.favorites;
+    if (!favorites) {
+        return [];
+    }
+    var version = sending ? sending.messages[0].FAVORITES_VERSION : copy.version;
+    if (stamp && stamp.FAVORITES_VERSION > version) {
+        version = stamp.FAVORITES_VERSION;
+    }
+    var messages = buildUpdate(favorites, true, version);
+    startUpdate(messages, favorites);
+    return messages;
+}
+
+module.exports = {
+    hashFavorites: hashFavorites,
+    buildRequest: buildRequest,
+    buildUpdate: buildUpdate,
+    startUpdate: startUpdate,
+    commitUpdate: commitUpdate,
+    receivedList: receivedList,
+    copiedFavorites: copiedFavorites,
+    handleRejected: handleRejected
+};
@@ -1,8 +1,36 @@
 var messageHandler = require('./message_handler');
+var transport = require('./transport');
+var trace = require('./trace');
+var favoritesSync = require('./favorites_sync');
 var configFavorites = [];
+var configFavoritesHeader = null;
+var configFavoritesReceived = 0;
 var configFavoritesExpected = 0;
+var configFavoritesComplete = false;
 var configPagePending = false;
 
+// The phone's copy of the list only changes once the watch acked all of it
+function sendFavoriteMessages(messages) {
+    var pending = messages.length;
+    messages.forEach(function(message) {
+        transport.send(message, transport.PRIORITY_LOW).then(function() {
+            if (--pending === 0) {
+                favoritesSync.commitUpdate(messages);
+            }
+        }, function(e) {
+            console.error('Failed to send favorites message:', e);
+        });
+    });
+}
+
+function finishConfigFavorites() {
+    configFavorites = favoritesSync.receivedList(configFavoritesHeader, configFavorites);
+    configFavoritesComplete = true;
+    if (configPagePending) {
+        openConfigPage();
+    }
+}
+
 Pebble.addEventListener('ready', function(event) {
     console.log('PebbleKit JS ready!');
 });
@@ -10,37 +38,54 @@ Pebble.addEventListener('ready', function(event) {
 Pebble.addEventListener('appmessage', function(event) {
     var message = event.payload;
 
-    // Check if this is favorite data for configuration page
+    // Check if this is favorite data for configuration page. The watch
+    // sends its list only if the phone's copy is stale (FAVORITE_CHANGES)
     if (message.NUM_FAVORITES !== undefined) {
-        console.log('Expecting ' + message.NUM_FAVORITES + ' favorites from watch');
-        configFavoritesExpected = message.NUM_FAVORITES;
+        configFavoritesHeader = message;
+        configFavoritesExpected = message.FAVORITE_CHANGES !== undefined ?
+            message.FAVORITE_CHANGES : message.NUM_FAVORITES;
+        configFavoritesReceived = 0;
         configFavorites = [];
+        console.log('Expecting ' + configFavoritesExpected + ' of ' +
+            message.NUM_FAVORITES + ' favorites from watch');
 
-        // If expecting 0 favorites and config page pending, open immediately
-        if (configFavoritesExpected === 0 && configPagePending) {
-            openConfigPage();
+        if (configFavoritesExpected === 0) {
+            finishConfigFavorites();
         }
         return;
     }
 
+    // The watch dropped a delta made against another list
+    if (message.FAVORITES_HASH !== undefined) {
+        console.log('Watch has other favorites, sending the full list');
+        sendFavoriteMessages(favoritesSync.handleRejected(message));
+        return;
+    }
+
     if (message.FAVORITE_DESTINATION_ID !== undefined &&
         message.FAVORITE_DESTINATION_NAME !== undefined &&
         message.FAVORITE_DESTINATION_LABEL !== undefined) {
 
-        configFavorites.push({
+        var index = message.FAVORITE_INDEX !== undefined ? message.FAVORITE_INDEX : configFavoritesReceived;
+        configFavorites[index] = {
             id: message.FAVORITE_DESTINATION_ID,
             name: message.FAVORITE_DESTINATION_NAME,
             label: message.FAVORITE_DESTINATION_LABEL
-        });
+        };
         console.log('Received favorite: ' + message.FAVORITE_DESTINATION_LABEL);
 
-        // If we have all favorites and config page pending, open it
-        if (configFavorites.length === configFavoritesExpected && configPagePending) {
-            openConfigPage();
+        // Once we have all favorites, open the page if it is waiting
+        if (++configFavoritesReceived === configFavoritesExpected) {
+            finishConfigFavorites();
         }
         return;
     }
 
+    if (message.TRACE_DATA !== undefined) {
+        trace.handleTraceData(message.TRACE_DATA);
+        return;
+    }
+
     // Otherwise handle normally
     messageHandler.handleAppMessage(event);
 });
@@ -48,6 +93,11 @@ Pebble.addEventListener('appmessage', function(event) {
 function openConfigPage() {
     configPagePending = false;
 
+    // The watch didn't answer in time; its list is most likely the copy
+    if (!configFavoritesComplete) {
+        configFavorites = favoritesSync.copiedFavorites();
+    }
+
     var url = 'https://albertgstoehl.github.io/pebble-sbb/config.html';
     if (configFavorites.length > 0) {
         url += '?favorites=' + encodeURIComponent(JSON.stringify(configFavorites));
@@ -63,14 +113,15 @@ Pebble.addEventListener('showConfiguration', function(event) {
 
     // Reset state
     configFavorites = [];
+    configFavoritesHeader = null;
+    configFavoritesReceived = 0;
     configFavoritesExpected = 0;
+    configFavoritesComplete = false;
     configPagePending = true;
 
     // Request current favorites from watch
     console.log('Sending REQUEST_FAVORITES to watch');
-    Pebble.sendAppMessage({
-        'REQUEST_FAVORITES': 1
-    }, function() {
+    transport.send(favoritesSync.buildRequest(), transport.PRIORITY_HIGH).then(function() {
         console.log('REQUEST_FAVORITES sent successfully');
     }, function(e) {
         console.error('Failed to send REQUEST_FAVORITES:', e);
@@ -103,37 +154,29 @@ Pebble.addEventListener('webviewclosed', function(event) {
         var configData = JSON.parse(decodeURIComponent(event.response));
         console.log('Received config data:', JSON.stringify(configData));
 
-        // Send favorites to watch with delays between messages
-        if (configData.favorites && configData.favorites.length > 0) {
-            console.log('Sending ' + configData.favorites.length + ' favorites to watch');
-
-            // Send number of favorites first
-            Pebble.sendAppMessage({
-                'NUM_FAVORITES': configData.favorites.length
-            }, function() {
-                console.log('Sent NUM_FAVORITES successfully');
-            }, function(e) {
-                console.error('Failed to send NUM_FAVORITES:', e);
-            });
-
-            // Send each favorite with delay
-            configData.favorites.forEach(function(fav, index) {
-                setTimeout(function() {
-                    console.log('Sending favorite ' + (index + 1) + ':', fav.label);
-                    Pebble.sendAppMessage({
-                        'FAVORITE_DESTINATION_ID': fav.id,
-                        'FAVORITE_DESTINATION_NAME': fav.name,
-                        'FAVORITE_DESTINATION_LABEL': fav.label
-                    }, function() {
-                        console.log('Successfully sent: ' + fav.label);
-                    }, function(e) {
-                        console.error('Failed to send ' + fav.label + ':', e);
-                    });
-                }, (index + 1) * 100); // 100ms delay between each
-            });
+        // Send the changed favorites to watch in the background lane; each
+        // message goes out as soon as the previous one is acked
+        if (configData.favorites) {
+            var messages = favoritesSync.buildUpdate(configData.favorites);
+            if (messages.length === 0) {
+                console.log('Favorites unchanged, nothing to send');
+            } else {
+                console.log('Sending ' + (messages.length - 1) + ' of ' +
+                    configData.favorites.length + ' favorites to watch');
+                favoritesSync.startUpdate(messages, configData.favorites);
+                sendFavoriteMessages(messages);
+            }
         } else {
             console.log('No favorites to send');
         }
+
+        // Only on request from the page's diagnostics section: the dump is
+        // several messages the favorites would otherwise queue behind
+        if (configData.dumpTrace) {
+            trace.requestTrace().then(null, function(e) {
+                console.error('Failed to send REQUEST_TRACE:', e);
+            });
+        }
     } catch (error) {
         console.error('Error parsing config data:', error);
     }
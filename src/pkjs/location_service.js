@@ -1,49 +1,124 @@
 var sbbApi = require('./sbb_api');
+var stationIndex = require('./station_index');
+var bundledStations = require('./stations.json');
 
-var lastKnownStations = [];
-var lastGPSTime = 0;
+// A fix the phone already has is reused for this long
 var GPS_CACHE_DURATION = 10 * 60 * 1000; // 10 minutes
 
-function requestNearbyStations(callback) {
-    var now = Date.now();
+// Nearby stations are also kept in localStorage per tile of about
+// 550 x 370 m, so a fix near a place seen before is answered without an API
+// call, even after PebbleKit JS restarts. Distances stay those measured from
+// the fix that filled the tile.
+var TILE_DEGREES = 0.005;
+var TILE_CACHE_DURATION = 7 * 24 * 60 * 60 * 1000; // 7 days
+var TILE_CACHE_MAX_TILES = 32;
+var TILE_KEY_PREFIX = 'geotile:';
+var TILE_INDEX_KEY = 'geotiles';
+
+// Bundled stations answer a fix without the network only where they are
+// dense enough to be the complete list: a full page of them close by. The
+// bundled list holds main stations only, so elsewhere the API has the local
+// stops; if it fails, bundled stations within a walk are better than nothing.
+var LOCAL_STATION_RADIUS_M = 1000;
+var LOCAL_STATION_COUNT = 10;
+var OFFLINE_STATION_RADIUS_M = 5000;
+var localStations = null;
+var localIndex = null;
+
+function nearbyLocalStations(lat, lon, maxMeters) {
+    if (!localIndex) {
+        localIndex = stationIndex.buildIndex(localStations || bundledStations);
+    }
+    return stationIndex.nearest(localIndex, lat, lon, LOCAL_STATION_COUNT, maxMeters);
+}
+
+function tileKey(lat, lon) {
+    return TILE_KEY_PREFIX + Math.floor(lat / TILE_DEGREES) + ',' + Math.floor(lon / TILE_DEGREES);
+}
 
-    // Return cached stations if recent
-    if (lastKnownStations.length > 0 && (now - lastGPSTime) < GPS_CACHE_DURATION) {
-        console.log('Using cached nearby stations');
-        callback(null, lastKnownStations);
+function readJSON(key) {
+    if (typeof localStorage === 'undefined') {
+        return null;
+    }
+    try {
+        return JSON.parse(localStorage.getItem(key));
+    } catch (e) {
+        return null;
+    }
+}
+
+function loadTile(key, now) {
+    var tile = readJSON(key);
+    if (!tile || !tile.stations || now - tile.storedAt >= TILE_CACHE_DURATION) {
+        return null;
+    }
+    return tile.stations;
+}
+
+// Most recently stored last; the oldest tiles are dropped past the limit
+function storeTile(key, stations, now) {
+    if (typeof localStorage === 'undefined') {
         return;
     }
+    var index = (readJSON(TILE_INDEX_KEY) || []).filter(function(existing) {
+        return existing !== key;
+    });
+    index.push(key);
+    while (index.length > TILE_CACHE_MAX_TILES) {
+        localStorage.removeItem(index.shift());
+    }
+    try {
+        localStorage.setItem(key, JSON.stringify({ storedAt: now, stations: stations }));
+        localStorage.setItem(TILE_INDEX_KEY, JSON.stringify(index));
+    } catch (e) {
+        console.error('Could not store station tile:', e);
+    }
+}
+
+function requestNearbyStations(callback) {
+    var now = Date.now();
 
-    // Request GPS location
+    // Stations are only cached per tile, so they always match the fix
     navigator.geolocation.getCurrentPosition(
         function(position) {
             var lat = position.coords.latitude;
             var lon = position.coords.longitude;
             console.log('GPS: ' + lat + ', ' + lon);
 
+            var key = tileKey(lat, lon);
+            var tileStations = loadTile(key, now);
+            if (tileStations) {
+                console.log('Using stations cached for ' + key);
+                callback(null, tileStations);
+                return;
+            }
+
+            var local = nearbyLocalStations(lat, lon, LOCAL_STATION_RADIUS_M);
+            if (local.length === LOCAL_STATION_COUNT) {
+                console.log('Using ' + local.length + ' bundled stations');
+                callback(null, local);
+                return;
+            }
+
             sbbApi.fetchNearbyStations(lat, lon, function(err, stations) {
                 if (err) {
-                    // If error but have cached data, return cached
-                    if (lastKnownStations.length > 0) {
-                        callback(null, lastKnownStations);
+                    var offline = nearbyLocalStations(lat, lon, OFFLINE_STATION_RADIUS_M);
+                    if (offline.length > 0) {
+                        console.log('API failed, using ' + offline.length + ' bundled stations');
+                        callback(null, offline);
                     } else {
                         callback(err, null);
                     }
                 } else {
-                    lastKnownStations = stations;
-                    lastGPSTime = now;
+                    storeTile(key, stations, now);
                     callback(null, stations);
                 }
             });
         },
         function(error) {
             console.error('GPS error:', error);
-            // Return cached stations if available
-            if (lastKnownStations.length > 0) {
-                callback(null, lastKnownStations);
-            } else {
-                callback(error, null);
-            }
+            // Without a position no cached list is known to be nearby
+            callback(error, null);
         },
         {
             timeout: 10000,
@@ -54,16 +129,26 @@ function requestNearbyStations(callback) {
 }
 
 function _clearCache() {
-    lastKnownStations = [];
-    lastGPSTime = 0;
+    var index = readJSON(TILE_INDEX_KEY);
+    if (index) {
+        index.forEach(function(key) {
+            localStorage.removeItem(key);
+        });
+        localStorage.removeItem(TILE_INDEX_KEY);
+    }
 }
 
-function _expireCache() {
-    lastGPSTime = 0;
+// Replaces the bundled station list, e.g. with a test fixture
+function _useStations(rows) {
+    localStations = rows;
+    localIndex = null;
 }
 
 module.exports = {
     requestNearbyStations: requestNearbyStations,
+    TILE_CACHE_DURATION: TILE_CACHE_DURATION,
+    TILE_CACHE_MAX_TILES: TILE_CACHE_MAX_TILES,
+    LOCAL_STATION_COUNT: LOCAL_STATION_COUNT,
     _clearCache: _clearCache,
-    _expireCache: _expireCache
+    _useStations: _useStations
 };
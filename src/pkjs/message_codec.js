@@ -0,0 +1,395 @@
+// Generated by tools/gen_codec.js from protocol/messages.json - do not edit.
+
+var SCHEMA_VERSION = 4;
+
+function clampInt(value, min, max) {
+    var n = Math.floor(Number(value) || 0);
+    return n < min ? min : (n > max ? max : n);
+}
+
+function writeInt(out, value, bytes, min, max) {
+    var n = clampInt(value, min, max);
+    for (var i = 0; i < bytes; i++) {
+        out.push(n & 0xFF);
+        n = Math.floor(n / 256);
+    }
+}
+
+// UTF-8 encode, truncated on a character boundary so the watch can store
+// it with a terminator in a maxBytes-sized buffer
+function writeString(out, value, maxBytes) {
+    var str = value === undefined || value === null ? '' : String(value);
+    var bytes = [];
+    for (var i = 0; i < str.length; i++) {
+        var code = str.charCodeAt(i);
+        if (code >= 0xD800 && code <= 0xDBFF && i + 1 < str.length) {
+            code = 0x10000 + ((code - 0xD800) << 10) + (str.charCodeAt(++i) - 0xDC00);
+        }
+        var encoded;
+        if (code < 0x80) {
+            encoded = [code];
+        } else if (code < 0x800) {
+            encoded = [0xC0 | (code >> 6), 0x80 | (code & 0x3F)];
+        } else if (code < 0x10000) {
+            encoded = [0xE0 | (code >> 12), 0x80 | ((code >> 6) & 0x3F), 0x80 | (code & 0x3F)];
+        } else {
+            encoded = [0xF0 | (code >> 18), 0x80 | ((code >> 12) & 0x3F),
+                       0x80 | ((code >> 6) & 0x3F), 0x80 | (code & 0x3F)];
+        }
+        if (bytes.length + encoded.length > maxBytes - 1) {
+            break;
+        }
+        bytes.push.apply(bytes, encoded);
+    }
+    out.push(bytes.length);
+    out.push.apply(out, bytes);
+}
+
+function Reader(bytes) {
+    this.bytes = bytes;
+    this.pos = 0;
+}
+
+Reader.prototype.take = function(count) {
+    if (this.pos + count > this.bytes.length) {
+        throw new Error('Truncated payload');
+    }
+    var start = this.pos;
+    this.pos += count;
+    return start;
+};
+
+Reader.prototype.readInt = function(bytes, signed) {
+    var start = this.take(bytes);
+    var n = 0;
+    for (var i = bytes - 1; i >= 0; i--) {
+        n = n * 256 + this.bytes[start + i];
+    }
+    var limit = Math.pow(2, bytes * 8);
+    return signed && n >= limit / 2 ? n - limit : n;
+};
+
+Reader.prototype.readString = function() {
+    var length = this.readInt(1, false);
+    var start = this.take(length);
+    var escaped = '';
+    for (var i = start; i < start + length; i++) {
+        escaped += '%' + ('0' + this.bytes[i].toString(16)).slice(-2);
+    }
+    return decodeURIComponent(escaped);
+};
+
+function encodeSectionInto(out, value) {
+    writeString(out, value.departureStation, 32);
+    writeString(out, value.arrivalStation, 32);
+    writeInt(out, value.departureTime, 4, 0, 4294967295);
+    writeInt(out, value.arrivalTime, 4, 0, 4294967295);
+    writeString(out, value.platform, 8);
+    writeString(out, value.trainType, 16);
+    writeInt(out, value.delayMinutes, 2, -32768, 32767);
+    return out;
+}
+
+function encodeSection(value) {
+    return encodeSectionInto([], value);
+}
+
+function readSection(reader) {
+    var value = {};
+    value.departureStation = reader.readString();
+    value.arrivalStation = reader.readString();
+    value.departureTime = reader.readInt(4, false);
+    value.arrivalTime = reader.readInt(4, false);
+    value.platform = reader.readString();
+    value.trainType = reader.readString();
+    value.delayMinutes = reader.readInt(2, true);
+    return value;
+}
+
+function decodeSection(bytes) {
+    var reader = new Reader(bytes);
+    return readSection(reader);
+}
+
+function encodeConnectionInto(out, value) {
+    writeInt(out, value.departureTime, 4, 0, 4294967295);
+    writeInt(out, value.arrivalTime, 4, 0, 4294967295);
+    writeInt(out, value.totalDelayMinutes, 2, -32768, 32767);
+    writeInt(out, value.numChanges, 1, 0, 255);
+    var sections = (value.sections || []).slice(0, 5);
+    out.push(sections.length);
+    for (var i = 0; i < sections.length; i++) {
+        encodeSectionInto(out, sections[i]);
+    }
+    return out;
+}
+
+function encodeConnection(value) {
+    return encodeConnectionInto([], value);
+}
+
+function readConnection(reader) {
+    var value = {};
+    value.departureTime = reader.readInt(4, false);
+    value.arrivalTime = reader.readInt(4, false);
+    value.totalDelayMinutes = reader.readInt(2, true);
+    value.numChanges = reader.readInt(1, false);
+    var sectionsCount = reader.readInt(1, false);
+    value.sections = [];
+    for (var i = 0; i < sectionsCount; i++) {
+        value.sections.push(readSection(reader));
+    }
+    return value;
+}
+
+function decodeConnection(bytes) {
+    var reader = new Reader(bytes);
+    return readConnection(reader);
+}
+
+function encodeConnectionBatchInto(out, value) {
+    writeInt(out, value.firstIndex, 1, 0, 255);
+    writeInt(out, value.total, 1, 0, 255);
+    writeInt(out, value.version, 1, 0, 255);
+    var connections = (value.connections || []).slice(0, 5);
+    out.push(connections.length);
+    for (var i = 0; i < connections.length; i++) {
+        encodeConnectionInto(out, connections[i]);
+    }
+    return out;
+}
+
+function encodeConnectionBatch(value) {
+    return encodeConnectionBatchInto([SCHEMA_VERSION], value);
+}
+
+function readConnectionBatch(reader) {
+    var value = {};
+    value.firstIndex = reader.readInt(1, false);
+    value.total = reader.readInt(1, false);
+    value.version = reader.readInt(1, false);
+    var connectionsCount = reader.readInt(1, false);
+    value.connections = [];
+    for (var i = 0; i < connectionsCount; i++) {
+        value.connections.push(readConnection(reader));
+    }
+    return value;
+}
+
+function decodeConnectionBatch(bytes) {
+    var reader = new Reader(bytes);
+    if (reader.readInt(1, false) !== SCHEMA_VERSION) {
+        throw new Error('Unsupported schema version');
+    }
+    return readConnectionBatch(reader);
+}
+
+function encodeSectionUpdateInto(out, value) {
+    writeInt(out, value.delayMinutes, 2, -32768, 32767);
+    writeString(out, value.platform, 8);
+    return out;
+}
+
+function encodeSectionUpdate(value) {
+    return encodeSectionUpdateInto([], value);
+}
+
+function readSectionUpdate(reader) {
+    var value = {};
+    value.delayMinutes = reader.readInt(2, true);
+    value.platform = reader.readString();
+    return value;
+}
+
+function decodeSectionUpdate(bytes) {
+    var reader = new Reader(bytes);
+    return readSectionUpdate(reader);
+}
+
+function encodeConnectionUpdateInto(out, value) {
+    writeInt(out, value.index, 1, 0, 255);
+    writeInt(out, value.from, 1, 0, 255);
+    writeInt(out, value.totalDelayMinutes, 2, -32768, 32767);
+    var sections = (value.sections || []).slice(0, 5);
+    out.push(sections.length);
+    for (var i = 0; i < sections.length; i++) {
+        encodeSectionUpdateInto(out, sections[i]);
+    }
+    return out;
+}
+
+function encodeConnectionUpdate(value) {
+    return encodeConnectionUpdateInto([], value);
+}
+
+function readConnectionUpdate(reader) {
+    var value = {};
+    value.index = reader.readInt(1, false);
+    value.from = reader.readInt(1, false);
+    value.totalDelayMinutes = reader.readInt(2, true);
+    var sectionsCount = reader.readInt(1, false);
+    value.sections = [];
+    for (var i = 0; i < sectionsCount; i++) {
+        value.sections.push(readSectionUpdate(reader));
+    }
+    return value;
+}
+
+function decodeConnectionUpdate(bytes) {
+    var reader = new Reader(bytes);
+    return readConnectionUpdate(reader);
+}
+
+function encodeConnectionPatchInto(out, value) {
+    writeInt(out, value.baseVersion, 1, 0, 255);
+    writeInt(out, value.version, 1, 0, 255);
+    writeInt(out, value.total, 1, 0, 255);
+    var updates = (value.updates || []).slice(0, 5);
+    out.push(updates.length);
+    for (var i = 0; i < updates.length; i++) {
+        encodeConnectionUpdateInto(out, updates[i]);
+    }
+    return out;
+}
+
+function encodeConnectionPatch(value) {
+    return encodeConnectionPatchInto([SCHEMA_VERSION], value);
+}
+
+function readConnectionPatch(reader) {
+    var value = {};
+    value.baseVersion = reader.readInt(1, false);
+    value.version = reader.readInt(1, false);
+    value.total = reader.readInt(1, false);
+    var updatesCount = reader.readInt(1, false);
+    value.updates = [];
+    for (var i = 0; i < updatesCount; i++) {
+        value.updates.push(readConnectionUpdate(reader));
+    }
+    return value;
+}
+
+function decodeConnectionPatch(bytes) {
+    var reader = new Reader(bytes);
+    if (reader.readInt(1, false) !== SCHEMA_VERSION) {
+        throw new Error('Unsupported schema version');
+    }
+    return readConnectionPatch(reader);
+}
+
+function encodeStationInto(out, value) {
+    writeString(out, value.id, 16);
+    writeString(out, value.name, 32);
+    writeInt(out, value.distance, 2, 0, 65535);
+    return out;
+}
+
+function encodeStation(value) {
+    return encodeStationInto([], value);
+}
+
+function readStation(reader) {
+    var value = {};
+    value.id = reader.readString();
+    value.name = reader.readString();
+    value.distance = reader.readInt(2, false);
+    return value;
+}
+
+function decodeStation(bytes) {
+    var reader = new Reader(bytes);
+    return readStation(reader);
+}
+
+function encodeStationListInto(out, value) {
+    var stations = (value.stations || []).slice(0, 10);
+    out.push(stations.length);
+    for (var i = 0; i < stations.length; i++) {
+        encodeStationInto(out, stations[i]);
+    }
+    return out;
+}
+
+function encodeStationList(value) {
+    return encodeStationListInto([SCHEMA_VERSION], value);
+}
+
+function readStationList(reader) {
+    var value = {};
+    var stationsCount = reader.readInt(1, false);
+    value.stations = [];
+    for (var i = 0; i < stationsCount; i++) {
+        value.stations.push(readStation(reader));
+    }
+    return value;
+}
+
+function decodeStationList(bytes) {
+    var reader = new Reader(bytes);
+    if (reader.readInt(1, false) !== SCHEMA_VERSION) {
+        throw new Error('Unsupported schema version');
+    }
+    return readStationList(reader);
+}
+
+function encodeRequestTimingInto(out, value) {
+    writeInt(out, value.requestId, 2, 0, 65535);
+    writeInt(out, value.watchTime, 4, 0, 4294967295);
+    writeInt(out, value.phoneMs, 2, 0, 65535);
+    writeInt(out, value.fetchMs, 2, 0, 65535);
+    writeInt(out, value.parseMs, 2, 0, 65535);
+    return out;
+}
+
+function encodeRequestTiming(value) {
+    return encodeRequestTimingInto([SCHEMA_VERSION], value);
+}
+
+function readRequestTiming(reader) {
+    var value = {};
+    value.requestId = reader.readInt(2, false);
+    value.watchTime = reader.readInt(4, false);
+    value.phoneMs = reader.readInt(2, false);
+    value.fetchMs = reader.readInt(2, false);
+    value.parseMs = reader.readInt(2, false);
+    return value;
+}
+
+function decodeRequestTiming(bytes) {
+    var reader = new Reader(bytes);
+    if (reader.readInt(1, false) !== SCHEMA_VERSION) {
+        throw new Error('Unsupported schema version');
+    }
+    return readRequestTiming(reader);
+}
+
+module.exports = {
+    SCHEMA_VERSION: SCHEMA_VERSION,
+    encodeSection: encodeSection,
+    encodeSectionInto: encodeSectionInto,
+    decodeSection: decodeSection,
+    encodeConnection: encodeConnection,
+    encodeConnectionInto: encodeConnectionInto,
+    decodeConnection: decodeConnection,
+    encodeConnectionBatch: encodeConnectionBatch,
+    encodeConnectionBatchInto: encodeConnectionBatchInto,
+    decodeConnectionBatch: decodeConnectionBatch,
+    encodeSectionUpdate: encodeSectionUpdate,
+    encodeSectionUpdateInto: encodeSectionUpdateInto,
+    decodeSectionUpdate: decodeSectionUpdate,
+    encodeConnectionUpdate: encodeConnectionUpdate,
+    encodeConnectionUpdateInto: encodeConnectionUpdateInto,
+    decodeConnectionUpdate: decodeConnectionUpdate,
+    encodeConnectionPatch: encodeConnectionPatch,
+    encodeConnectionPatchInto: encodeConnectionPatchInto,
+    decodeConnectionPatch: decodeConnectionPatch,
+    encodeStation: encodeStation,
+    encodeStationInto: encodeStationInto,
+    decodeStation: decodeStation,
+    encodeStationList: encodeStationList,
+    encodeStationListInto: encodeStationListInto,
+    decodeStationList: decodeStationList,
+    encodeRequestTiming: encodeRequestTiming,
+    encodeRequestTimingInto: encodeRequestTimingInto,
+    decodeRequestTiming: decodeRequestTiming
+};
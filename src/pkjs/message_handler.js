@@ -1,5 +1,25 @@
 var sbbApi = require('./sbb_api');
 var locationService = require('./location_service');
+var messageCodec = require('./message_codec');
+var transport = require('./transport');
+
+// Must match app_message_open(512, 512) in src/app_message.c
+var WATCH_INBOX_SIZE = 512;
+// Dictionary header (1 byte) plus the CONNECTION_DATA tuple header (7 bytes)
+var MAX_BATCH_BYTES = WATCH_INBOX_SIZE - 8;
+// Must match MAX_CONNECTION_RESULTS in src/data_models.h
+var MAX_CONNECTIONS = 5;
+// Must match MAX_NEARBY_STATIONS in src/data_models.h
+var MAX_STATIONS = 10;
+// Must match CONNECTION_UPDATE_ADDED in src/data_models.h
+var CONNECTION_ADDED = 0xFF;
+// Header of the REQUEST_TIMING tuple riding along with the first response
+var TUPLE_HEADER_BYTES = 7;
+
+// Last result set the watch acked in full per route, so a refresh can send
+// only what changed. Versions run 1..255; the watch reports 0 when it holds
+// nothing to patch, including a set that only partly arrived.
+var lastResults = {};
 
 function handleAppMessage(event) {
     var message = event.payload;
@@ -10,7 +30,9 @@ function handleAppMessage(event) {
     } else if (message.REQUEST_CONNECTIONS !== undefined) {
         handleConnectionsRequest(
             message.DEPARTURE_STATION_ID,
-            message.ARRIVAL_STATION_ID
+            message.ARRIVAL_STATION_ID,
+            message.CONNECTION_VERSION || 0,
+            readRequestStamp(message)
         );
     }
 }
@@ -28,28 +50,74 @@ function handleNearbyStationsRequest() {
             return;
         }
 
-        // Send stations one at a time to avoid message size limits
-        stations.forEach(function(station, index) {
-            Pebble.sendAppMessage({
-                STATION_ID: station.id,
-                STATION_NAME: station.name,
-                STATION_DISTANCE: station.distance
-            }, function() {
-                console.log('Sent station ' + (index + 1) + '/' + stations.length);
-            }, function() {
-                console.error('Failed to send station ' + station.name);
-            });
+        var payload = buildStationList(stations);
+        transport.send({
+            STATION_LIST: payload
+        }, transport.PRIORITY_HIGH).then(function() {
+            console.log('Sent ' + Math.min(stations.length, MAX_STATIONS) + ' stations');
+        }, function() {
+            console.error('Failed to send station list');
         });
     });
 }
 
-function handleConnectionsRequest(fromId, toId) {
+// Nearest first; at most MAX_STATIONS so the list always fits one message
+function buildStationList(stations) {
+    var sorted = stations.map(function(station, index) {
+        return { station: station, index: index };
+    }).sort(function(a, b) {
+        return (a.station.distance - b.station.distance) || (a.index - b.index);
+    }).map(function(entry) {
+        return entry.station;
+    });
+
+    return messageCodec.encodeStationList({
+        stations: sorted.slice(0, MAX_STATIONS)
+    });
+}
+
+// Requests that carry REQUEST_ID get their stage timings echoed back so the
+// watch can tell Bluetooth, phone and API latency apart
+function readRequestStamp(message) {
+    if (message.REQUEST_ID === undefined) {
+        return null;
+    }
+    return {
+        requestId: message.REQUEST_ID,
+        watchTime: message.REQUEST_TIME || 0,
+        receivedAt: Date.now()
+    };
+}
+
+function buildRequestTiming(stamp, timing) {
+    return messageCodec.encodeRequestTiming({
+        requestId: stamp.requestId,
+        watchTime: stamp.watchTime,
+        phoneMs: Date.now() - stamp.receivedAt,
+        fetchMs: timing ? timing.fetchMs : 0,
+        parseMs: timing ? timing.parseMs : 0
+    });
+}
+
+// The timings ride along with the first message if it still fits the inbox
+function attachRequestTiming(message, stamp, timing) {
+    if (!stamp) {
+        return;
+    }
+    var bytes = buildRequestTiming(stamp, timing);
+    var used = message.CONNECTION_DATA ? message.CONNECTION_DATA.length : message.CONNECTION_PATCH.length;
+    if (used + TUPLE_HEADER_BYTES + bytes.length <= MAX_BATCH_BYTES) {
+        message.REQUEST_TIMING = bytes;
+    }
+}
+
+function handleConnectionsRequest(fromId, toId, watchVersion, stamp) {
     if (!fromId || !toId) {
         sendError('Invalid station IDs');
         return;
     }
 
-    sbbApi.fetchConnections(fromId, toId, function(err, connections) {
+    sbbApi.fetchConnections(fromId, toId, function(err, connections, timing) {
         if (err) {
             sendError('Network error. Check connection.');
             return;
@@ -60,28 +128,231 @@ function handleConnectionsRequest(fromId, toId) {
             return;
         }
 
-        // Send first connection (we'll enhance this later for multiple)
-        var conn = connections[0];
-        Pebble.sendAppMessage({
-            CONNECTION_DATA: 1,
-            DEPARTURE_TIME: conn.departureTime,
-            ARRIVAL_TIME: conn.arrivalTime,
-            PLATFORM: conn.sections[0].platform,
-            TRAIN_TYPE: conn.sections[0].trainType,
-            DELAY_MINUTES: conn.totalDelayMinutes,
-            NUM_CHANGES: conn.numChanges
-        }, function() {
-            console.log('Sent connection data');
+        connections = connections.slice(0, MAX_CONNECTIONS);
+        var routeKey = fromId + '|' + toId;
+        var last = lastResults[routeKey];
+
+        // The watch still shows what we sent last time: patch it in place
+        if (last && watchVersion === last.version) {
+            var patch = buildConnectionPatch(last.connections, connections, last.version);
+            if (patch) {
+                var patchMessage = { CONNECTION_PATCH: patch.bytes };
+                attachRequestTiming(patchMessage, stamp, timing);
+                sendConnectionMessages([patchMessage], function() {
+                    lastResults[routeKey] = { version: patch.version, connections: connections };
+                });
+                return;
+            }
+        }
+
+        var version = last ? nextVersion(last.version) : 1;
+        var messages = buildConnectionBatches(connections, version);
+        attachRequestTiming(messages[0], stamp, timing);
+        sendConnectionMessages(messages, function() {
+            lastResults[routeKey] = { version: version, connections: connections };
+        });
+    });
+}
+
+function nextVersion(version) {
+    return version % 255 + 1;
+}
+
+// A departure keeps its identity across refreshes even when it is delayed,
+// since departureTime is the scheduled time
+function connectionKey(conn) {
+    var first = conn.sections && conn.sections[0];
+    return conn.departureTime + '|' + (first ? first.trainType : '');
+}
+
+// Anything the patch can't express means the departure is resent in full
+function sameJourney(a, b) {
+    var aSections = a.sections || [];
+    var bSections = b.sections || [];
+    if (a.arrivalTime !== b.arrivalTime || a.numChanges !== b.numChanges ||
+        aSections.length !== bSections.length) {
+        return false;
+    }
+    return aSections.every(function(section, i) {
+        var other = bSections[i];
+        return section.departureStation === other.departureStation &&
+            section.arrivalStation === other.arrivalStation &&
+            section.departureTime === other.departureTime &&
+            section.arrivalTime === other.arrivalTime &&
+            section.trainType === other.trainType;
+    });
+}
+
+function sectionsChanged(a, b) {
+    return (a.sections || []).some(function(section, i) {
+        var other = b.sections[i];
+        return (section.delayMinutes || 0) !== (other.delayMinutes || 0) ||
+            (section.platform || '') !== (other.platform || '');
+    });
+}
+
+// Diff two result sets into one CONNECTION_PATCH message. Kept departures
+// are listed only if they moved or their delay/platform changed; new ones
+// are followed by their full connection record. Returns null when the patch
+// would not fit the inbox or kept departures changed order, in which case
+// the caller sends the whole set instead.
+function buildConnectionPatch(previous, connections, baseVersion) {
+    var used = [];
+    var updates = [];
+    var lastFrom = -1;
+    var changed = connections.length !== previous.length;
+
+    for (var index = 0; index < connections.length; index++) {
+        var conn = connections[index];
+        var key = connectionKey(conn);
+        var from = -1;
+        for (var i = 0; i < previous.length; i++) {
+            if (!used[i] && connectionKey(previous[i]) === key && sameJourney(previous[i], conn)) {
+                from = i;
+                break;
+            }
+        }
+
+        if (from === -1) {
+            updates.push({ index: index, from: CONNECTION_ADDED, totalDelayMinutes: conn.totalDelayMinutes,
+                           sections: [], connection: conn });
+            continue;
+        }
+        if (from < lastFrom) {
+            return null;
+        }
+        used[from] = true;
+        lastFrom = from;
+
+        var old = previous[from];
+        var fieldsChanged = sectionsChanged(old, conn);
+        if (from !== index || fieldsChanged ||
+            (old.totalDelayMinutes || 0) !== (conn.totalDelayMinutes || 0)) {
+            updates.push({
+                index: index,
+                from: from,
+                totalDelayMinutes: conn.totalDelayMinutes,
+                sections: fieldsChanged ? conn.sections : []
+            });
+        }
+    }
+
+    changed = changed || updates.length > 0;
+    var version = changed ? nextVersion(baseVersion) : baseVersion;
+    var bytes = messageCodec.encodeConnectionPatch({
+        baseVersion: baseVersion,
+        version: version,
+        total: connections.length,
+        updates: []
+    });
+    // The updates are a streamed list: fix up the count, then append each
+    // entry, with the full record after departures that are new
+    bytes[bytes.length - 1] = updates.length;
+    updates.forEach(function(update) {
+        messageCodec.encodeConnectionUpdateInto(bytes, update);
+        if (update.from === CONNECTION_ADDED) {
+            messageCodec.encodeConnectionInto(bytes, update.connection);
+        }
+    });
+
+    if (bytes.length > MAX_BATCH_BYTES) {
+        return null;
+    }
+    return { version: version, bytes: bytes };
+}
+
+// First message carries only the first connection so the watch can render
+// it immediately; the rest are packed into as few messages as fit the inbox
+function buildConnectionBatches(connections, version) {
+    var total = Math.min(connections.length, MAX_CONNECTIONS);
+    connections = connections.slice(0, total).map(function(conn) {
+        return fitConnection(conn, total, version);
+    });
+    var messages = [{
+        CONNECTION_DATA: messageCodec.encodeConnectionBatch({
+            firstIndex: 0,
+            total: total,
+            version: version,
+            connections: connections.slice(0, 1)
+        })
+    }];
+
+    var index = 1;
+    while (index < total) {
+        var count = 1;
+        var bytes = encodeBatch(connections, index, count, total, version);
+        while (index + count < total) {
+            var larger = encodeBatch(connections, index, count + 1, total, version);
+            if (larger.length > MAX_BATCH_BYTES) {
+                break;
+            }
+            bytes = larger;
+            count++;
+        }
+        messages.push({ CONNECTION_DATA: bytes });
+        index += count;
+    }
+    return messages;
+}
+
+// Every connection has to fit a message on its own. Five legs with long
+// station names don't; the names are the only fields long enough to matter,
+// so they are shortened until the connection fits.
+function fitConnection(conn, total, version) {
+    var fitted = conn;
+    var limit = 31;  // Characters; the codec keeps at most 31 bytes
+    while (limit > 0 && encodeBatch([fitted], 0, 1, total, version).length > MAX_BATCH_BYTES) {
+        fitted = shortenStationNames(conn, limit--);
+    }
+    return fitted;
+}
+
+function shortenStationNames(conn, limit) {
+    var copy = {};
+    Object.keys(conn).forEach(function(key) {
+        copy[key] = conn[key];
+    });
+    copy.sections = (conn.sections || []).map(function(section) {
+        var shortened = {};
+        Object.keys(section).forEach(function(key) {
+            shortened[key] = section[key];
+        });
+        shortened.departureStation = String(section.departureStation || '').slice(0, limit);
+        shortened.arrivalStation = String(section.arrivalStation || '').slice(0, limit);
+        return shortened;
+    });
+    return copy;
+}
+
+function encodeBatch(connections, firstIndex, count, total, version) {
+    return messageCodec.encodeConnectionBatch({
+        firstIndex: firstIndex,
+        total: total,
+        version: version,
+        connections: connections.slice(firstIndex, firstIndex + count)
+    });
+}
+
+// The transport sends each message as soon as the previous one is acked;
+// onDelivered runs once the watch acked every one of them
+function sendConnectionMessages(messages, onDelivered) {
+    var pending = messages.length;
+    messages.forEach(function(message, index) {
+        transport.send(message, transport.PRIORITY_HIGH).then(function() {
+            console.log('Sent connection data ' + (index + 1) + '/' + messages.length);
+            if (--pending === 0) {
+                onDelivered();
+            }
         }, function() {
-            console.error('Failed to send connection data');
+            console.error('Failed to send connection data ' + (index + 1) + '/' + messages.length);
         });
     });
 }
 
 function sendError(message) {
-    Pebble.sendAppMessage({
+    transport.send({
         ERROR_MESSAGE: message
-    }, function() {
+    }, transport.PRIORITY_HIGH).then(function() {
         console.log('Sent error:', message);
     }, function() {
         console.error('Failed to send error message');
@@ -89,5 +360,8 @@ function sendError(message) {
 }
 
 module.exports = {
-    handleAppMessage: handleAppMessage
+    handleAppMessage: handleAppMessage,
+    buildConnectionBatches: buildConnectionBatches,
+    buildConnectionPatch: buildConnectionPatch,
+    buildStationList: buildStationList
 };
@@ -35,6 +35,29 @@ var MOCK_CONNECTIONS = {
 // SBB OpenData API endpoint
 var SBB_API_BASE = 'https://transport.opendata.ch/v1';
 
+// Only the fields the transforms read; the API drops everything else
+// (pass lists, coordinates, capacities) from the response
+var STATION_FIELDS = ['stations/id', 'stations/name', 'stations/distance'];
+var CONNECTION_FIELDS = [
+    'connections/from/departure',
+    'connections/from/delay',
+    'connections/to/arrival',
+    'connections/sections/departure/station/name',
+    'connections/sections/departure/departure',
+    'connections/sections/departure/platform',
+    'connections/sections/departure/delay',
+    'connections/sections/arrival/station/name',
+    'connections/sections/arrival/arrival',
+    'connections/sections/journey/category',
+    'connections/sections/journey/number'
+];
+
+function fieldsQuery(fields) {
+    return fields.map(function(field) {
+        return '&fields[]=' + field;
+    }).join('');
+}
+
 // Fetch nearby stations based on coordinates
 function fetchNearbyStations(lat, lon, callback) {
     if (MOCK_MODE) {
@@ -43,7 +66,8 @@ function fetchNearbyStations(lat, lon, callback) {
         return;
     }
 
-    var url = SBB_API_BASE + '/locations?x=' + lon + '&y=' + lat + '&type=station';
+    var url = SBB_API_BASE + '/locations?x=' + lon + '&y=' + lat + '&type=station' +
+        fieldsQuery(STATION_FIELDS);
 
     fetch(url)
         .then(function(response) {
@@ -65,52 +89,156 @@ function fetchNearbyStations(lat, lon, callback) {
         });
 }
 
-// Fetch connections between two stations
+// Connection results are reused for CONNECTION_CACHE_TTL_MS within the same
+// minute, and concurrent requests for a route share one fetch
+var CONNECTION_CACHE_TTL_MS = 30 * 1000;
+var CONNECTION_CACHE_MAX_ENTRIES = 20;
+var connectionCache = {};
+var connectionsInFlight = {};
+
+function connectionCacheKey(fromId, toId, now) {
+    return fromId + '|' + toId + '|' + Math.floor(now / 60000);
+}
+
+function pruneConnectionCache(now) {
+    var keys = Object.keys(connectionCache);
+    keys.forEach(function(key) {
+        if (now - connectionCache[key].storedAt >= CONNECTION_CACHE_TTL_MS) {
+            delete connectionCache[key];
+        }
+    });
+    keys = Object.keys(connectionCache);
+    while (keys.length > CONNECTION_CACHE_MAX_ENTRIES) {
+        delete connectionCache[keys.shift()];
+    }
+}
+
+// Fetch connections between two stations. The callback also gets the
+// stage timings in ms: fetchMs until the response headers arrived, parseMs
+// for reading, parsing and transforming the JSON body; both are 0 for a cached result.
 function fetchConnections(fromId, toId, callback) {
     if (MOCK_MODE) {
         console.log('[MOCK] Returning mock connections from', fromId, 'to', toId);
-        callback(null, [MOCK_CONNECTIONS]);
+        callback(null, [MOCK_CONNECTIONS], { fetchMs: 0, parseMs: 0 });
         return;
     }
 
-    var url = SBB_API_BASE + '/connections?from=' + fromId + '&to=' + toId + '&limit=5';
+    var now = Date.now();
+    var key = connectionCacheKey(fromId, toId, now);
+    var cached = connectionCache[key];
+    if (cached && now - cached.storedAt < CONNECTION_CACHE_TTL_MS) {
+        console.log('Using cached connections for ' + fromId + ' to ' + toId);
+        callback(null, cached.connections, { fetchMs: 0, parseMs: 0 });
+        return;
+    }
 
-    fetch(url)
+    var request = connectionsInFlight[key];
+    if (!request) {
+        request = requestConnections(fromId, toId);
+        connectionsInFlight[key] = request;
+        request.then(function(result) {
+            delete connectionsInFlight[key];
+            pruneConnectionCache(Date.now());
+            connectionCache[key] = { storedAt: Date.now(), connections: result.connections };
+        }, function() {
+            delete connectionsInFlight[key];
+        });
+    }
+
+    request.then(function(result) {
+        callback(null, result.connections, result.timing);
+    }, function(error) {
+        console.error('Error fetching connections:', error);
+        callback(error, null);
+    });
+}
+
+function digits(text, start, count) {
+    var value = 0;
+    for (var i = start; i < start + count; i++) {
+        var digit = text.charCodeAt(i) - 48;
+        if (digit < 0 || digit > 9) {
+            return NaN;
+        }
+        value = value * 10 + digit;
+    }
+    return value;
+}
+
+// Unix seconds for the API's fixed "2025-11-07T14:32:00+0100" format,
+// falling back to Date for anything else
+function parseTimestamp(text) {
+    if (typeof text !== 'string' || text.length !== 24) {
+        return Math.floor(new Date(text).getTime() / 1000);
+    }
+    var seconds = Date.UTC(digits(text, 0, 4), digits(text, 5, 2) - 1, digits(text, 8, 2),
+                           digits(text, 11, 2), digits(text, 14, 2), digits(text, 17, 2)) / 1000;
+    var offset = digits(text, 20, 2) * 3600 + digits(text, 22, 2) * 60;
+    seconds += text.charAt(19) === '-' ? offset : -offset;
+    return isNaN(seconds) ? Math.floor(new Date(text).getTime() / 1000) : seconds;
+}
+
+// One pass over the response, no intermediate arrays
+function transformConnections(data) {
+    var connections = [];
+    for (var c = 0; c < data.connections.length; c++) {
+        var conn = data.connections[c];
+        var sections = [];
+        for (var s = 0; s < conn.sections.length; s++) {
+            var section = conn.sections[s];
+            var journey = section.journey;
+            sections.push({
+                departureStation: section.departure.station.name,
+                arrivalStation: section.arrival.station.name,
+                departureTime: parseTimestamp(section.departure.departure),
+                arrivalTime: parseTimestamp(section.arrival.arrival),
+                platform: section.departure.platform || 'N/A',
+                trainType: journey ? (journey.category + ' ' + journey.number) : 'Walk',
+                delayMinutes: section.departure.delay || 0
+            });
+        }
+
+        connections.push({
+            sections: sections,
+            numSections: sections.length,
+            departureTime: parseTimestamp(conn.from.departure),
+            arrivalTime: parseTimestamp(conn.to.arrival),
+            totalDelayMinutes: conn.from.delay || 0,
+            numChanges: sections.length - 1
+        });
+    }
+    return connections;
+}
+
+// Resolves with { connections, timing }
+function requestConnections(fromId, toId) {
+    var url = SBB_API_BASE + '/connections?from=' + fromId + '&to=' + toId + '&limit=5' +
+        fieldsQuery(CONNECTION_FIELDS);
+    var fetchStart = Date.now();
+    var fetchEnd = fetchStart;
+
+    return fetch(url)
         .then(function(response) {
+            fetchEnd = Date.now();
             return response.json();
         })
         .then(function(data) {
-            var connections = data.connections.map(function(conn) {
-                var sections = conn.sections.map(function(section) {
-                    return {
-                        departureStation: section.departure.station.name,
-                        arrivalStation: section.arrival.station.name,
-                        departureTime: Math.floor(new Date(section.departure.departure).getTime() / 1000),
-                        arrivalTime: Math.floor(new Date(section.arrival.arrival).getTime() / 1000),
-                        platform: section.departure.platform || 'N/A',
-                        trainType: section.journey ? (section.journey.category + ' ' + section.journey.number) : 'Walk',
-                        delayMinutes: section.departure.delay || 0
-                    };
-                });
-
-                return {
-                    sections: sections,
-                    numSections: sections.length,
-                    departureTime: Math.floor(new Date(conn.from.departure).getTime() / 1000),
-                    arrivalTime: Math.floor(new Date(conn.to.arrival).getTime() / 1000),
-                    totalDelayMinutes: conn.from.delay || 0,
-                    numChanges: sections.length - 1
-                };
-            });
-            callback(null, connections);
-        })
-        .catch(function(error) {
-            console.error('Error fetching connections:', error);
-            callback(error, null);
+            var connections = transformConnections(data);
+            var timing = { fetchMs: fetchEnd - fetchStart, parseMs: Date.now() - fetchEnd };
+            return { connections: connections, timing: timing };
         });
 }
 
+// Helper for tests
+function _clearCache() {
+    connectionCache = {};
+    connectionsInFlight = {};
+}
+
 module.exports = {
     fetchNearbyStations: fetchNearbyStations,
-    fetchConnections: fetchConnections
+    fetchConnections: fetchConnections,
+    parseTimestamp: parseTimestamp,
+    CONNECTION_CACHE_TTL_MS: CONNECTION_CACHE_TTL_MS,
+    _clearCache: _clearCache
 };
@@ -0,0 +1,119 @@
+// Grid index over a station list for nearest-station queries without the
+// network. Stations come as [id, name, lat, lon] rows (see stations.json);
+// coordinates live in one Float64Array and each grid cell holds the row
+// numbers of the stations inside it.
+
+var EARTH_RADIUS_M = 6371000;
+var DEFAULT_CELL_DEGREES = 0.05;  // About 5.5 x 3.8 km in Switzerland
+
+function toRadians(degrees) {
+    return degrees * Math.PI / 180;
+}
+
+function haversineMeters(lat1, lon1, lat2, lon2) {
+    var dLat = toRadians(lat2 - lat1);
+    var dLon = toRadians(lon2 - lon1);
+    var a = Math.sin(dLat / 2) * Math.sin(dLat / 2) +
+        Math.cos(toRadians(lat1)) * Math.cos(toRadians(lat2)) *
+        Math.sin(dLon / 2) * Math.sin(dLon / 2);
+    return 2 * EARTH_RADIUS_M * Math.asin(Math.min(1, Math.sqrt(a)));
+}
+
+function buildIndex(rows, cellDegrees) {
+    var cell = cellDegrees || DEFAULT_CELL_DEGREES;
+    var index = {
+        cellDegrees: cell,
+        ids: new Array(rows.length),
+        names: new Array(rows.length),
+        coords: new Float64Array(rows.length * 2),
+        cells: {},
+        minRow: Infinity,
+        maxRow: -Infinity,
+        minCol: Infinity,
+        maxCol: -Infinity
+    };
+
+    for (var i = 0; i < rows.length; i++) {
+        var row = rows[i];
+        index.ids[i] = String(row[0]);
+        index.names[i] = row[1];
+        index.coords[i * 2] = row[2];
+        index.coords[i * 2 + 1] = row[3];
+
+        var r = Math.floor(row[2] / cell);
+        var c = Math.floor(row[3] / cell);
+        (index.cells[r + ',' + c] = index.cells[r + ',' + c] || []).push(i);
+        index.minRow = Math.min(index.minRow, r);
+        index.maxRow = Math.max(index.maxRow, r);
+        index.minCol = Math.min(index.minCol, c);
+        index.maxCol = Math.max(index.maxCol, c);
+    }
+    return index;
+}
+
+// Lower bound in metres for any point `ring` cells away from the query cell
+function ringDistanceMeters(index, lat, ring) {
+    if (ring === 0) {
+        return 0;
+    }
+    var cellMeters = toRadians(index.cellDegrees) * EARTH_RADIUS_M;
+    return (ring - 1) * cellMeters * Math.cos(toRadians(Math.min(Math.abs(lat) + ring * index.cellDegrees, 89)));
+}
+
+// The k nearest stations within maxMeters, closest first, in the shape
+// sbb_api.fetchNearbyStations returns. Searches square rings of cells
+// outwards and stops once no unvisited cell can hold anything closer.
+function nearest(index, lat, lon, k, maxMeters) {
+    var cell = index.cellDegrees;
+    var row = Math.floor(lat / cell);
+    var col = Math.floor(lon / cell);
+    var limit = maxMeters || Infinity;
+    var found = [];
+    // Past this ring there are no occupied cells left
+    var lastRing = Math.max(row - index.minRow, index.maxRow - row, col - index.minCol, index.maxCol - col);
+
+    for (var ring = 0; ring <= lastRing; ring++) {
+        var kth = found.length >= k ? found[k - 1].distance : limit;
+        if (ringDistanceMeters(index, lat, ring) > kth) {
+            break;
+        }
+
+        for (var r = row - ring; r <= row + ring; r++) {
+            // Only the ring's border; inner cells were visited before
+            var step = (Math.abs(r - row) === ring || ring === 0) ? 1 : 2 * ring;
+            for (var c = col - ring; c <= col + ring; c += step) {
+                var members = index.cells[r + ',' + c];
+                if (!members) {
+                    continue;
+                }
+                for (var m = 0; m < members.length; m++) {
+                    var i = members[m];
+                    var distance = haversineMeters(lat, lon, index.coords[i * 2], index.coords[i * 2 + 1]);
+                    if (distance <= limit) {
+                        found.push({ index: i, distance: distance });
+                    }
+                }
+            }
+        }
+        found.sort(function(a, b) {
+            return a.distance - b.distance;
+        });
+        if (found.length > k) {
+            found.length = k;
+        }
+    }
+
+    return found.map(function(entry) {
+        return {
+            id: index.ids[entry.index],
+            name: index.names[entry.index],
+            distance: Math.round(entry.distance)
+        };
+    });
+}
+
+module.exports = {
+    buildIndex: buildIndex,
+    nearest: nearest,
+    haversineMeters: haversineMeters
+};
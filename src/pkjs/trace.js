@@ -0,0 +1,98 @@
+var transport = require('./transport');
+
+// Must match TRACE_RECORD_SIZE and TRACE_CHUNK_HEADER_SIZE in src/trace.h
+var RECORD_SIZE = 12;
+var CHUNK_HEADER_SIZE = 2;
+
+// Indexed by TraceEvent in src/trace.h
+var EVENT_NAMES = [
+    'UNKNOWN',
+    'APP_START',
+    'INBOX_RECEIVED',
+    'INBOX_DROPPED',
+    'OUTBOX_SENT',
+    'OUTBOX_RETRY',
+    'OUTBOX_GAVE_UP',
+    'CONNECTIONS_REQUESTED',
+    'CONNECTIONS_SHOWN',
+    'PATCH_APPLIED',
+    'STORAGE_FLUSH',
+    'STRING_POOL_FULL',
+    'REQUEST_LATENCY',
+    'LATENCY_SUMMARY'
+];
+
+// Indexed by LatencyStage in src/latency.h
+var LATENCY_STAGES = ['total', 'bluetooth', 'phone', 'fetch', 'parse'];
+
+// Chunks of the dump in flight; a new REQUEST_TRACE starts over
+var chunks = [];
+
+function readU32(bytes, offset) {
+    return (bytes[offset] | bytes[offset + 1] << 8 | bytes[offset + 2] << 16) +
+        bytes[offset + 3] * 0x1000000;
+}
+
+function decodeChunk(bytes) {
+    var records = [];
+    for (var offset = CHUNK_HEADER_SIZE; offset + RECORD_SIZE <= bytes.length; offset += RECORD_SIZE) {
+        var a = bytes[offset + 6] | bytes[offset + 7] << 8;
+        var event = bytes[offset + 4];
+        records.push({
+            timeMs: readU32(bytes, offset),
+            event: EVENT_NAMES[event] || EVENT_NAMES[0],
+            a: a >= 0x8000 ? a - 0x10000 : a,
+            b: readU32(bytes, offset + 8) | 0
+        });
+    }
+    return records;
+}
+
+function formatRecord(record) {
+    if (record.event === 'LATENCY_SUMMARY') {
+        return record.timeMs + ' ' + record.event + ' ' + (LATENCY_STAGES[record.a] || record.a) +
+            ' p50 ' + (record.b & 0xFFFF) + ' ms p90 ' + (record.b >>> 16) + ' ms';
+    }
+    return record.timeMs + ' ' + record.event + ' ' + record.a + ' ' + record.b;
+}
+
+// Collects TRACE_DATA chunks; once all arrived, logs and returns the
+// records oldest first. Returns null while chunks are missing.
+function handleTraceData(bytes) {
+    var index = bytes[0];
+    var count = bytes[1];
+    chunks[index] = decodeChunk(bytes);
+
+    for (var i = 0; i < count; i++) {
+        if (!chunks[i]) {
+            return null;
+        }
+    }
+
+    var records = [];
+    for (var j = 0; j < count; j++) {
+        records = records.concat(chunks[j]);
+    }
+    chunks = [];
+
+    console.log('Watch trace, ' + records.length + ' records:');
+    records.forEach(function(record) {
+        console.log('  ' + formatRecord(record));
+    });
+    return records;
+}
+
+function requestTrace() {
+    chunks = [];
+    return transport.send({
+        REQUEST_TRACE: 1
+    }, transport.PRIORITY_LOW);
+}
+
+module.exports = {
+    EVENT_NAMES: EVENT_NAMES,
+    decodeChunk: decodeChunk,
+    formatRecord: formatRecord,
+    handleTraceData: handleTraceData,
+    requestTrace: requestTrace
+};
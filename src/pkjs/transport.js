@@ -0,0 +1,98 @@
+// Ack-driven AppMessage transport. The watch can only take one message at a
+// time, so messages are queued and the next one goes out as soon as the
+// previous one is acknowledged. NACKed messages are retried with backoff.
+
+var PRIORITY_HIGH = 0;  // User-facing data (connections, stations, errors)
+var PRIORITY_LOW = 1;   // Background sync (favorites)
+
+// NACKed messages are retried with exponential backoff: 250, 500, 1000 ms
+var MAX_RETRIES = 3;
+var RETRY_BASE_DELAY_MS = 250;
+
+var lanes = [[], []];
+var inFlight = null;
+var retryTimer = null;
+
+// Returns a promise that resolves once the watch acks the message, or rejects
+// once it was NACKed MAX_RETRIES + 1 times
+function send(message, priority) {
+    return new Promise(function(resolve, reject) {
+        var lane = priority === PRIORITY_LOW ? PRIORITY_LOW : PRIORITY_HIGH;
+        lanes[lane].push({
+            message: message,
+            lane: lane,
+            attempt: 0,
+            resolve: resolve,
+            reject: reject
+        });
+        pump();
+    });
+}
+
+function nextEntry() {
+    for (var i = 0; i < lanes.length; i++) {
+        if (lanes[i].length > 0) {
+            return lanes[i].shift();
+        }
+    }
+    return null;
+}
+
+function pump() {
+    if (inFlight || retryTimer) {
+        return;
+    }
+    var entry = nextEntry();
+    if (!entry) {
+        return;
+    }
+
+    inFlight = entry;
+    Pebble.sendAppMessage(entry.message, function(event) {
+        inFlight = null;
+        entry.resolve(event);
+        pump();
+    }, function(event) {
+        inFlight = null;
+        if (entry.attempt >= MAX_RETRIES) {
+            var error = new Error('Message not acknowledged after ' + (entry.attempt + 1) + ' attempts');
+            error.event = event;
+            entry.reject(error);
+            pump();
+            return;
+        }
+
+        // Keep the failed message at the front so ordering is preserved
+        var delay = RETRY_BASE_DELAY_MS * Math.pow(2, entry.attempt);
+        entry.attempt++;
+        lanes[entry.lane].unshift(entry);
+        retryTimer = setTimeout(function() {
+            retryTimer = null;
+            pump();
+        }, delay);
+    });
+}
+
+function pending() {
+    return lanes[0].length + lanes[1].length + (inFlight ? 1 : 0);
+}
+
+// Drop everything queued; used by tests
+function reset() {
+    if (retryTimer) {
+        clearTimeout(retryTimer);
+        retryTimer = null;
+    }
+    lanes = [[], []];
+    inFlight = null;
+}
+
+module.exports = {
+    PRIORITY_HIGH: PRIORITY_HIGH,
+    PRIORITY_LOW: PRIORITY_LOW,
+    MAX_RETRIES: MAX_RETRIES,
+    RETRY_BASE_DELAY_MS: RETRY_BASE_DELAY_MS,
+    send: send,
+    pending: pending,
+    reset: reset
+};
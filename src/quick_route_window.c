@@ -1,5 +1,7 @@
 #include "quick_route_window.h"
-#include "persistence.h"
+#include "log.h"
+#include "storage.h"
+#include "marquee.h"
 
 static Window *s_window;
 static MenuLayer *s_menu_layer;
@@ -8,47 +10,12 @@ static FavoriteDestination s_favorites[MAX_FAVORITE_DESTINATIONS];
 static int s_num_favorites = 0;
 static QuickRouteCallback s_callback;
 
-// Text scrolling state
-static AppTimer *s_scroll_timer = NULL;
-static int s_scroll_offset = 0;
-static bool s_scrolling_required = false;
-static bool s_menu_reloading = false;
+static Marquee s_marquee;
 
-#define SCROLL_WAIT_MS 1000
-#define SCROLL_STEP_MS 200
 #define MENU_CHARS_VISIBLE 17
 
-static void scroll_menu_callback(void *data) {
-    s_scroll_timer = NULL;
-    s_scroll_offset++;
-
-    if (!s_scrolling_required) {
-        return;
-    }
-
-    s_menu_reloading = true;
-    s_scrolling_required = false;
-    menu_layer_reload_data(s_menu_layer);
-    s_scroll_timer = app_timer_register(SCROLL_STEP_MS, scroll_menu_callback, NULL);
-}
-
-static void initiate_menu_scroll_timer(void) {
-    s_scrolling_required = true;
-    s_scroll_offset = 0;
-    s_menu_reloading = false;
-
-    if (s_scroll_timer) {
-        app_timer_cancel(s_scroll_timer);
-    }
-    s_scroll_timer = app_timer_register(SCROLL_WAIT_MS, scroll_menu_callback, NULL);
-}
-
 static void menu_selection_changed_callback(MenuLayer *menu_layer, MenuIndex new_index, MenuIndex old_index, void *data) {
-    if (!s_menu_reloading) {
-        initiate_menu_scroll_timer();
-    } else {
-        s_menu_reloading = false;
-    }
+    marquee_restart(&s_marquee);
 }
 
 static uint16_t menu_get_num_sections_callback(MenuLayer *menu_layer, void *data) {
@@ -76,21 +43,8 @@ static void menu_draw_row_callback(GContext* ctx, const Layer *cell_layer, MenuI
         return;
     }
 
-    MenuIndex selected_index = menu_layer_get_selected_index(s_menu_layer);
-    bool is_selected = (cell_index->row == selected_index.row);
-
     FavoriteDestination *fav = &s_favorites[cell_index->row];
-
-    const char *name_to_draw = fav->name;
-    if (is_selected) {
-        int len = strlen(fav->name);
-        if (len > MENU_CHARS_VISIBLE) {
-            if (s_scroll_offset < len - MENU_CHARS_VISIBLE) {
-                name_to_draw += s_scroll_offset;
-                s_scrolling_required = true;
-            }
-        }
-    }
+    const char *name_to_draw = marquee_text(&s_marquee, cell_index, fav->name, MENU_CHARS_VISIBLE);
 
     menu_cell_basic_draw(ctx, cell_layer, fav->label, name_to_draw, NULL);
 }
@@ -102,10 +56,10 @@ static void menu_select_callback(MenuLayer *menu_layer, MenuIndex *cell_index, v
 
     FavoriteDestination *fav = &s_favorites[cell_index->row];
 
-    APP_LOG(APP_LOG_LEVEL_INFO, "Quick route destination selected: %s, popping window", fav->label);
+    LOG_INFO("Quick route destination selected: %s, popping window", fav->label);
 
     // Pop this window first
-    APP_LOG(APP_LOG_LEVEL_INFO, "Popping quick route window");
+    LOG_INFO("Popping quick route window");
     window_stack_pop(true);
 
     // Then call callback to push connection detail window
@@ -119,6 +73,7 @@ static void window_load(Window *window) {
     GRect bounds = layer_get_bounds(window_layer);
 
     s_menu_layer = menu_layer_create(bounds);
+    marquee_init(&s_marquee, s_menu_layer);
     menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks){
         .get_num_sections = menu_get_num_sections_callback,
         .get_num_rows = menu_get_num_rows_callback,
@@ -132,15 +87,20 @@ static void window_load(Window *window) {
     layer_add_child(window_layer, menu_layer_get_layer(s_menu_layer));
 
     // Load favorites
-    s_num_favorites = load_favorite_destinations(s_favorites);
-    APP_LOG(APP_LOG_LEVEL_INFO, "Quick route window loaded with %d favorites", s_num_favorites);
+    s_num_favorites = storage_get_favorite_destinations(s_favorites);
+    LOG_INFO("Quick route window loaded with %d favorites", s_num_favorites);
+}
+
+static void window_appear(Window *window) {
+    marquee_restart(&s_marquee);
+}
+
+static void window_disappear(Window *window) {
+    marquee_pause(&s_marquee);
 }
 
 static void window_unload(Window *window) {
-    if (s_scroll_timer) {
-        app_timer_cancel(s_scroll_timer);
-        s_scroll_timer = NULL;
-    }
+    marquee_deinit(&s_marquee);
     menu_layer_destroy(s_menu_layer);
 }
 
@@ -152,6 +112,8 @@ void quick_route_window_push(Station *departure_station, QuickRouteCallback call
         s_window = window_create();
         window_set_window_handlers(s_window, (WindowHandlers) {
             .load = window_load,
+            .appear = window_appear,
+            .disappear = window_disappear,
             .unload = window_unload,
         });
     }
@@ -0,0 +1,140 @@
+#include "refresh_scheduler.h"
+#include "log.h"
+
+// Every live scheduler, so one focus subscription can pause them all
+static RefreshScheduler *s_schedulers[REFRESH_MAX_SCHEDULERS];
+static int s_num_schedulers = 0;
+
+static void schedule(RefreshScheduler *scheduler);
+
+uint32_t refresh_scheduler_interval_ms(time_t next_departure, time_t now, uint8_t failures,
+                                       BatteryChargeState battery) {
+    // Nearby departures change by the minute; distant ones hardly at all
+    uint32_t interval;
+    time_t until = next_departure - now;
+    if (next_departure == 0) {
+        interval = 60000;
+    } else if (until <= 10 * 60) {
+        interval = REFRESH_MIN_INTERVAL_MS;
+    } else if (until <= 30 * 60) {
+        interval = 60000;
+    } else if (until <= 2 * 60 * 60) {
+        interval = 5 * 60000;
+    } else {
+        interval = 15 * 60000;
+    }
+
+    interval <<= failures < REFRESH_MAX_FAILURE_SHIFT ? failures : REFRESH_MAX_FAILURE_SHIFT;
+
+    if (!battery.is_charging) {
+        if (battery.charge_percent <= REFRESH_CRITICAL_BATTERY_PERCENT) {
+            interval *= 4;
+        } else if (battery.charge_percent <= REFRESH_LOW_BATTERY_PERCENT) {
+            interval *= 2;
+        }
+    }
+
+    return interval < REFRESH_MAX_INTERVAL_MS ? interval : REFRESH_MAX_INTERVAL_MS;
+}
+
+static void focus_handler(bool in_focus) {
+    for (int i = 0; i < s_num_schedulers; i++) {
+        if (in_focus) {
+            refresh_scheduler_resume(s_schedulers[i], REFRESH_PAUSE_UNFOCUSED);
+        } else {
+            refresh_scheduler_pause(s_schedulers[i], REFRESH_PAUSE_UNFOCUSED);
+        }
+    }
+}
+
+static void cancel_timer(RefreshScheduler *scheduler) {
+    if (scheduler->timer) {
+        app_timer_cancel(scheduler->timer);
+        scheduler->timer = NULL;
+    }
+}
+
+static void timer_callback(void *data) {
+    RefreshScheduler *scheduler = data;
+    scheduler->timer = NULL;
+    scheduler->last_refresh = time(NULL);
+    scheduler->callback();
+    // Fallback in case no result ever reports back
+    schedule(scheduler);
+}
+
+static void schedule(RefreshScheduler *scheduler) {
+    cancel_timer(scheduler);
+    if (scheduler->paused) {
+        return;
+    }
+
+    time_t now = time(NULL);
+    uint32_t interval = refresh_scheduler_interval_ms(scheduler->next_departure, now,
+                                                      scheduler->failures,
+                                                      battery_state_service_peek());
+    uint32_t elapsed = now > scheduler->last_refresh ? (now - scheduler->last_refresh) * 1000 : 0;
+    uint32_t wait = elapsed < interval ? interval - elapsed : 0;
+    LOG_DEBUG("Next refresh in %d ms", (int)wait);
+    scheduler->timer = app_timer_register(wait, timer_callback, scheduler);
+}
+
+void refresh_scheduler_init(RefreshScheduler *scheduler, RefreshCallback callback) {
+    scheduler->timer = NULL;
+    scheduler->callback = callback;
+    scheduler->last_refresh = time(NULL);
+    scheduler->next_departure = 0;
+    scheduler->failures = 0;
+    scheduler->paused = 0;
+
+    bool registered = false;
+    for (int i = 0; i < s_num_schedulers; i++) {
+        registered = registered || s_schedulers[i] == scheduler;
+    }
+    if (!registered && s_num_schedulers < REFRESH_MAX_SCHEDULERS) {
+        if (s_num_schedulers == 0) {
+            app_focus_service_subscribe(focus_handler);
+        }
+        s_schedulers[s_num_schedulers++] = scheduler;
+    }
+    schedule(scheduler);
+}
+
+void refresh_scheduler_deinit(RefreshScheduler *scheduler) {
+    cancel_timer(scheduler);
+    for (int i = 0; i < s_num_schedulers; i++) {
+        if (s_schedulers[i] == scheduler) {
+            s_schedulers[i] = s_schedulers[--s_num_schedulers];
+            if (s_num_schedulers == 0) {
+                app_focus_service_unsubscribe();
+            }
+            break;
+        }
+    }
+}
+
+void refresh_scheduler_succeeded(RefreshScheduler *scheduler, time_t next_departure) {
+    scheduler->failures = 0;
+    scheduler->next_departure = next_departure;
+    schedule(scheduler);
+}
+
+void refresh_scheduler_failed(RefreshScheduler *scheduler) {
+    if (scheduler->failures < UINT8_MAX) {
+        scheduler->failures++;
+    }
+    schedule(scheduler);
+}
+
+void refresh_scheduler_pause(RefreshScheduler *scheduler, uint8_t reason) {
+    scheduler->paused |= reason;
+    cancel_timer(scheduler);
+}
+
+void refresh_scheduler_resume(RefreshScheduler *scheduler, uint8_t reason) {
+    uint8_t was_paused = scheduler->paused;
+    scheduler->paused &= ~reason;
+    if (was_paused && !scheduler->paused) {
+        schedule(scheduler);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef PEBBLE_H
+#include <pebble.h>
+#endif
+
+// Decides when a polling window refreshes next. The interval follows the
+// earliest departure on screen, grows after failed refreshes and on a low
+// battery, and no timer runs while the window is hidden or the app has lost
+// focus to a notification; a refresh that fell due meanwhile runs on resume.
+
+#define REFRESH_MIN_INTERVAL_MS 30000         // Departure within 10 minutes
+#define REFRESH_MAX_INTERVAL_MS (30 * 60000)  // Cap for every backoff
+#define REFRESH_MAX_FAILURE_SHIFT 4           // Failures double the interval up to 16x
+#define REFRESH_LOW_BATTERY_PERCENT 20        // Not charging and at or below: 2x
+#define REFRESH_CRITICAL_BATTERY_PERCENT 10   // ... and at or below this: 4x
+#define REFRESH_MAX_SCHEDULERS 2
+
+#define REFRESH_PAUSE_HIDDEN 0x01
+#define REFRESH_PAUSE_UNFOCUSED 0x02
+
+typedef void (*RefreshCallback)(void);
+
+typedef struct {
+    AppTimer *timer;
+    RefreshCallback callback;
+    time_t last_refresh;
+    time_t next_departure;  // Earliest departure on screen, 0 if unknown
+    uint8_t failures;       // Since the last successful refresh
+    uint8_t paused;         // REFRESH_PAUSE_* bits
+} RefreshScheduler;
+
+// The caller has just requested data; the first refresh is timed from now
+void refresh_scheduler_init(RefreshScheduler *scheduler, RefreshCallback callback);
+void refresh_scheduler_deinit(RefreshScheduler *scheduler);
+
+// Results of the last refresh; both plan the next one
+void refresh_scheduler_succeeded(RefreshScheduler *scheduler, time_t next_departure);
+void refresh_scheduler_failed(RefreshScheduler *scheduler);
+
+// From the window's disappear and appear handlers (REFRESH_PAUSE_HIDDEN);
+// focus changes are handled here
+void refresh_scheduler_pause(RefreshScheduler *scheduler, uint8_t reason);
+void refresh_scheduler_resume(RefreshScheduler *scheduler, uint8_t reason);
+
+uint32_t refresh_scheduler_interval_ms(time_t next_departure, time_t now, uint8_t failures,
+                                       BatteryChargeState battery);
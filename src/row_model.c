@@ -0,0 +1,78 @@
+#include "row_model.h"
+#include "log.h"
+
+void row_model_format_time(time_t timestamp, char *buffer, size_t size) {
+    struct tm *tm_info = localtime(&timestamp);
+    if (tm_info) {
+        strftime(buffer, size, "%H:%M", tm_info);
+    } else {
+        snprintf(buffer, size, "??:??");
+        LOG_ERROR("localtime returned NULL for timestamp %d", (int)timestamp);
+    }
+}
+
+void row_model_build_connection(const Connection *connection, ConnectionRow *row) {
+    const JourneySection *first = &connection->sections[0];
+
+    // Small header: Train type | Platform
+    if (first->platform[0] != '\0') {
+        snprintf(row->header, sizeof(row->header), "%s | Pl.%s",
+                 first->train_type, first->platform);
+    } else {
+        snprintf(row->header, sizeof(row->header), "%s", first->train_type);
+    }
+
+    // Large middle: Time
+    char dep_time[6], arr_time[6];
+    row_model_format_time(connection->departure_time, dep_time, sizeof(dep_time));
+    row_model_format_time(connection->arrival_time, arr_time, sizeof(arr_time));
+    if (connection->num_changes > 0) {
+        snprintf(row->time_text, sizeof(row->time_text), "%s - %s | %d chg",
+                 dep_time, arr_time, connection->num_changes);
+    } else {
+        snprintf(row->time_text, sizeof(row->time_text), "%s - %s", dep_time, arr_time);
+    }
+
+    // Small footer: Delay status
+    if (connection->total_delay_minutes > 60) {
+        snprintf(row->footer, sizeof(row->footer), "+60+ min delay");
+    } else if (connection->total_delay_minutes > 0) {
+        snprintf(row->footer, sizeof(row->footer), "+%d min delay", connection->total_delay_minutes);
+    } else {
+        snprintf(row->footer, sizeof(row->footer), "On time");
+    }
+}
+
+void row_model_build_summary(const Connection *connection, JourneySummaryRow *row) {
+    char dep_time[6], arr_time[6];
+    row_model_format_time(connection->departure_time, dep_time, sizeof(dep_time));
+    row_model_format_time(connection->arrival_time, arr_time, sizeof(arr_time));
+    snprintf(row->title, sizeof(row->title), "%s - %s", dep_time, arr_time);
+    snprintf(row->subtitle, sizeof(row->subtitle), "%d changes", connection->num_changes);
+}
+
+void row_model_build_section(const JourneySection *section, JourneySectionRow *row) {
+    char dep_time[6], arr_time[6];
+    row_model_format_time(section->departure_time, dep_time, sizeof(dep_time));
+    row_model_format_time(section->arrival_time, arr_time, sizeof(arr_time));
+
+    // Departure station + platform
+    if (section->platform[0] != '\0') {
+        snprintf(row->departure, sizeof(row->departure), "%s | Pl.%s",
+                 string_pool_get(section->departure_station), section->platform);
+    } else {
+        snprintf(row->departure, sizeof(row->departure), "%s",
+                 string_pool_get(section->departure_station));
+    }
+
+    // Train type + departure time
+    snprintf(row->train, sizeof(row->train), "%s → %s", section->train_type, dep_time);
+
+    // Arrival time + delay
+    if (section->delay_minutes > 0) {
+        snprintf(row->arrival_info, sizeof(row->arrival_info), "Arr: %s | +%d min",
+                 arr_time, section->delay_minutes);
+    } else {
+        snprintf(row->arrival_info, sizeof(row->arrival_info), "Arr: %s", arr_time);
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#ifndef PEBBLE_H
+#include <pebble.h>
+#endif
+#include "data_models.h"
+
+// Ready-to-draw text for the connection and journey menus. Rows are built
+// once when their data changes, so draw callbacks only blit strings.
+
+typedef struct {
+    char header[40];     // Train type | platform
+    char time_text[32];  // Departure - arrival | changes
+    char footer[24];     // Delay status
+} ConnectionRow;
+
+typedef struct {
+    char title[16];      // Departure - arrival
+    char subtitle[24];   // Number of changes
+} JourneySummaryRow;
+
+typedef struct {
+    char departure[48];     // Station | platform
+    char train[32];         // Train type → departure time
+    char arrival_info[32];  // Arrival time | delay
+} JourneySectionRow;
+
+void row_model_format_time(time_t timestamp, char *buffer, size_t size);
+
+void row_model_build_connection(const Connection *connection, ConnectionRow *row);
+void row_model_build_summary(const Connection *connection, JourneySummaryRow *row);
+void row_model_build_section(const JourneySection *section, JourneySectionRow *row);
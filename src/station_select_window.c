@@ -1,13 +1,14 @@
 #include "station_select_window.h"
-#include "persistence.h"
+#include "log.h"
+#include "storage.h"
+#include "outbox_queue.h"
+#include "marquee.h"
 
-#define SCROLL_WAIT_MS 1000  // Wait 1 second before starting scroll
-#define SCROLL_STEP_MS 200   // Scroll every 200ms
 #define MENU_CHARS_VISIBLE 17 // Approx chars visible in menu cell
 
 static Window *s_window;
 static MenuLayer *s_menu_layer;
-static Station s_stations[50];
+static Station s_stations[MAX_NEARBY_STATIONS];
 static int s_num_stations = 0;
 static Station s_favorites[MAX_FAVORITE_STATIONS];
 static int s_num_favorites = 0;
@@ -15,47 +16,13 @@ static StationSelectCallback s_callback;
 static TextLayer *s_status_layer;
 static bool s_gps_search_active = false;
 
-// Text scrolling state
-static AppTimer *s_scroll_timer = NULL;
-static int s_scroll_offset = 0;
-static bool s_scrolling_required = false;
-static bool s_menu_reloading = false;
-
-// Forward declarations
-static void scroll_menu_callback(void *data);
-static void initiate_menu_scroll_timer(void);
+static Marquee s_marquee;
 
 // Convert FavoriteDestination to Station for display
 static Station favorite_to_station(FavoriteDestination *fav) {
     return create_station(fav->id, fav->name, 0);  // distance = 0 for favorites
 }
 
-// Timer-based text scrolling implementation
-static void scroll_menu_callback(void *data) {
-    s_scroll_timer = NULL;
-    s_scroll_offset++;
-
-    if (!s_scrolling_required) {
-        return;
-    }
-
-    s_menu_reloading = true;
-    s_scrolling_required = false;
-    menu_layer_reload_data(s_menu_layer);
-    s_scroll_timer = app_timer_register(SCROLL_STEP_MS, scroll_menu_callback, NULL);
-}
-
-static void initiate_menu_scroll_timer(void) {
-    s_scrolling_required = true;
-    s_scroll_offset = 0;
-    s_menu_reloading = false;
-
-    if (s_scroll_timer) {
-        app_timer_cancel(s_scroll_timer);
-    }
-    s_scroll_timer = app_timer_register(SCROLL_WAIT_MS, scroll_menu_callback, NULL);
-}
-
 static uint16_t menu_get_num_sections_callback(MenuLayer *menu_layer, void *data) {
     // Always show 2 sections: Action/Nearby + Favorites
     return 2;
@@ -92,10 +59,6 @@ static void menu_draw_header_callback(GContext* ctx, const Layer *cell_layer, ui
 static void menu_draw_row_callback(GContext* ctx, const Layer *cell_layer, MenuIndex *cell_index, void *data) {
     Station *station;
     static char subtitle[32];
-    MenuIndex selected_index = menu_layer_get_selected_index(s_menu_layer);
-    bool is_selected = (cell_index->section == selected_index.section &&
-                        cell_index->row == selected_index.row);
-
     if (cell_index->section == 0) {
         // Section 0: "Stations near me" or GPS results
         if (!s_gps_search_active && s_num_stations == 0) {
@@ -122,17 +85,7 @@ static void menu_draw_row_callback(GContext* ctx, const Layer *cell_layer, MenuI
             snprintf(subtitle, sizeof(subtitle), "%d.%d km", km, decimal);
         }
 
-        const char *name_to_draw = station->name;
-
-        // Apply scroll offset if selected
-        if (is_selected) {
-            int len = strlen(station->name);
-            if (len - MENU_CHARS_VISIBLE - s_scroll_offset > 0) {
-                name_to_draw += s_scroll_offset;
-                s_scrolling_required = true;
-            }
-        }
-
+        const char *name_to_draw = marquee_text(&s_marquee, cell_index, station->name, MENU_CHARS_VISIBLE);
         menu_cell_basic_draw(ctx, cell_layer, name_to_draw, subtitle, NULL);
     } else {
         // Section 1: Favorites
@@ -145,27 +98,25 @@ static void menu_draw_row_callback(GContext* ctx, const Layer *cell_layer, MenuI
         }
 
         station = &s_favorites[cell_index->row];
-        const char *name_to_draw = station->name;
-
-        // Apply scroll offset if selected
-        if (is_selected) {
-            int len = strlen(station->name);
-            if (len - MENU_CHARS_VISIBLE - s_scroll_offset > 0) {
-                name_to_draw += s_scroll_offset;
-                s_scrolling_required = true;
-            }
-        }
-
+        const char *name_to_draw = marquee_text(&s_marquee, cell_index, station->name, MENU_CHARS_VISIBLE);
         menu_cell_basic_draw(ctx, cell_layer, name_to_draw, NULL, NULL);
     }
 }
 
 static void menu_selection_changed_callback(MenuLayer *menu_layer, MenuIndex new_index, MenuIndex old_index, void *data) {
-    // Start scroll timer when selection changes
-    if (!s_menu_reloading) {
-        initiate_menu_scroll_timer();
-    } else {
-        s_menu_reloading = false;
+    marquee_restart(&s_marquee);
+}
+
+static void write_nearby_request(DictionaryIterator *iter, const void *payload) {
+    dict_write_uint8(iter, MESSAGE_KEY_REQUEST_NEARBY_STATIONS, 1);
+}
+
+static void nearby_request_failed(const void *payload) {
+    // Bring back the "Stations near me" row so the user can try again
+    s_gps_search_active = false;
+    if (s_window && window_stack_contains_window(s_window)) {
+        menu_layer_reload_data(s_menu_layer);
+        text_layer_set_text(s_status_layer, "Phone unreachable");
     }
 }
 
@@ -180,10 +131,8 @@ static void menu_select_callback(MenuLayer *menu_layer, MenuIndex *cell_index, v
             menu_layer_reload_data(s_menu_layer);
 
             // Request nearby stations via AppMessage
-            DictionaryIterator *iter;
-            app_message_outbox_begin(&iter);
-            dict_write_uint8(iter, MESSAGE_KEY_REQUEST_NEARBY_STATIONS, 1);
-            app_message_outbox_send();
+            outbox_queue_send(OUTBOX_KEY_REQUEST_NEARBY_STATIONS, write_nearby_request,
+                              nearby_request_failed, NULL, 0);
 
             text_layer_set_text(s_status_layer, "Searching nearby...");
             return;
@@ -204,10 +153,10 @@ static void menu_select_callback(MenuLayer *menu_layer, MenuIndex *cell_index, v
         selected = &s_favorites[cell_index->row];
     }
 
-    APP_LOG(APP_LOG_LEVEL_INFO, "Station selected: %s, popping window then calling callback", selected->name);
+    LOG_INFO("Station selected: %s, popping window then calling callback", selected->name);
 
     // Pop this window first
-    APP_LOG(APP_LOG_LEVEL_INFO, "Popping station select window");
+    LOG_INFO("Popping station select window");
     window_stack_pop(true);
 
     // Then call callback to push next window
@@ -230,6 +179,7 @@ static void window_load(Window *window) {
     // Create menu layer
     GRect menu_bounds = GRect(0, 0, bounds.size.w, bounds.size.h - 30);
     s_menu_layer = menu_layer_create(menu_bounds);
+    marquee_init(&s_marquee, s_menu_layer);
     menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks){
         .get_num_sections = menu_get_num_sections_callback,
         .get_num_rows = menu_get_num_rows_callback,
@@ -247,29 +197,34 @@ static void window_load(Window *window) {
 
     // Load favorites and convert to Station format
     FavoriteDestination fav_destinations[MAX_FAVORITE_DESTINATIONS];
-    int num_fav_destinations = load_favorite_destinations(fav_destinations);
+    int num_fav_destinations = storage_get_favorite_destinations(fav_destinations);
 
     s_num_favorites = 0;
     for (int i = 0; i < num_fav_destinations && i < MAX_FAVORITE_STATIONS; i++) {
         s_favorites[s_num_favorites++] = favorite_to_station(&fav_destinations[i]);
     }
 
-    APP_LOG(APP_LOG_LEVEL_INFO, "Loaded %d favorite destinations", s_num_favorites);
+    LOG_INFO("Loaded %d favorite destinations", s_num_favorites);
 
     // DO NOT automatically trigger GPS - wait for user to select "Stations near me"
 }
 
+static void window_appear(Window *window) {
+    marquee_restart(&s_marquee);
+}
+
+static void window_disappear(Window *window) {
+    marquee_pause(&s_marquee);
+}
+
 static void window_unload(Window *window) {
-    if (s_scroll_timer) {
-        app_timer_cancel(s_scroll_timer);
-        s_scroll_timer = NULL;
-    }
+    marquee_deinit(&s_marquee);
     text_layer_destroy(s_status_layer);
     menu_layer_destroy(s_menu_layer);
 }
 
 void station_select_window_push(StationSelectCallback callback) {
-    APP_LOG(APP_LOG_LEVEL_INFO, "Station select window push called");
+    LOG_INFO("Station select window push called");
     s_callback = callback;
     s_num_stations = 0;
     s_gps_search_active = false;  // Reset GPS search state
@@ -278,21 +233,36 @@ void station_select_window_push(StationSelectCallback callback) {
         s_window = window_create();
         window_set_window_handlers(s_window, (WindowHandlers) {
             .load = window_load,
+            .appear = window_appear,
+            .disappear = window_disappear,
             .unload = window_unload,
         });
     }
     window_stack_push(s_window, true);
 }
 
-void station_select_window_add_station(Station station) {
-    if (s_num_stations < 50) {
-        s_stations[s_num_stations++] = station;
-        menu_layer_reload_data(s_menu_layer);
+// Fill a slot without redrawing; update_stations publishes the whole list
+void station_select_window_set_station(int index, const Station *station) {
+    if (index < 0 || index >= MAX_NEARBY_STATIONS) {
+        return;
+    }
+    s_stations[index] = *station;
+}
 
-        static char status[32];
-        snprintf(status, sizeof(status), "Found %d stations", s_num_stations);
-        text_layer_set_text(s_status_layer, status);
+void station_select_window_update_stations(int count) {
+    if (count > MAX_NEARBY_STATIONS) {
+        count = MAX_NEARBY_STATIONS;
     }
+    s_num_stations = count;
+    if (!s_window || !window_stack_contains_window(s_window)) {
+        return;
+    }
+
+    menu_layer_reload_data(s_menu_layer);
+
+    static char status[32];
+    snprintf(status, sizeof(status), "Found %d stations", s_num_stations);
+    text_layer_set_text(s_status_layer, status);
 }
 
 void station_select_window_clear_stations(void) {
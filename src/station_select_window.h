@@ -5,5 +5,6 @@
 typedef void (*StationSelectCallback)(Station *station);
 
 void station_select_window_push(StationSelectCallback callback);
-void station_select_window_add_station(Station station);
+void station_select_window_set_station(int index, const Station *station);
+void station_select_window_update_stations(int count);
 void station_select_window_clear_stations(void);
@@ -0,0 +1,191 @@
+#include "storage.h"
+#include "persistence.h"
+#include "trace.h"
+
+static SavedConnection s_connections[MAX_SAVED_CONNECTIONS];
+static int s_num_connections = 0;
+static bool s_connections_loaded = false;
+
+static FavoriteDestination s_favorites[MAX_FAVORITE_DESTINATIONS];
+static int s_num_favorites = 0;
+static FavoritesSync s_favorites_sync;
+static bool s_favorites_loaded = false;
+static bool s_favorites_dirty = false;
+
+static PinnedConnection s_pinned;
+static bool s_pinned_loaded = false;
+static bool s_pinned_dirty = false;
+
+static LastResult s_last_results[LAST_RESULT_ROUTES];
+static int s_num_last_results = 0;
+static bool s_last_results_loaded = false;
+static bool s_last_results_dirty = false;
+
+// The cached pin holds interned names for the whole session
+static void mark_strings(void) {
+    if (s_pinned_loaded && s_pinned.is_active) {
+        connection_mark_strings(&s_pinned.connection);
+    }
+}
+
+static void ensure_connections_loaded(void) {
+    if (!s_connections_loaded) {
+        s_num_connections = load_connections(s_connections);
+        s_connections_loaded = true;
+    }
+}
+
+static void ensure_favorites_loaded(void) {
+    if (!s_favorites_loaded) {
+        s_num_favorites = load_favorite_destinations(s_favorites, &s_favorites_sync);
+        s_favorites_loaded = true;
+    }
+}
+
+static void ensure_pinned_loaded(void) {
+    if (!s_pinned_loaded) {
+        s_pinned = load_pinned_connection();
+        s_pinned_loaded = true;
+        string_pool_register_root(mark_strings);
+    }
+}
+
+static void ensure_last_results_loaded(void) {
+    if (!s_last_results_loaded) {
+        s_num_last_results = load_last_results(s_last_results);
+        s_last_results_loaded = true;
+    }
+}
+
+const SavedConnection *storage_get_connections(int *count) {
+    ensure_connections_loaded();
+    *count = s_num_connections;
+    return s_connections;
+}
+
+bool storage_add_connection(const SavedConnection *connection) {
+    ensure_connections_loaded();
+    if (s_num_connections >= MAX_SAVED_CONNECTIONS) {
+        return false;
+    }
+    s_connections[s_num_connections++] = *connection;
+    save_connections(s_connections, s_num_connections);
+    return true;
+}
+
+bool storage_is_connection_limit_reached(void) {
+    ensure_connections_loaded();
+    return s_num_connections >= MAX_SAVED_CONNECTIONS;
+}
+
+void storage_set_favorite_destinations(const FavoriteDestination *favorites, int count,
+                                       const FavoritesSync *sync) {
+    if (count > MAX_FAVORITE_DESTINATIONS) {
+        count = MAX_FAVORITE_DESTINATIONS;
+    }
+    memcpy(s_favorites, favorites, sizeof(FavoriteDestination) * count);
+    s_num_favorites = count;
+    if (sync) {
+        s_favorites_sync = *sync;
+    } else {
+        memset(&s_favorites_sync, 0, sizeof(FavoritesSync));
+    }
+    s_favorites_loaded = true;
+    s_favorites_dirty = true;
+}
+
+int storage_get_favorite_destinations(FavoriteDestination *favorites) {
+    ensure_favorites_loaded();
+    memcpy(favorites, s_favorites, sizeof(FavoriteDestination) * s_num_favorites);
+    return s_num_favorites;
+}
+
+FavoritesSync storage_get_favorites_sync(void) {
+    ensure_favorites_loaded();
+    return s_favorites_sync;
+}
+
+void storage_set_pinned_connection(const PinnedConnection *pinned) {
+    s_pinned = *pinned;
+    s_pinned_loaded = true;
+    s_pinned_dirty = true;
+    string_pool_register_root(mark_strings);
+}
+
+PinnedConnection storage_get_pinned_connection(void) {
+    ensure_pinned_loaded();
+    return s_pinned;
+}
+
+void storage_clear_pinned_connection(void) {
+    PinnedConnection pinned;
+    memset(&pinned, 0, sizeof(PinnedConnection));
+    pinned.is_active = false;
+    storage_set_pinned_connection(&pinned);
+}
+
+bool storage_get_last_result(const SavedConnection *route, LastResult *result) {
+    ensure_last_results_loaded();
+    for (int i = 0; i < s_num_last_results; i++) {
+        if (last_result_matches(&s_last_results[i], route->departure_station_id,
+                                route->arrival_station_id)) {
+            *result = s_last_results[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+void storage_set_last_result(const LastResult *result) {
+    ensure_last_results_loaded();
+    int found = s_num_last_results < LAST_RESULT_ROUTES ? s_num_last_results : LAST_RESULT_ROUTES - 1;
+    for (int i = 0; i < s_num_last_results; i++) {
+        if (last_result_matches(&s_last_results[i], result->departure_station_id,
+                                result->arrival_station_id)) {
+            found = i;
+            break;
+        }
+    }
+    if (found == s_num_last_results) {
+        s_num_last_results++;
+    }
+    memmove(&s_last_results[1], &s_last_results[0], sizeof(LastResult) * found);
+    s_last_results[0] = *result;
+    s_last_results_dirty = true;
+}
+
+void storage_flush(void) {
+    int written = 0;
+    if (s_favorites_dirty) {
+        save_favorite_destinations(s_favorites, s_num_favorites, &s_favorites_sync);
+        s_favorites_dirty = false;
+        written++;
+    }
+    if (s_pinned_dirty) {
+        save_pinned_connection(&s_pinned);
+        s_pinned_dirty = false;
+        written++;
+    }
+    if (s_last_results_dirty) {
+        save_last_results(s_last_results, s_num_last_results);
+        s_last_results_dirty = false;
+        written++;
+    }
+    if (written > 0) {
+        trace(TRACE_STORAGE_FLUSH, written, 0);
+    }
+}
+
+bool storage_is_dirty(void) {
+    return s_favorites_dirty || s_pinned_dirty || s_last_results_dirty;
+}
+
+void storage_reset(void) {
+    s_connections_loaded = false;
+    s_favorites_loaded = false;
+    s_favorites_dirty = false;
+    s_pinned_loaded = false;
+    s_pinned_dirty = false;
+    s_last_results_loaded = false;
+    s_last_results_dirty = false;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef PEBBLE_H
+#include <pebble.h>
+#endif
+#include "data_models.h"
+#include "pinned_connection.h"
+#include "last_result.h"
+
+// Repository over persistence.c. Each dataset is read from flash the first
+// time it is needed and served from RAM for the rest of the session.
+//
+// Saved connections are written through on every change. Favorites, the pin
+// and the last results are write-behind: saves update the RAM copy and mark it dirty, and
+// storage_flush() writes each dirty record once.
+
+// Saved connections; the pointer stays valid for the whole session
+const SavedConnection *storage_get_connections(int *count);
+bool storage_add_connection(const SavedConnection *connection);
+bool storage_is_connection_limit_reached(void);
+
+// sync stamps the list as the one the phone sent; NULL marks it unsynced
+void storage_set_favorite_destinations(const FavoriteDestination *favorites, int count,
+                                       const FavoritesSync *sync);
+int storage_get_favorite_destinations(FavoriteDestination *favorites);
+FavoritesSync storage_get_favorites_sync(void);
+
+void storage_set_pinned_connection(const PinnedConnection *pinned);
+PinnedConnection storage_get_pinned_connection(void);
+void storage_clear_pinned_connection(void);
+
+// Last connection set received for a route, see last_result.h. Setting one
+// moves its route to the front and drops the least recently used route.
+bool storage_get_last_result(const SavedConnection *route, LastResult *result);
+void storage_set_last_result(const LastResult *result);
+
+// Call when a batch is committed, on window unload and on deinit
+void storage_flush(void);
+bool storage_is_dirty(void);
+
+// Forget the RAM copies so the next read goes to flash; used by tests
+void storage_reset(void);
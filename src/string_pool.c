@@ -0,0 +1,190 @@
+#include "string_pool.h"
+#include "log.h"
+#include "trace.h"
+#include <string.h>
+
+#define ENTRY_USED  0x01
+#define ENTRY_MARK  0x02
+#define ENTRY_FRESH 0x04  // Interned since the last collect; not yet in a root
+
+typedef struct {
+    uint16_t offset;
+    uint8_t length;
+    uint8_t flags;
+} PoolEntry;
+
+// Index 0 is STRING_REF_NONE and never used
+static PoolEntry s_entries[STRING_POOL_MAX_ENTRIES + 1];
+static char s_data[STRING_POOL_BYTES];
+static uint16_t s_used_bytes = 0;
+static StringPoolRootMarker s_roots[STRING_POOL_MAX_ROOTS];
+static int s_num_roots = 0;
+
+// Move live strings to the front of s_data in their current order
+static void compact(void) {
+    int last_offset = -1;
+    uint16_t cursor = 0;
+
+    while (true) {
+        int next = 0;
+        for (int i = 1; i <= STRING_POOL_MAX_ENTRIES; i++) {
+            if ((s_entries[i].flags & ENTRY_USED) && s_entries[i].offset > last_offset &&
+                (next == 0 || s_entries[i].offset < s_entries[next].offset)) {
+                next = i;
+            }
+        }
+        if (next == 0) {
+            break;
+        }
+
+        PoolEntry *entry = &s_entries[next];
+        last_offset = entry->offset;
+        memmove(&s_data[cursor], &s_data[entry->offset], entry->length + 1);
+        entry->offset = cursor;
+        cursor += entry->length + 1;
+    }
+    s_used_bytes = cursor;
+}
+
+static void sweep(bool end_of_epoch) {
+    for (int i = 1; i <= STRING_POOL_MAX_ENTRIES; i++) {
+        s_entries[i].flags &= ~ENTRY_MARK;
+    }
+    for (int i = 0; i < s_num_roots; i++) {
+        s_roots[i]();
+    }
+
+    int freed = 0;
+    for (int i = 1; i <= STRING_POOL_MAX_ENTRIES; i++) {
+        PoolEntry *entry = &s_entries[i];
+        if ((entry->flags & ENTRY_USED) && !(entry->flags & (ENTRY_MARK | ENTRY_FRESH))) {
+            entry->flags = 0;
+            freed++;
+        }
+        if (end_of_epoch) {
+            entry->flags &= ~ENTRY_FRESH;
+        }
+    }
+
+    if (freed > 0) {
+        compact();
+    }
+}
+
+static StringRef find_free_entry(void) {
+    for (int i = 1; i <= STRING_POOL_MAX_ENTRIES; i++) {
+        if (!(s_entries[i].flags & ENTRY_USED)) {
+            return i;
+        }
+    }
+    return STRING_REF_NONE;
+}
+
+StringRef string_pool_intern(const char *str) {
+    if (!str || str[0] == '\0') {
+        return STRING_REF_NONE;
+    }
+    size_t length = strlen(str);
+    if (length > 255) {
+        length = 255;
+    }
+
+    for (int i = 1; i <= STRING_POOL_MAX_ENTRIES; i++) {
+        PoolEntry *entry = &s_entries[i];
+        if ((entry->flags & ENTRY_USED) && entry->length == length &&
+            memcmp(&s_data[entry->offset], str, length) == 0) {
+            entry->flags |= ENTRY_FRESH;
+            return i;
+        }
+    }
+
+    StringRef ref = find_free_entry();
+    if (ref == STRING_REF_NONE || s_used_bytes + length + 1 > STRING_POOL_BYTES) {
+        sweep(false);
+        ref = find_free_entry();
+        if (ref == STRING_REF_NONE || s_used_bytes + 1 >= STRING_POOL_BYTES) {
+            LOG_ERROR("String pool full, dropping \"%s\"", str);
+            trace(TRACE_STRING_POOL_FULL, s_used_bytes, length);
+            return STRING_REF_NONE;
+        }
+        if (s_used_bytes + length + 1 > STRING_POOL_BYTES) {
+            // Keep what fits, ending on a whole UTF-8 character
+            size_t fit = STRING_POOL_BYTES - s_used_bytes - 1;
+            while (fit > 0 && (str[fit] & 0xC0) == 0x80) {
+                fit--;
+            }
+            LOG_ERROR("String pool full, shortening \"%s\" to %d bytes", str, (int)fit);
+            trace(TRACE_STRING_POOL_FULL, s_used_bytes, length);
+            if (fit == 0) {
+                return STRING_REF_NONE;
+            }
+            length = fit;
+        }
+    }
+
+    PoolEntry *entry = &s_entries[ref];
+    entry->offset = s_used_bytes;
+    entry->length = length;
+    entry->flags = ENTRY_USED | ENTRY_FRESH;
+    memcpy(&s_data[s_used_bytes], str, length);
+    s_data[s_used_bytes + length] = '\0';
+    s_used_bytes += length + 1;
+    return ref;
+}
+
+const char *string_pool_get(StringRef ref) {
+    if (ref == STRING_REF_NONE || ref > STRING_POOL_MAX_ENTRIES ||
+        !(s_entries[ref].flags & ENTRY_USED)) {
+        return "";
+    }
+    return &s_data[s_entries[ref].offset];
+}
+
+bool string_pool_register_root(StringPoolRootMarker marker) {
+    for (int i = 0; i < s_num_roots; i++) {
+        if (s_roots[i] == marker) {
+            return true;
+        }
+    }
+    if (s_num_roots >= STRING_POOL_MAX_ROOTS) {
+        LOG_ERROR("String pool has no room for another root (%d)", STRING_POOL_MAX_ROOTS);
+        return false;
+    }
+    s_roots[s_num_roots++] = marker;
+    return true;
+}
+
+void string_pool_unregister_root(StringPoolRootMarker marker) {
+    for (int i = 0; i < s_num_roots; i++) {
+        if (s_roots[i] == marker) {
+            s_roots[i] = s_roots[--s_num_roots];
+            return;
+        }
+    }
+}
+
+void string_pool_mark(StringRef ref) {
+    if (ref != STRING_REF_NONE && ref <= STRING_POOL_MAX_ENTRIES) {
+        s_entries[ref].flags |= ENTRY_MARK;
+    }
+}
+
+void string_pool_collect(void) {
+    sweep(true);
+}
+
+int string_pool_count(void) {
+    int count = 0;
+    for (int i = 1; i <= STRING_POOL_MAX_ENTRIES; i++) {
+        if (s_entries[i].flags & ENTRY_USED) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void string_pool_reset(void) {
+    memset(s_entries, 0, sizeof(s_entries));
+    s_used_bytes = 0;
+    s_num_roots = 0;
+}
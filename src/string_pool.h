@@ -0,0 +1,41 @@
+#pragma once
+#ifndef PEBBLE_H
+#include <pebble.h>
+#endif
+
+// Interned station names. Journey sections hold a one-byte StringRef instead
+// of two inline name buffers; consecutive legs share the same entries.
+//
+// Entries are reclaimed by mark and sweep: modules that keep connections
+// around register a root marker that calls string_pool_mark on every ref they
+// hold. Entries interned since the last string_pool_collect() are never swept,
+// so refs sitting in a half-decoded connection on the stack stay valid.
+
+typedef uint8_t StringRef;
+
+#define STRING_REF_NONE 0
+// Worst case: a full result set on screen (5 connections, up to 6 distinct
+// names each), a patch decoding as many new ones before applying, and the pin
+#define STRING_POOL_MAX_ENTRIES 66
+#define STRING_POOL_BYTES (STRING_POOL_MAX_ENTRIES * 32)  // Names keep at most 31 bytes
+#define STRING_POOL_MAX_ROOTS 6
+
+typedef void (*StringPoolRootMarker)(void);
+
+// A name that doesn't fit the bytes left after a sweep is cut short rather
+// than dropped; only a pool without a free entry returns STRING_REF_NONE
+StringRef string_pool_intern(const char *str);
+const char *string_pool_get(StringRef ref);
+
+// False, with an error logged, once STRING_POOL_MAX_ROOTS are registered.
+// Windows unregister on unload so their refs can be reclaimed.
+bool string_pool_register_root(StringPoolRootMarker marker);
+void string_pool_unregister_root(StringPoolRootMarker marker);
+void string_pool_mark(StringRef ref);
+
+// Sweep unreachable entries and compact. Only call where no ref lives outside
+// a registered root, e.g. at the start of an AppMessage handler.
+void string_pool_collect(void);
+
+int string_pool_count(void);
+void string_pool_reset(void);
@@ -0,0 +1,71 @@
+#include "trace.h"
+
+static TraceRecord s_records[TRACE_CAPACITY];
+static uint32_t s_total = 0;  // Records ever written; the newest is s_total - 1
+
+uint32_t trace_now_ms(void) {
+    time_t seconds;
+    uint16_t millis = time_ms(&seconds, NULL);
+    return (uint32_t)seconds * 1000 + millis;
+}
+
+void trace(TraceEvent event, int16_t a, int32_t b) {
+    TraceRecord *record = &s_records[s_total % TRACE_CAPACITY];
+    record->time_ms = trace_now_ms();
+    record->event = event;
+    record->a = a;
+    record->b = b;
+    s_total++;
+}
+
+int trace_count(void) {
+    return s_total < TRACE_CAPACITY ? (int)s_total : TRACE_CAPACITY;
+}
+
+TraceRecord trace_get(int index) {
+    uint32_t oldest = s_total - trace_count();
+    return s_records[(oldest + index) % TRACE_CAPACITY];
+}
+
+void trace_reset(void) {
+    s_total = 0;
+}
+
+int trace_chunk_count(void) {
+    int count = (trace_count() + TRACE_RECORDS_PER_CHUNK - 1) / TRACE_RECORDS_PER_CHUNK;
+    return count > 0 ? count : 1;
+}
+
+static void write_u32(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+size_t trace_encode_chunk(int chunk, uint8_t *buffer, size_t size) {
+    int chunks = trace_chunk_count();
+    if (chunk < 0 || chunk >= chunks || size < TRACE_CHUNK_HEADER_SIZE) {
+        return 0;
+    }
+
+    buffer[0] = chunk;
+    buffer[1] = chunks;
+    size_t offset = TRACE_CHUNK_HEADER_SIZE;
+
+    int first = chunk * TRACE_RECORDS_PER_CHUNK;
+    for (int i = first; i < trace_count() && i < first + TRACE_RECORDS_PER_CHUNK; i++) {
+        if (offset + TRACE_RECORD_SIZE > size) {
+            break;
+        }
+        TraceRecord record = trace_get(i);
+        uint8_t *out = &buffer[offset];
+        write_u32(out, record.time_ms);
+        out[4] = record.event;
+        out[5] = 0;
+        out[6] = (uint16_t)record.a & 0xFF;
+        out[7] = (uint16_t)record.a >> 8;
+        write_u32(&out[8], (uint32_t)record.b);
+        offset += TRACE_RECORD_SIZE;
+    }
+    return offset;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef PEBBLE_H
+#include <pebble.h>
+#endif
+
+// Binary trace ring buffer. trace() stores an event id, two integers and a
+// millisecond timestamp; nothing is formatted on the watch. The phone asks
+// for the buffer with REQUEST_TRACE and app_message.c sends it back as
+// TRACE_DATA chunks, decoded by src/pkjs/trace.js.
+
+#define TRACE_CAPACITY 64
+#define TRACE_RECORD_SIZE 12      // time u32, event u8, reserved u8, a i16, b i32
+#define TRACE_RECORDS_PER_CHUNK 16
+#define TRACE_CHUNK_HEADER_SIZE 2  // chunk index, chunk count
+#define TRACE_CHUNK_MAX_SIZE (TRACE_CHUNK_HEADER_SIZE + TRACE_RECORDS_PER_CHUNK * TRACE_RECORD_SIZE)
+
+// Keep in sync with EVENT_NAMES in src/pkjs/trace.js
+typedef enum {
+    TRACE_APP_START = 1,        // a: AppLaunchReason
+    TRACE_INBOX_RECEIVED,       // a: first message key
+    TRACE_INBOX_DROPPED,        // a: AppMessageResult
+    TRACE_OUTBOX_SENT,          // a: pending messages
+    TRACE_OUTBOX_RETRY,         // a: AppMessageResult, b: attempt
+    TRACE_OUTBOX_GAVE_UP,       // a: AppMessageResult, b: coalesce key
+    TRACE_CONNECTIONS_REQUESTED,  // a: result version
+    TRACE_CONNECTIONS_SHOWN,    // a: rows shown, b: total
+    TRACE_PATCH_APPLIED,        // a: version, b: total
+    TRACE_STORAGE_FLUSH,        // a: records written
+    TRACE_STRING_POOL_FULL,     // a: bytes in use, b: length dropped
+    TRACE_REQUEST_LATENCY,      // a: request id, b: total ms
+    TRACE_LATENCY_SUMMARY,      // a: LatencyStage, b: p90 ms << 16 | p50 ms
+} TraceEvent;
+
+typedef struct {
+    uint32_t time_ms;
+    uint8_t event;
+    int16_t a;
+    int32_t b;
+} TraceRecord;
+
+void trace(TraceEvent event, int16_t a, int32_t b);
+
+// Milliseconds on the clock trace records are stamped with; wraps every
+// 49 days, so only differences are meaningful
+uint32_t trace_now_ms(void);
+
+// Oldest first; index < trace_count()
+int trace_count(void);
+TraceRecord trace_get(int index);
+void trace_reset(void);
+
+// Packs chunk `chunk` of the buffer as it is now; returns the byte count, or
+// 0 past the last chunk. trace_chunk_count() is at least 1 so an empty
+// buffer is still answered.
+int trace_chunk_count(void);
+size_t trace_encode_chunk(int chunk, uint8_t *buffer, size_t size);
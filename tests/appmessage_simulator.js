@@ -0,0 +1,180 @@
+// Simulated Bluetooth link between PebbleKit JS and the watch, for jest.
+// install() replaces the global Pebble object; the phone code then runs
+// unchanged while the simulator decides, per message, whether the watch
+// takes it, how long that takes and whether the ack makes it back.
+//
+// Timing uses setTimeout, so tests drive it with jest fake timers. Random
+// decisions come from a seeded generator: the same seed and traffic give
+// the same run, and a recorded log can be replayed into a fresh simulator.
+
+// Must match app_message_open(512, 512) in src/app_message.c
+const WATCH_INBOX_SIZE = 512;
+const DICT_HEADER_BYTES = 1;
+const TUPLE_HEADER_BYTES = 7;
+
+const DEFAULTS = {
+  inboxSize: WATCH_INBOX_SIZE,
+  latencyMs: 40,        // One way, before the payload is on the air
+  bytesPerMs: 4,        // Roughly what a Pebble gets over BLE
+  ackTimeoutMs: 1000,   // Until a lost message is reported as failed
+  busyRate: 0,          // Watch answers APP_MSG_BUSY
+  lossRate: 0,          // Message never arrives
+  dropIf: null,         // Same, for every message it returns true for
+  seed: 1
+};
+
+// PebbleKit JS sends numbers as int32, strings with a terminator and arrays
+// as byte arrays
+function tupleSize(value) {
+  if (Array.isArray(value)) {
+    return value.length;
+  }
+  if (typeof value === 'string') {
+    return Buffer.byteLength(value, 'utf8') + 1;
+  }
+  return 4;
+}
+
+function dictSize(message) {
+  return Object.keys(message).reduce((size, key) =>
+    size + TUPLE_HEADER_BYTES + tupleSize(message[key]), DICT_HEADER_BYTES);
+}
+
+// mulberry32
+function createRandom(seed) {
+  let state = seed >>> 0;
+  return () => {
+    state = (state + 0x6D2B79F5) >>> 0;
+    let t = state;
+    t = Math.imul(t ^ (t >>> 15), t | 1);
+    t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+function createSimulator(options) {
+  const config = Object.assign({}, DEFAULTS, options);
+  const random = createRandom(config.seed);
+  const listeners = {};
+  const startedAt = Date.now();
+  let watchHandler = null;
+
+  const sim = {
+    config: config,
+    log: [],           // Every message in either direction, in send order
+    watchInbox: [],    // Payloads the watch accepted
+    openedUrls: []
+  };
+
+  function transferMs(size) {
+    return config.latencyMs + Math.ceil(size / config.bytesPerMs);
+  }
+
+  function record(direction, message, size, outcome) {
+    const entry = {
+      time: Date.now() - startedAt,
+      direction: direction,
+      keys: Object.keys(message),
+      bytes: size,
+      outcome: outcome,
+      payload: message
+    };
+    sim.log.push(entry);
+    return entry;
+  }
+
+  function dispatch(type, event) {
+    (listeners[type] || []).forEach((listener) => listener(event));
+  }
+
+  function sendAppMessage(message, success, failure) {
+    const size = dictSize(message);
+    const oneWay = transferMs(size);
+    const ackMs = oneWay + config.latencyMs;
+
+    if (random() < config.lossRate || (config.dropIf && config.dropIf(message))) {
+      record('phone', message, size, 'lost');
+      setTimeout(() => failure && failure({ data: message, error: 'timeout' }), config.ackTimeoutMs);
+      return;
+    }
+    if (size > config.inboxSize) {
+      record('phone', message, size, 'overflow');
+      setTimeout(() => failure && failure({ data: message, error: 'APP_MSG_BUFFER_OVERFLOW' }), ackMs);
+      return;
+    }
+    if (random() < config.busyRate) {
+      record('phone', message, size, 'busy');
+      setTimeout(() => failure && failure({ data: message, error: 'APP_MSG_BUSY' }), ackMs);
+      return;
+    }
+
+    record('phone', message, size, 'ack');
+    setTimeout(() => {
+      sim.watchInbox.push(message);
+      if (watchHandler) {
+        watchHandler(message);
+      }
+    }, oneWay);
+    setTimeout(() => success && success({ data: message }), ackMs);
+  }
+
+  // Pebble global as seen by src/pkjs
+  sim.install = () => {
+    global.Pebble = {
+      addEventListener: (type, listener) => {
+        (listeners[type] = listeners[type] || []).push(listener);
+      },
+      sendAppMessage: sendAppMessage,
+      openURL: (url) => sim.openedUrls.push(url)
+    };
+    return sim;
+  };
+
+  sim.ready = () => dispatch('ready', {});
+  sim.showConfiguration = () => dispatch('showConfiguration', {});
+  sim.closeConfiguration = (response) => dispatch('webviewclosed', { response: response });
+
+  // The watch's own outbox: arrives at the phone after the link latency
+  sim.sendFromWatch = (message) => {
+    const size = dictSize(message);
+    record('watch', message, size, 'ack');
+    setTimeout(() => dispatch('appmessage', { payload: message }), transferMs(size));
+  };
+
+  // Called with every payload the watch accepts; may answer via sendFromWatch
+  sim.onWatchReceive = (handler) => {
+    watchHandler = handler;
+  };
+
+  // Feeds the watch side of a recorded log back in at the recorded times,
+  // so the phone's answers can be compared with the original run
+  sim.replay = (log) => {
+    log.filter((entry) => entry.direction === 'watch').forEach((entry) => {
+      setTimeout(() => sim.sendFromWatch(entry.payload), entry.time);
+    });
+  };
+
+  sim.stats = () => {
+    const sent = sim.log.filter((entry) => entry.direction === 'phone');
+    const count = (outcome) => sent.filter((entry) => entry.outcome === outcome).length;
+    const last = sent.length > 0 ? sent[sent.length - 1] : null;
+    return {
+      messages: sent.length,
+      delivered: count('ack'),
+      bytes: sent.reduce((total, entry) => total + entry.bytes, 0),
+      lost: count('lost'),
+      busy: count('busy'),
+      overflow: count('overflow'),
+      // Until the last phone message was acked
+      elapsedMs: last ? last.time + transferMs(last.bytes) + config.latencyMs : 0
+    };
+  };
+
+  return sim;
+}
+
+module.exports = {
+  WATCH_INBOX_SIZE: WATCH_INBOX_SIZE,
+  createSimulator: createSimulator,
+  dictSize: dictSize
+};
@@ -0,0 +1,216 @@
+const { createSimulator, dictSize, WATCH_INBOX_SIZE } = require('./appmessage_simulator');
+
+jest.mock('../src/pkjs/sbb_api');
+
+const messageCodec = require('../src/pkjs/message_codec');
+
+const makeConnection = (minutes) => ({
+  departureTime: 1699362720 + minutes * 60,
+  arrivalTime: 1699367220 + minutes * 60,
+  totalDelayMinutes: 0,
+  numChanges: 1,
+  sections: [0, 1].map((leg) => ({
+    departureStation: leg === 0 ? 'Zürich HB' : 'Olten',
+    arrivalStation: leg === 0 ? 'Olten' : 'Bern',
+    departureTime: 1699362720 + minutes * 60 + leg * 1800,
+    arrivalTime: 1699364520 + minutes * 60 + leg * 1800,
+    platform: '7',
+    trainType: 'IC ' + (700 + minutes),
+    delayMinutes: 0
+  }))
+});
+
+const CONNECTIONS = [0, 30, 60, 90, 120].map(makeConnection);
+
+const REQUEST = {
+  REQUEST_CONNECTIONS: 1,
+  DEPARTURE_STATION_ID: '8503000',
+  ARRIVAL_STATION_ID: '8507000',
+  CONNECTION_VERSION: 0
+};
+
+// Fresh phone code wired to a fresh simulator
+function boot(options) {
+  jest.resetModules();
+  const sim = createSimulator(options).install();
+  const sbbApi = require('../src/pkjs/sbb_api');
+  sbbApi.fetchConnections.mockImplementation((from, to, callback) => callback(null, CONNECTIONS));
+  require('../src/pkjs/index');
+  sim.ready();
+  return sim;
+}
+
+function receivedConnections(sim) {
+  const seen = {};
+  sim.watchInbox.filter((message) => message.CONNECTION_DATA).forEach((message) => {
+    const batch = messageCodec.decodeConnectionBatch(message.CONNECTION_DATA);
+    batch.connections.forEach((conn, i) => {
+      seen[batch.firstIndex + i] = conn.departureTime;
+    });
+  });
+  return Object.keys(seen).length;
+}
+
+// Just enough of the watch's connection window (connection_detail_window.c):
+// rows by index, and the version of the set once every row of it arrived
+function fakeWatch(sim) {
+  const watch = { rows: [], version: 0, batchVersion: 0, received: 0, patches: 0 };
+  sim.onWatchReceive((message) => {
+    if (message.CONNECTION_DATA) {
+      const batch = messageCodec.decodeConnectionBatch(message.CONNECTION_DATA);
+      if (batch.firstIndex === 0 || batch.version !== watch.batchVersion) {
+        watch.batchVersion = batch.version;
+        watch.received = 0;
+      }
+      batch.connections.forEach((conn, i) => {
+        watch.rows[batch.firstIndex + i] = conn.departureTime;
+      });
+      if (batch.firstIndex <= watch.received) {
+        watch.received = Math.max(watch.received, batch.firstIndex + batch.connections.length);
+      }
+      watch.version = watch.received >= batch.total ? batch.version : 0;
+    } else if (message.CONNECTION_PATCH) {
+      const patch = messageCodec.decodeConnectionPatch(message.CONNECTION_PATCH);
+      if (patch.baseVersion !== watch.version) {
+        return;
+      }
+      const previous = watch.rows.slice();
+      patch.updates.forEach((update) => {
+        watch.rows[update.index] = previous[update.from];
+      });
+      watch.rows.length = patch.total;
+      watch.version = patch.version;
+      watch.patches++;
+    }
+  });
+  return watch;
+}
+
+describe('AppMessage simulator', () => {
+  beforeEach(() => {
+    jest.useFakeTimers();
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+    jest.spyOn(console, 'error').mockImplementation(() => {});
+  });
+
+  afterEach(() => {
+    console.log.mockRestore();
+    console.error.mockRestore();
+    jest.useRealTimers();
+  });
+
+  test('sizes dictionaries the way the watch inbox does', () => {
+    expect(dictSize({ A: 1 })).toBe(1 + 7 + 4);
+    expect(dictSize({ A: 'Zü' })).toBe(1 + 7 + 4);
+    expect(dictSize({ A: [1, 2, 3], B: 5 })).toBe(1 + 7 + 3 + 7 + 4);
+  });
+
+  test('delivers a full result set end to end on a clean link', () => {
+    const sim = boot();
+    sim.sendFromWatch(REQUEST);
+    jest.runAllTimers();
+
+    expect(receivedConnections(sim)).toBe(CONNECTIONS.length);
+    const stats = sim.stats();
+    expect(stats.messages).toBe(stats.delivered);
+    expect(stats.messages).toBeLessThanOrEqual(3);
+    expect(stats.elapsedMs).toBeGreaterThan(0);
+    sim.log.forEach((entry) => expect(entry.bytes).toBeLessThanOrEqual(WATCH_INBOX_SIZE));
+  });
+
+  test('still delivers everything over a lossy, busy link', () => {
+    const clean = boot();
+    clean.sendFromWatch(REQUEST);
+    jest.runAllTimers();
+
+    const sim = boot({ lossRate: 0.2, busyRate: 0.2, seed: 3 });
+    sim.sendFromWatch(REQUEST);
+    jest.runAllTimers();
+
+    const stats = sim.stats();
+    expect(receivedConnections(sim)).toBe(CONNECTIONS.length);
+    expect(stats.lost + stats.busy).toBeGreaterThan(0);
+    expect(stats.messages).toBeGreaterThan(clean.stats().messages);
+    expect(stats.elapsedMs).toBeGreaterThan(clean.stats().elapsedMs);
+  });
+
+  test('a set that only partly arrived is resent in full, not patched', async () => {
+    let dropping = true;
+    const sim = boot({ dropIf: (message) => dropping && message.CONNECTION_DATA &&
+      messageCodec.decodeConnectionBatch(message.CONNECTION_DATA).firstIndex > 0 });
+    const watch = fakeWatch(sim);
+    const refresh = async () => {
+      sim.sendFromWatch(Object.assign({}, REQUEST, { CONNECTION_VERSION: watch.version }));
+      await jest.runAllTimersAsync();
+    };
+
+    await refresh();
+    expect(watch.received).toBe(1);
+    expect(watch.version).toBe(0);
+
+    dropping = false;
+    await refresh();
+    expect(watch.patches).toBe(0);
+    expect(watch.version).toBeGreaterThan(0);
+
+    // Now the phone may patch, and every row survives it
+    await refresh();
+    expect(watch.patches).toBe(1);
+    expect(watch.rows).toEqual(CONNECTIONS.map((conn) => conn.departureTime));
+  });
+
+  test('rejects messages larger than the watch inbox', () => {
+    const sim = boot();
+    const transport = require('../src/pkjs/transport');
+    const rejected = jest.fn();
+    transport.send({ CONNECTION_DATA: new Array(WATCH_INBOX_SIZE).fill(0) }).then(null, rejected);
+    jest.runAllTimers();
+
+    expect(sim.stats().overflow).toBe(transport.MAX_RETRIES + 1);
+    expect(sim.watchInbox).toHaveLength(0);
+  });
+
+  test('opens the settings page once the watch sent its favorites', () => {
+    const sim = boot();
+    sim.onWatchReceive((message) => {
+      if (message.REQUEST_FAVORITES) {
+        sim.sendFromWatch({ NUM_FAVORITES: 0 });
+      }
+    });
+    sim.showConfiguration();
+    jest.advanceTimersByTime(1000);
+
+    expect(sim.openedUrls).toHaveLength(1);
+    expect(sim.watchInbox.map((message) => Object.keys(message)[0])).toEqual(['REQUEST_FAVORITES']);
+  });
+
+  test('asks for the trace only when the settings page says so', () => {
+    const sim = boot();
+    const close = (config) => {
+      sim.closeConfiguration(encodeURIComponent(JSON.stringify(config)));
+      jest.runAllTimers();
+    };
+
+    close({ favorites: [] });
+    expect(sim.watchInbox.filter((message) => message.REQUEST_TRACE)).toHaveLength(0);
+
+    close({ favorites: [], dumpTrace: true });
+    expect(sim.watchInbox.filter((message) => message.REQUEST_TRACE)).toHaveLength(1);
+  });
+
+  test('replaying a recorded log reproduces the phone traffic', () => {
+    const original = boot({ lossRate: 0.1, seed: 7 });
+    original.sendFromWatch(REQUEST);
+    jest.advanceTimersByTime(500);
+    original.sendFromWatch(Object.assign({}, REQUEST, { CONNECTION_VERSION: 1 }));
+    jest.runAllTimers();
+
+    const replayed = boot({ lossRate: 0.1, seed: 7 });
+    replayed.replay(original.log);
+    jest.runAllTimers();
+
+    const summary = (sim) => sim.log.map((entry) =>
+      [entry.direction, entry.keys.join(','), entry.bytes, entry.outcome].join(' '));
+    expect(summary(replayed)).toEqual(summary(original));
+  });
+});
@@ -0,0 +1,187 @@
+// Host microbenchmarks for the watch data path: message decoding, record
+// persistence and the row formatting done for every menu cell. Inputs and
+// iteration counts are fixed so runs are comparable across commits; each
+// result is the fastest of BENCH_RUNS runs.
+//
+//   make bench   (results also go to ../bench_output.txt)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "persist_mock.h"
+#include "../src/message_codec.h"
+#include "../src/persistence.h"
+#include "../src/pinned_connection.h"
+#include "../src/row_model.h"
+#include "../src/string_pool.h"
+
+#define BENCH_RUNS 5
+#define FIXTURE_PATH "codec_fixture.bin"
+
+typedef void (*BenchFn)(void);
+
+typedef struct {
+    const char *name;
+    BenchFn fn;
+    int iterations;
+} Bench;
+
+static uint8_t s_fixture[512];
+static size_t s_fixture_length;
+static SavedConnection s_connections[MAX_SAVED_CONNECTIONS];
+static FavoriteDestination s_favorites[MAX_FAVORITE_DESTINATIONS];
+static PinnedConnection s_pinned;
+static Connection s_decoded;
+
+// Read by the benchmarks so the compiler can't drop the work
+static volatile int s_sink;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void load_fixture(void) {
+    FILE *file = fopen(FIXTURE_PATH, "rb");
+    if (!file) {
+        fprintf(stderr, "Missing %s, run through make bench\n", FIXTURE_PATH);
+        exit(1);
+    }
+    s_fixture_length = fread(s_fixture, 1, sizeof(s_fixture), file);
+    fclose(file);
+}
+
+static void setup_data(void) {
+    char dep[MAX_STATION_NAME_LENGTH];
+    char arr[MAX_STATION_NAME_LENGTH];
+    for (int i = 0; i < MAX_SAVED_CONNECTIONS; i++) {
+        snprintf(dep, sizeof(dep), "Departure station %d", i);
+        snprintf(arr, sizeof(arr), "Arrival station %d", i);
+        s_connections[i] = create_saved_connection("8503000", dep, "8507000", arr);
+    }
+    for (int i = 0; i < MAX_FAVORITE_DESTINATIONS; i++) {
+        snprintf(dep, sizeof(dep), "Favorite %d", i);
+        s_favorites[i] = create_favorite_destination("8503000", dep, "Home");
+    }
+
+    // The pinned journey is the first connection of the fixture
+    ConnectionBatch batch;
+    size_t offset = message_codec_decode_connection_batch(s_fixture, s_fixture_length, &batch);
+    message_codec_decode_connection(s_fixture + offset, s_fixture_length - offset, &s_decoded);
+    memset(&s_pinned, 0, sizeof(s_pinned));
+    s_pinned.connection = s_decoded;
+    s_pinned.route = s_connections[0];
+    s_pinned.pinned_at = 1699362000;
+    s_pinned.is_active = true;
+}
+
+static void bench_decode_batch(void) {
+    ConnectionBatch batch;
+    Connection conn;
+    size_t offset = message_codec_decode_connection_batch(s_fixture, s_fixture_length, &batch);
+    for (int i = 0; i < batch.count; i++) {
+        size_t consumed = message_codec_decode_connection(s_fixture + offset, s_fixture_length - offset, &conn);
+        offset += consumed;
+    }
+    s_sink = (int)offset;
+}
+
+static void bench_save_connections(void) {
+    save_connections(s_connections, MAX_SAVED_CONNECTIONS);
+}
+
+static void bench_load_connections(void) {
+    SavedConnection loaded[MAX_SAVED_CONNECTIONS];
+    s_sink = load_connections(loaded);
+}
+
+static void bench_save_favorites(void) {
+    save_favorite_destinations(s_favorites, MAX_FAVORITE_DESTINATIONS, NULL);
+}
+
+static void bench_load_favorites(void) {
+    FavoriteDestination loaded[MAX_FAVORITE_DESTINATIONS];
+    s_sink = load_favorite_destinations(loaded, NULL);
+}
+
+static void bench_save_pinned(void) {
+    save_pinned_connection(&s_pinned);
+}
+
+static void bench_load_pinned(void) {
+    s_sink = load_pinned_connection().is_active;
+}
+
+static void bench_format_time(void) {
+    char buffer[8];
+    row_model_format_time(s_decoded.departure_time, buffer, sizeof(buffer));
+    s_sink = buffer[0];
+}
+
+static void bench_build_connection_row(void) {
+    ConnectionRow row;
+    row_model_build_connection(&s_decoded, &row);
+    s_sink = row.time_text[0];
+}
+
+static void bench_build_section_row(void) {
+    JourneySectionRow row;
+    row_model_build_section(&s_decoded.sections[0], &row);
+    s_sink = row.departure[0];
+}
+
+static void bench_intern(void) {
+    s_sink = string_pool_intern("Zürich HB");
+}
+
+static const Bench s_benches[] = {
+    { "decode_connection_batch", bench_decode_batch, 200000 },
+    { "save_connections", bench_save_connections, 20000 },
+    { "load_connections", bench_load_connections, 20000 },
+    { "save_favorite_destinations", bench_save_favorites, 20000 },
+    { "load_favorite_destinations", bench_load_favorites, 20000 },
+    { "save_pinned_connection", bench_save_pinned, 20000 },
+    { "load_pinned_connection", bench_load_pinned, 20000 },
+    { "format_time", bench_format_time, 200000 },
+    { "build_connection_row", bench_build_connection_row, 100000 },
+    { "build_section_row", bench_build_section_row, 100000 },
+    { "string_pool_intern_hit", bench_intern, 200000 },
+};
+
+int main(void) {
+    setenv("TZ", "UTC", 1);
+    tzset();
+    load_fixture();
+    setup_data();
+
+    // Loads need something to read
+    save_connections(s_connections, MAX_SAVED_CONNECTIONS);
+    save_favorite_destinations(s_favorites, MAX_FAVORITE_DESTINATIONS, NULL);
+    save_pinned_connection(&s_pinned);
+
+    printf("%-28s %10s %10s %8s\n", "benchmark", "ns/op", "bytes/op", "writes/op");
+    for (size_t b = 0; b < sizeof(s_benches) / sizeof(s_benches[0]); b++) {
+        const Bench *bench = &s_benches[b];
+        uint64_t best = UINT64_MAX;
+        int bytes = 0, writes = 0;
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            persist_bytes_written = 0;
+            persist_write_count = 0;
+            uint64_t start = now_ns();
+            for (int i = 0; i < bench->iterations; i++) {
+                bench->fn();
+            }
+            uint64_t elapsed = now_ns() - start;
+            if (elapsed < best) {
+                best = elapsed;
+            }
+            bytes = persist_bytes_written;
+            writes = persist_write_count;
+        }
+        printf("%-28s %10.1f %10d %8d\n", bench->name, (double)best / bench->iterations,
+               bytes / bench->iterations, writes / bench->iterations);
+    }
+    return 0;
+}
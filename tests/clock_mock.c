@@ -0,0 +1,14 @@
+#include "clock_mock.h"
+
+uint32_t clock_mock_ms = 0;
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+    uint16_t millis = clock_mock_ms % 1000;
+    if (tloc) {
+        *tloc = clock_mock_ms / 1000;
+    }
+    if (out_ms) {
+        *out_ms = millis;
+    }
+    return millis;
+}
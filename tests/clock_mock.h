@@ -0,0 +1,4 @@
+#pragma once
+
+// Settable clock behind time_ms(), shared by the host tests that link trace.c
+extern uint32_t clock_mock_ms;
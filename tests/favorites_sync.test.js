@@ -0,0 +1,272 @@
+const { createSimulator } = require('./appmessage_simulator');
+
+jest.mock('../src/pkjs/sbb_api');
+
+const storage = {};
+global.localStorage = {
+  getItem: (key) => (key in storage ? storage[key] : null),
+  setItem: (key, value) => { storage[key] = String(value); },
+  removeItem: (key) => { delete storage[key]; }
+};
+
+const favoritesSync = require('../src/pkjs/favorites_sync');
+
+const FAVORITES = [
+  { id: '8507000', name: 'Bern', label: 'Work' },
+  { id: '8508500', name: 'Interlaken Ost', label: 'Hiking' },
+  { id: '8503000', name: 'Zürich HB', label: 'Home' }
+];
+
+const clone = (list) => list.map((fav) => Object.assign({}, fav));
+
+// A watch that applies deltas the way src/favorites_sync.c does
+function fakeWatch(sim, initial) {
+  const watch = { favorites: clone(initial), version: 0, hash: 0, pending: null };
+  sim.onWatchReceive((message) => {
+    if (message.REQUEST_FAVORITES) {
+      const current = message.FAVORITES_HASH === watch.hash && watch.hash !== 0 &&
+        message.FAVORITES_VERSION === watch.version;
+      const changes = current ? 0 : watch.favorites.length;
+      sim.sendFromWatch({
+        NUM_FAVORITES: watch.favorites.length,
+        FAVORITE_CHANGES: changes,
+        FAVORITES_VERSION: watch.version,
+        FAVORITES_HASH: watch.hash
+      });
+      watch.favorites.slice(0, changes).forEach((fav, index) => sim.sendFromWatch({
+        FAVORITE_DESTINATION_ID: fav.id,
+        FAVORITE_DESTINATION_NAME: fav.name,
+        FAVORITE_DESTINATION_LABEL: fav.label,
+        FAVORITE_INDEX: index
+      }));
+    } else if (message.NUM_FAVORITES !== undefined) {
+      if (message.FAVORITES_BASE_HASH !== undefined && message.FAVORITES_BASE_HASH !== watch.hash) {
+        watch.pending = null;
+        sim.sendFromWatch({ FAVORITES_VERSION: watch.version, FAVORITES_HASH: watch.hash });
+        return;
+      }
+      const base = message.FAVORITES_BASE_HASH !== undefined ? watch.favorites : [];
+      watch.pending = { header: message, list: clone(base).slice(0, message.NUM_FAVORITES), received: 0 };
+      if (message.FAVORITE_CHANGES === 0) {
+        commit();
+      }
+    } else if (message.FAVORITE_DESTINATION_ID !== undefined && watch.pending) {
+      watch.pending.list[message.FAVORITE_INDEX] = {
+        id: message.FAVORITE_DESTINATION_ID,
+        name: message.FAVORITE_DESTINATION_NAME,
+        label: message.FAVORITE_DESTINATION_LABEL
+      };
+      if (++watch.pending.received === watch.pending.header.FAVORITE_CHANGES) {
+        commit();
+      }
+    }
+  });
+
+  function commit() {
+    watch.favorites = watch.pending.list;
+    watch.version = watch.pending.header.FAVORITES_VERSION;
+    watch.hash = watch.pending.header.FAVORITES_HASH;
+    watch.pending = null;
+  }
+  return watch;
+}
+
+function boot(initial, options) {
+  jest.resetModules();
+  const sim = createSimulator(options).install();
+  require('../src/pkjs/index');
+  const watch = fakeWatch(sim, initial);
+  sim.ready();
+  return { sim, watch };
+}
+
+const phoneMessages = (sim) => sim.log.filter((entry) => entry.direction === 'phone');
+const watchMessages = (sim) => sim.log.filter((entry) => entry.direction === 'watch');
+
+function openedFavorites(sim) {
+  const url = sim.openedUrls[sim.openedUrls.length - 1];
+  const match = /favorites=([^&]*)/.exec(url);
+  return match ? JSON.parse(decodeURIComponent(match[1])) : [];
+}
+
+// Async so the acks, and the copy that follows them, are through
+async function saveConfig(sim, favorites) {
+  sim.closeConfiguration(encodeURIComponent(JSON.stringify({ favorites: favorites })));
+  await jest.runAllTimersAsync();
+}
+
+describe('Favorites sync', async () => {
+  beforeEach(() => {
+    Object.keys(storage).forEach((key) => delete storage[key]);
+    jest.useFakeTimers();
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+    jest.spyOn(console, 'error').mockImplementation(() => {});
+  });
+
+  afterEach(() => {
+    console.log.mockRestore();
+    console.error.mockRestore();
+    jest.useRealTimers();
+  });
+
+  test('hashes are stable, non-zero and content sensitive', () => {
+    const hash = favoritesSync.hashFavorites(FAVORITES);
+    expect(hash).toBe(favoritesSync.hashFavorites(clone(FAVORITES)));
+    expect(hash).not.toBe(0);
+    expect(hash | 0).toBe(hash);
+    expect(favoritesSync.hashFavorites([])).not.toBe(0);
+
+    const renamed = clone(FAVORITES);
+    renamed[2].label = 'Home2';
+    expect(favoritesSync.hashFavorites(renamed)).not.toBe(hash);
+    expect(favoritesSync.hashFavorites(FAVORITES.slice().reverse())).not.toBe(hash);
+  });
+
+  test('first save of an unsynced watch sends the header and changed entries only', async () => {
+    const { sim, watch } = boot(FAVORITES);
+    sim.showConfiguration();
+    jest.runAllTimers();
+    expect(openedFavorites(sim)).toEqual(FAVORITES);
+
+    const edited = clone(FAVORITES);
+    edited[1].label = 'Ski';
+    const before = phoneMessages(sim).length;
+    await saveConfig(sim, edited);
+
+    const sent = phoneMessages(sim).slice(before);
+    expect(sent).toHaveLength(2);
+    expect(sent[1].payload.FAVORITE_INDEX).toBe(1);
+    expect(watch.favorites).toEqual(edited);
+    expect(watch.hash).toBe(favoritesSync.hashFavorites(edited));
+  });
+
+  test('saving an unchanged list sends nothing', async () => {
+    const { sim, watch } = boot(FAVORITES);
+    sim.showConfiguration();
+    jest.runAllTimers();
+    await saveConfig(sim, clone(FAVORITES));
+    const version = watch.version;
+
+    const before = phoneMessages(sim).length;
+    await saveConfig(sim, clone(FAVORITES));
+    expect(phoneMessages(sim).length).toBe(before);
+    expect(watch.version).toBe(version);
+  });
+
+  test('reopening the page with a current copy transfers no favorites', async () => {
+    const { sim } = boot(FAVORITES);
+    sim.showConfiguration();
+    jest.runAllTimers();
+    await saveConfig(sim, clone(FAVORITES));
+
+    const before = watchMessages(sim).length;
+    sim.showConfiguration();
+    jest.runAllTimers();
+
+    const answered = watchMessages(sim).slice(before);
+    expect(answered).toHaveLength(1);
+    expect(answered[0].payload.FAVORITE_CHANGES).toBe(0);
+    expect(openedFavorites(sim)).toEqual(FAVORITES);
+  });
+
+  test('removing favorites is a header-only delta', async () => {
+    const { sim, watch } = boot(FAVORITES);
+    sim.showConfiguration();
+    jest.runAllTimers();
+    await saveConfig(sim, clone(FAVORITES));
+
+    const before = phoneMessages(sim).length;
+    await saveConfig(sim, FAVORITES.slice(0, 1));
+    const sent = phoneMessages(sim).slice(before);
+    expect(sent).toHaveLength(1);
+    expect(sent[0].payload.NUM_FAVORITES).toBe(1);
+    expect(watch.favorites).toEqual(FAVORITES.slice(0, 1));
+
+    await saveConfig(sim, []);
+    expect(watch.favorites).toEqual([]);
+  });
+
+  test('a rejected delta is followed by the full list', async () => {
+    const { sim, watch } = boot(FAVORITES);
+    sim.showConfiguration();
+    jest.runAllTimers();
+    await saveConfig(sim, clone(FAVORITES));
+
+    // The watch lost its list meanwhile
+    watch.favorites = [];
+    watch.hash = 0;
+    watch.version = 0;
+
+    const edited = clone(FAVORITES);
+    edited[0].label = 'Office';
+    await saveConfig(sim, edited);
+
+    expect(watch.favorites).toEqual(edited);
+    expect(watch.hash).toBe(favoritesSync.hashFavorites(edited));
+  });
+
+  test('the full list after a rejection continues past the watch version', async () => {
+    const { sim, watch } = boot(FAVORITES);
+    sim.showConfiguration();
+    jest.runAllTimers();
+    await saveConfig(sim, clone(FAVORITES));
+
+    // Another phone moved the watch on to a later version
+    watch.favorites = FAVORITES.slice(0, 1);
+    watch.hash = favoritesSync.hashFavorites(watch.favorites);
+    watch.version = 40;
+
+    const edited = clone(FAVORITES);
+    edited[0].label = 'Office';
+    const before = phoneMessages(sim).length;
+    await saveConfig(sim, edited);
+
+    const headers = phoneMessages(sim).slice(before)
+      .filter((entry) => entry.payload.NUM_FAVORITES !== undefined);
+    expect(headers).toHaveLength(2);
+    expect(headers[1].payload.FAVORITES_BASE_HASH).toBeUndefined();
+    expect(headers[1].payload.FAVORITES_VERSION).toBe(41);
+    expect(watch.favorites).toEqual(edited);
+    expect(watch.version).toBe(41);
+
+    // The copy now matches the watch, so reopening transfers nothing
+    const answered = watchMessages(sim).length;
+    sim.showConfiguration();
+    jest.runAllTimers();
+    expect(watchMessages(sim).slice(answered)).toHaveLength(1);
+    expect(openedFavorites(sim)).toEqual(edited);
+  });
+
+  test('a list the watch never acked is not taken as synced', async () => {
+    let dropping = true;
+    const { sim, watch } = boot(FAVORITES, {
+      dropIf: (message) => dropping && message.FAVORITE_INDEX === 2
+    });
+    sim.showConfiguration();
+    jest.runAllTimers();
+
+    const edited = clone(FAVORITES);
+    edited[2].label = 'Flat';
+    await saveConfig(sim, edited);
+    expect(watch.favorites).toEqual(FAVORITES);
+
+    // Saving the same list again still sends it
+    dropping = false;
+    const before = phoneMessages(sim).length;
+    await saveConfig(sim, clone(edited));
+    expect(phoneMessages(sim).length).toBeGreaterThan(before);
+    expect(watch.favorites).toEqual(edited);
+  });
+
+  test('a page opened without an answer starts from the copy', async () => {
+    const { sim } = boot(FAVORITES);
+    sim.showConfiguration();
+    jest.runAllTimers();
+    await saveConfig(sim, clone(FAVORITES));
+
+    sim.onWatchReceive(() => {});
+    sim.showConfiguration();
+    jest.runAllTimers();
+    expect(openedFavorites(sim)).toEqual(FAVORITES);
+  });
+});
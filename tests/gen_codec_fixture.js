@@ -0,0 +1,56 @@
+// Writes a connection batch packed by the JS encoder to stdout so that
+// test_message_codec can decode it with the generated C decoder. With the
+// "patch" argument it writes a refresh patch built by message_handler instead.
+// The values must match the expectations in test_message_codec.c.
+var messageCodec = require('../src/pkjs/message_codec');
+
+var connection = {
+    departureTime: 1699362720,
+    arrivalTime: 1699367220,
+    totalDelayMinutes: -1,
+    numChanges: 1,
+    sections: [
+        {
+            departureStation: 'Zürich HB',
+            arrivalStation: 'Olten',
+            departureTime: 1699362720,
+            arrivalTime: 1699365000,
+            platform: '7',
+            trainType: 'IC 712',
+            delayMinutes: 3
+        },
+        {
+            departureStation: 'Olten',
+            arrivalStation: 'Bern Wankdorf Bahnhof Nord Ost Ausgang',
+            departureTime: 1699365600,
+            arrivalTime: 1699367220,
+            platform: '11AB',
+            trainType: 'IR 2518',
+            delayMinutes: 0
+        }
+    ]
+};
+
+var later = {
+    departureTime: 1699364520,
+    arrivalTime: 1699369020,
+    totalDelayMinutes: 0,
+    numChanges: 0,
+    sections: []
+};
+
+if (process.argv[2] === 'patch') {
+    var messageHandler = require('../src/pkjs/message_handler');
+    // The first departure left, the second got delayed, a new one was added
+    var delayed = Object.assign({}, later, { totalDelayMinutes: 4 });
+    var added = Object.assign({}, later, { departureTime: 1699366320, arrivalTime: 1699370820 });
+    var patch = messageHandler.buildConnectionPatch([connection, later], [delayed, added], 9);
+    process.stdout.write(Buffer.from(patch.bytes));
+} else {
+    process.stdout.write(Buffer.from(messageCodec.encodeConnectionBatch({
+        firstIndex: 2,
+        total: 4,
+        version: 9,
+        connections: [connection, later]
+    })));
+}
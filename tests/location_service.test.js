@@ -1,5 +1,13 @@
 const locationService = require('../src/pkjs/location_service');
 
+// Mock localStorage as PebbleKit JS provides it
+const storage = {};
+global.localStorage = {
+  getItem: (key) => (key in storage ? storage[key] : null),
+  setItem: (key, value) => { storage[key] = String(value); },
+  removeItem: (key) => { delete storage[key]; }
+};
+
 // Mock navigator.geolocation
 global.navigator = {
   geolocation: {
@@ -19,6 +27,7 @@ describe('Location Service', () => {
     navigator.geolocation.getCurrentPosition.mockClear();
     sbbApi.fetchNearbyStations.mockClear();
     locationService._clearCache(); // Helper to clear cache for testing
+    locationService._useStations([]); // Always go to the network
   });
 
   test('requestNearbyStations fetches GPS and returns stations', (done) => {
@@ -47,7 +56,7 @@ describe('Location Service', () => {
     });
   });
 
-  test('requestNearbyStations uses cached data within 10 minutes', (done) => {
+  test('requestNearbyStations locates every time and reuses the tile of the fix', (done) => {
     const mockPosition = {
       coords: { latitude: 47.3769, longitude: 8.5417 }
     };
@@ -66,75 +75,61 @@ describe('Location Service', () => {
 
     // First call
     locationService.requestNearbyStations((err1, result1) => {
-      // Second call immediately after
+      // Second call immediately after, from the same spot
       locationService.requestNearbyStations((err2, result2) => {
         expect(result2).toEqual(mockStations);
-        expect(navigator.geolocation.getCurrentPosition).toHaveBeenCalledTimes(1);
+        expect(navigator.geolocation.getCurrentPosition).toHaveBeenCalledTimes(2);
         expect(sbbApi.fetchNearbyStations).toHaveBeenCalledTimes(1);
         done();
       });
     });
   });
 
-  test('requestNearbyStations re-fetches after cache expires', (done) => {
+  test('requestNearbyStations reports a GPS error even after an earlier success', (done) => {
     const mockPosition = {
       coords: { latitude: 47.3769, longitude: 8.5417 }
     };
 
-    const mockStations = [
-      { id: '8503000', name: 'Zürich HB', distance: 1200 }
-    ];
-
-    navigator.geolocation.getCurrentPosition.mockImplementation((success) => {
+    navigator.geolocation.getCurrentPosition.mockImplementationOnce((success) => {
       success(mockPosition);
     });
-
     sbbApi.fetchNearbyStations.mockImplementation((lat, lon, callback) => {
-      callback(null, mockStations);
+      callback(null, [{ id: '8503000', name: 'Zürich HB', distance: 1200 }]);
     });
 
-    // First call
-    locationService.requestNearbyStations((err1, result1) => {
-      // Mock time passing
-      locationService._expireCache();
+    locationService.requestNearbyStations(() => {
+      // The user may be anywhere by now
+      navigator.geolocation.getCurrentPosition.mockImplementationOnce((success, error) => {
+        error({ code: 1, message: 'User denied' });
+      });
 
-      // Second call after cache expired
-      locationService.requestNearbyStations((err2, result2) => {
-        expect(navigator.geolocation.getCurrentPosition).toHaveBeenCalledTimes(2);
-        expect(sbbApi.fetchNearbyStations).toHaveBeenCalledTimes(2);
+      locationService.requestNearbyStations((err, result) => {
+        expect(err).toBeTruthy();
+        expect(result).toBeNull();
         done();
       });
     });
   });
 
-  test('requestNearbyStations returns cached data on GPS error', (done) => {
-    const mockPosition = {
-      coords: { latitude: 47.3769, longitude: 8.5417 }
-    };
-
-    const mockStations = [
-      { id: '8503000', name: 'Zürich HB', distance: 1200 }
-    ];
-
-    // First successful call
+  test('requestNearbyStations never answers an API failure with another place', (done) => {
     navigator.geolocation.getCurrentPosition.mockImplementationOnce((success) => {
-      success(mockPosition);
+      success({ coords: { latitude: 47.3769, longitude: 8.5417 } });
     });
-    sbbApi.fetchNearbyStations.mockImplementation((lat, lon, callback) => {
-      callback(null, mockStations);
+    sbbApi.fetchNearbyStations.mockImplementationOnce((lat, lon, callback) => {
+      callback(null, [{ id: '8503000', name: 'Zürich HB', distance: 1200 }]);
     });
 
-    locationService.requestNearbyStations((err1, result1) => {
-      // Clear cache to force GPS call
-      locationService._expireCache();
-
-      // Second call with GPS error
-      navigator.geolocation.getCurrentPosition.mockImplementationOnce((success, error) => {
-        error({ code: 1, message: 'User denied' });
+    locationService.requestNearbyStations(() => {
+      navigator.geolocation.getCurrentPosition.mockImplementationOnce((success) => {
+        success({ coords: { latitude: 46.9490, longitude: 7.4393 } });
+      });
+      sbbApi.fetchNearbyStations.mockImplementationOnce((lat, lon, callback) => {
+        callback(new Error('offline'), null);
       });
 
-      locationService.requestNearbyStations((err2, result2) => {
-        expect(result2).toEqual(mockStations);
+      locationService.requestNearbyStations((err, result) => {
+        expect(err).toBeTruthy();
+        expect(result).toBeNull();
         done();
       });
     });
@@ -151,4 +146,154 @@ describe('Location Service', () => {
       done();
     });
   });
+
+  describe('geotile cache', () => {
+    const zurich = { coords: { latitude: 47.3769, longitude: 8.5417 } };
+    const nearZurich = { coords: { latitude: 47.3771, longitude: 8.5419 } };
+    const bern = { coords: { latitude: 46.9490, longitude: 7.4393 } };
+
+    const locateAt = (position) => {
+      navigator.geolocation.getCurrentPosition.mockImplementation((success) => success(position));
+    };
+
+    const request = (service) => new Promise((resolve) => {
+      service.requestNearbyStations((err, result) => resolve(result));
+    });
+
+    beforeEach(() => {
+      sbbApi.fetchNearbyStations.mockImplementation((lat, lon, callback) => {
+        callback(null, [{ id: String(Math.round(lat * 1000)), name: 'Station', distance: 100 }]);
+      });
+    });
+
+    test('fixes in the same tile share one lookup', async () => {
+      locateAt(zurich);
+      const first = await request(locationService);
+      locateAt(nearZurich);
+      const second = await request(locationService);
+
+      expect(second).toEqual(first);
+      expect(sbbApi.fetchNearbyStations).toHaveBeenCalledTimes(1);
+    });
+
+    test('a fix in another tile is looked up', async () => {
+      locateAt(zurich);
+      await request(locationService);
+      locateAt(bern);
+      const result = await request(locationService);
+
+      expect(result[0].id).toBe('46949');
+      expect(sbbApi.fetchNearbyStations).toHaveBeenCalledTimes(2);
+    });
+
+    test('tiles expire after their TTL', async () => {
+      jest.useFakeTimers();
+      jest.setSystemTime(new Date('2025-11-07T08:00:00Z'));
+      locateAt(zurich);
+      await request(locationService);
+      jest.setSystemTime(new Date('2025-11-07T08:00:00Z').getTime() + locationService.TILE_CACHE_DURATION);
+      await request(locationService);
+      jest.useRealTimers();
+
+      expect(sbbApi.fetchNearbyStations).toHaveBeenCalledTimes(2);
+    });
+
+    test('keeps at most TILE_CACHE_MAX_TILES tiles', async () => {
+      for (let i = 0; i <= locationService.TILE_CACHE_MAX_TILES; i++) {
+        locateAt({ coords: { latitude: 46 + i * 0.01, longitude: 7 } });
+          await request(locationService);
+      }
+
+      const tiles = Object.keys(storage).filter((key) => key.indexOf('geotile:') === 0);
+      expect(tiles).toHaveLength(locationService.TILE_CACHE_MAX_TILES);
+      expect(JSON.parse(storage.geotiles)).toHaveLength(locationService.TILE_CACHE_MAX_TILES);
+    });
+
+    test('tiles survive a PebbleKit JS restart', async () => {
+      locateAt(zurich);
+      const first = await request(locationService);
+
+      jest.resetModules();
+      const restartedApi = require('../src/pkjs/sbb_api');
+      const restarted = require('../src/pkjs/location_service');
+      restarted._useStations([]);
+      const second = await request(restarted);
+
+      expect(second).toEqual(first);
+      expect(restartedApi.fetchNearbyStations).not.toHaveBeenCalled();
+    });
+  });
+
+  describe('bundled stations', () => {
+    const fixture = require('./stations_fixture.json');
+
+    beforeEach(() => {
+      locationService._useStations(fixture);
+    });
+
+    test('answers a fix with a full page of bundled stations close by without the network', (done) => {
+      // A dense set around the fix, as a complete stop list would have
+      const dense = [];
+      for (let i = 0; i < locationService.LOCAL_STATION_COUNT + 2; i++) {
+        dense.push([String(100 + i), 'Stop ' + i, 47.0 + (i + 1) * 0.0005, 8.0]);
+      }
+      locationService._useStations(dense);
+      navigator.geolocation.getCurrentPosition.mockImplementation((success) => {
+        success({ coords: { latitude: 47.0, longitude: 8.0 } });
+      });
+
+      locationService.requestNearbyStations((err, result) => {
+        expect(err).toBeNull();
+        expect(result).toHaveLength(locationService.LOCAL_STATION_COUNT);
+        expect(result[0].id).toBe('100');
+        expect(sbbApi.fetchNearbyStations).not.toHaveBeenCalled();
+        done();
+      });
+    });
+
+    test('asks the API when only a few bundled stations are close', (done) => {
+      navigator.geolocation.getCurrentPosition.mockImplementation((success) => {
+        success({ coords: { latitude: 47.0, longitude: 8.0 } });
+      });
+      sbbApi.fetchNearbyStations.mockImplementation((lat, lon, callback) => {
+        callback(null, [{ id: '8500001', name: 'Local stop', distance: 80 }]);
+      });
+
+      locationService.requestNearbyStations((err, result) => {
+        expect(result[0].id).toBe('8500001');
+        expect(sbbApi.fetchNearbyStations).toHaveBeenCalledTimes(1);
+        done();
+      });
+    });
+
+    test('falls back to bundled stations when the API fails', (done) => {
+      navigator.geolocation.getCurrentPosition.mockImplementation((success) => {
+        success({ coords: { latitude: 47.0, longitude: 8.0 } });
+      });
+      sbbApi.fetchNearbyStations.mockImplementation((lat, lon, callback) => {
+        callback(new Error('offline'), null);
+      });
+
+      locationService.requestNearbyStations((err, result) => {
+        expect(err).toBeNull();
+        expect(result.map((station) => station.id)).toEqual(['2', '3', '1', '4']);
+        done();
+      });
+    });
+
+    test('falls back to the API away from bundled stations', (done) => {
+      navigator.geolocation.getCurrentPosition.mockImplementation((success) => {
+        success({ coords: { latitude: 46.2, longitude: 7.0 } });
+      });
+      sbbApi.fetchNearbyStations.mockImplementation((lat, lon, callback) => {
+        callback(null, [{ id: '8501506', name: 'Sion', distance: 900 }]);
+      });
+
+      locationService.requestNearbyStations((err, result) => {
+        expect(result[0].id).toBe('8501506');
+        expect(sbbApi.fetchNearbyStations).toHaveBeenCalledTimes(1);
+        done();
+      });
+    });
+  });
 });
@@ -0,0 +1,126 @@
+const fs = require('fs');
+const path = require('path');
+const messageCodec = require('../src/pkjs/message_codec');
+const genCodec = require('../tools/gen_codec');
+
+const sampleConnection = {
+  departureTime: 1699362720,
+  arrivalTime: 1699367220,
+  totalDelayMinutes: 3,
+  numChanges: 1,
+  sections: [
+    {
+      departureStation: 'Zürich HB',
+      arrivalStation: 'Olten',
+      departureTime: 1699362720,
+      arrivalTime: 1699365000,
+      platform: '7',
+      trainType: 'IC 712',
+      delayMinutes: 3
+    },
+    {
+      departureStation: 'Olten',
+      arrivalStation: 'Bern',
+      departureTime: 1699365600,
+      arrivalTime: 1699367220,
+      platform: '11',
+      trainType: 'IR 2518',
+      delayMinutes: 0
+    }
+  ]
+};
+
+describe('Message Codec', () => {
+  test('generated codec files are up to date with the schema', () => {
+    const outputs = genCodec.generate(genCodec.loadSchema());
+    Object.keys(outputs).forEach((relPath) => {
+      const onDisk = fs.readFileSync(path.join(__dirname, '..', relPath), 'utf8');
+      expect(onDisk).toBe(outputs[relPath]);
+    });
+  });
+
+  test('encodeConnection packs times little-endian', () => {
+    const bytes = messageCodec.encodeConnection(sampleConnection);
+
+    // departureTime 1699362720 = 0x654A37A0
+    expect(bytes.slice(0, 4)).toEqual([0xA0, 0x37, 0x4A, 0x65]);
+    bytes.forEach((b) => {
+      expect(b).toBeGreaterThanOrEqual(0);
+      expect(b).toBeLessThanOrEqual(255);
+    });
+  });
+
+  test('packed connection is much smaller than the old tuple dictionary', () => {
+    const bytes = messageCodec.encodeConnection(sampleConnection);
+    // Two full sections including station names still fit in ~80 bytes
+    expect(bytes.length).toBeLessThan(90);
+  });
+
+  test('round-trips a connection through encode and decode', () => {
+    const decoded = messageCodec.decodeConnection(messageCodec.encodeConnection(sampleConnection));
+    expect(decoded).toEqual(sampleConnection);
+  });
+
+  test('round-trips negative delays', () => {
+    const early = Object.assign({}, sampleConnection, { totalDelayMinutes: -2, sections: [] });
+    const decoded = messageCodec.decodeConnection(messageCodec.encodeConnection(early));
+    expect(decoded.totalDelayMinutes).toBe(-2);
+  });
+
+  test('truncates strings on a UTF-8 character boundary', () => {
+    // 30 ASCII chars + 'ü' (2 bytes) would need 32 bytes, leaving no room for the terminator
+    const name = 'A'.repeat(30) + 'ü';
+    const bytes = messageCodec.encodeSection({ departureStation: name });
+
+    expect(bytes[0]).toBe(30);
+    const decoded = messageCodec.decodeSection(bytes);
+    expect(decoded.departureStation).toBe('A'.repeat(30));
+  });
+
+  test('limits connections to five sections', () => {
+    const many = Object.assign({}, sampleConnection, {
+      sections: Array(7).fill(sampleConnection.sections[0])
+    });
+    const decoded = messageCodec.decodeConnection(messageCodec.encodeConnection(many));
+    expect(decoded.sections).toHaveLength(5);
+  });
+
+  test('batches start with the schema version and carry their position in the result set', () => {
+    const bytes = messageCodec.encodeConnectionBatch({
+      firstIndex: 1,
+      total: 3,
+      version: 7,
+      connections: [sampleConnection, sampleConnection]
+    });
+
+    expect(bytes.slice(0, 5)).toEqual([messageCodec.SCHEMA_VERSION, 1, 3, 7, 2]);
+    const decoded = messageCodec.decodeConnectionBatch(bytes);
+    expect(decoded.connections).toEqual([sampleConnection, sampleConnection]);
+  });
+
+  test('rejects batches with a different schema version', () => {
+    const bytes = messageCodec.encodeConnectionBatch({ firstIndex: 0, total: 1, connections: [sampleConnection] });
+    bytes[0] = messageCodec.SCHEMA_VERSION + 1;
+    expect(() => messageCodec.decodeConnectionBatch(bytes)).toThrow('schema version');
+  });
+
+  test('round-trips a station list and clamps distances to 16 bits', () => {
+    const bytes = messageCodec.encodeStationList({
+      stations: [
+        { id: '8503000', name: 'Zürich HB', distance: 120 },
+        { id: '8500010', name: 'Basel SBB', distance: 90000 }
+      ]
+    });
+
+    expect(bytes.slice(0, 2)).toEqual([messageCodec.SCHEMA_VERSION, 2]);
+    expect(messageCodec.decodeStationList(bytes).stations).toEqual([
+      { id: '8503000', name: 'Zürich HB', distance: 120 },
+      { id: '8500010', name: 'Basel SBB', distance: 65535 }
+    ]);
+  });
+
+  test('rejects truncated payloads', () => {
+    const bytes = messageCodec.encodeConnection(sampleConnection);
+    expect(() => messageCodec.decodeConnection(bytes.slice(0, bytes.length - 1))).toThrow('Truncated');
+  });
+});
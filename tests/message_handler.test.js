@@ -6,6 +6,8 @@ jest.mock('../src/pkjs/location_service');
 
 const sbbApi = require('../src/pkjs/sbb_api');
 const locationService = require('../src/pkjs/location_service');
+const messageCodec = require('../src/pkjs/message_codec');
+const transport = require('../src/pkjs/transport');
 
 // Mock Pebble
 global.Pebble = {
@@ -14,12 +16,13 @@ global.Pebble = {
 
 describe('Message Handler', () => {
   beforeEach(() => {
+    transport.reset();
     Pebble.sendAppMessage.mockClear();
     sbbApi.fetchConnections.mockClear();
     locationService.requestNearbyStations.mockClear();
   });
 
-  test('handleNearbyStationsRequest sends stations to watch', (done) => {
+  test('handleNearbyStationsRequest sends all stations in one message, nearest first', (done) => {
     const mockStations = [
       { id: '8503000', name: 'Zürich HB', distance: 1200 },
       { id: '8503006', name: 'Zürich Stadelhofen', distance: 800 }
@@ -42,20 +45,30 @@ describe('Message Handler', () => {
     // Wait a tick for the async callback to execute
     setTimeout(() => {
       expect(locationService.requestNearbyStations).toHaveBeenCalled();
-      expect(Pebble.sendAppMessage).toHaveBeenCalledTimes(2);
-      expect(Pebble.sendAppMessage).toHaveBeenCalledWith(
-        expect.objectContaining({
-          STATION_ID: '8503000',
-          STATION_NAME: 'Zürich HB',
-          STATION_DISTANCE: 1200
-        }),
-        expect.any(Function),
-        expect.any(Function)
-      );
+      expect(Pebble.sendAppMessage).toHaveBeenCalledTimes(1);
+      const msg = Pebble.sendAppMessage.mock.calls[0][0];
+      expect(messageCodec.decodeStationList(msg.STATION_LIST).stations).toEqual([
+        { id: '8503006', name: 'Zürich Stadelhofen', distance: 800 },
+        { id: '8503000', name: 'Zürich HB', distance: 1200 }
+      ]);
       done();
     }, 10);
   });
 
+  test('buildStationList keeps the ten nearest stations within the watch inbox', () => {
+    const stations = [];
+    for (let i = 0; i < 15; i++) {
+      stations.push({ id: '85' + String(i).padStart(14, '0'), name: 'X'.repeat(40), distance: 5000 - i * 100 });
+    }
+
+    const bytes = messageHandler.buildStationList(stations);
+    const decoded = messageCodec.decodeStationList(bytes).stations;
+    expect(bytes.length).toBeLessThanOrEqual(504);
+    expect(decoded).toHaveLength(10);
+    expect(decoded[0].distance).toBe(3600);
+    expect(decoded[9].distance).toBe(4500);
+  });
+
   test('handleConnectionsRequest sends connection data to watch', (done) => {
     const mockConnections = [
       {
@@ -95,21 +108,364 @@ describe('Message Handler', () => {
       expect(sbbApi.fetchConnections).toHaveBeenCalledWith('8503000', '8507000', expect.any(Function));
       expect(Pebble.sendAppMessage).toHaveBeenCalledWith(
         expect.objectContaining({
-          CONNECTION_DATA: 1,
-          DEPARTURE_TIME: 1699362720,
-          ARRIVAL_TIME: 1699367220,
-          PLATFORM: '7',
-          TRAIN_TYPE: 'IC 712',
-          DELAY_MINUTES: 3,
-          NUM_CHANGES: 0
+          CONNECTION_DATA: expect.any(Array)
         }),
         expect.any(Function),
         expect.any(Function)
       );
+
+      const sent = Pebble.sendAppMessage.mock.calls[0][0];
+      const batch = messageCodec.decodeConnectionBatch(sent.CONNECTION_DATA);
+      expect(batch.firstIndex).toBe(0);
+      expect(batch.total).toBe(1);
+      expect(batch.connections).toHaveLength(1);
+
+      const decoded = batch.connections[0];
+      expect(decoded.departureTime).toBe(1699362720);
+      expect(decoded.arrivalTime).toBe(1699367220);
+      expect(decoded.totalDelayMinutes).toBe(3);
+      expect(decoded.numChanges).toBe(0);
+      expect(decoded.sections[0].platform).toBe('7');
+      expect(decoded.sections[0].trainType).toBe('IC 712');
       done();
     }, 10);
   });
 
+  test('handleConnectionsRequest sends first connection alone, then the rest in one batch', (done) => {
+    const mockConnections = Array(5).fill(null).map((_, i) => ({
+      departureTime: 1699362720 + i * 1800,
+      arrivalTime: 1699367220 + i * 1800,
+      totalDelayMinutes: 0,
+      numChanges: 1,
+      sections: [
+        { departureStation: 'Zürich HB', arrivalStation: 'Olten', platform: '7', trainType: 'IC ' + i },
+        { departureStation: 'Olten', arrivalStation: 'Bern', platform: '4', trainType: 'IR ' + i }
+      ]
+    }));
+
+    sbbApi.fetchConnections.mockImplementation((fromId, toId, callback) => {
+      callback(null, mockConnections);
+    });
+
+    Pebble.sendAppMessage.mockImplementation((msg, success) => {
+      success();
+    });
+
+    messageHandler.handleAppMessage({
+      payload: {
+        REQUEST_CONNECTIONS: 1,
+        DEPARTURE_STATION_ID: '8503000',
+        ARRIVAL_STATION_ID: '8507000'
+      }
+    });
+
+    setTimeout(() => {
+      expect(Pebble.sendAppMessage).toHaveBeenCalledTimes(2);
+
+      const first = messageCodec.decodeConnectionBatch(Pebble.sendAppMessage.mock.calls[0][0].CONNECTION_DATA);
+      expect(first.firstIndex).toBe(0);
+      expect(first.total).toBe(5);
+      expect(first.connections).toHaveLength(1);
+
+      const rest = messageCodec.decodeConnectionBatch(Pebble.sendAppMessage.mock.calls[1][0].CONNECTION_DATA);
+      expect(rest.firstIndex).toBe(1);
+      expect(rest.total).toBe(5);
+      expect(rest.connections.map((c) => c.sections[0].trainType)).toEqual(['IC 1', 'IC 2', 'IC 3', 'IC 4']);
+      done();
+    }, 10);
+  });
+
+  test('handleConnectionsRequest retries a NACKed batch with backoff', () => {
+    jest.useFakeTimers();
+    const mockConnections = Array(3).fill(null).map((_, i) => ({
+      departureTime: 1699362720 + i * 1800,
+      arrivalTime: 1699367220 + i * 1800,
+      sections: [{ departureStation: 'Zürich HB', arrivalStation: 'Bern', trainType: 'IC ' + i }]
+    }));
+
+    sbbApi.fetchConnections.mockImplementation((fromId, toId, callback) => {
+      callback(null, mockConnections);
+    });
+
+    // Second message is NACKed once, then accepted
+    let nacked = false;
+    Pebble.sendAppMessage.mockImplementation((msg, success, failure) => {
+      const batch = messageCodec.decodeConnectionBatch(msg.CONNECTION_DATA);
+      if (batch.firstIndex === 1 && !nacked) {
+        nacked = true;
+        failure();
+      } else {
+        success();
+      }
+    });
+
+    messageHandler.handleAppMessage({
+      payload: {
+        REQUEST_CONNECTIONS: 1,
+        DEPARTURE_STATION_ID: '8503000',
+        ARRIVAL_STATION_ID: '8507000'
+      }
+    });
+
+    expect(Pebble.sendAppMessage).toHaveBeenCalledTimes(2);
+    jest.advanceTimersByTime(250);
+    expect(Pebble.sendAppMessage).toHaveBeenCalledTimes(3);
+
+    const retried = messageCodec.decodeConnectionBatch(Pebble.sendAppMessage.mock.calls[2][0].CONNECTION_DATA);
+    expect(retried.firstIndex).toBe(1);
+    expect(retried.connections).toHaveLength(2);
+    jest.useRealTimers();
+  });
+
+  test('handleConnectionsRequest gives up after a bounded number of retries', () => {
+    jest.useFakeTimers();
+    sbbApi.fetchConnections.mockImplementation((fromId, toId, callback) => {
+      callback(null, [{ sections: [] }, { sections: [] }]);
+    });
+    Pebble.sendAppMessage.mockImplementation((msg, success, failure) => {
+      const batch = messageCodec.decodeConnectionBatch(msg.CONNECTION_DATA);
+      if (batch.firstIndex === 0) {
+        success();
+      } else {
+        failure();
+      }
+    });
+
+    messageHandler.handleAppMessage({
+      payload: {
+        REQUEST_CONNECTIONS: 1,
+        DEPARTURE_STATION_ID: '8503000',
+        ARRIVAL_STATION_ID: '8507000'
+      }
+    });
+
+    jest.runAllTimers();
+    // One initial send plus three retries of the second message
+    expect(Pebble.sendAppMessage).toHaveBeenCalledTimes(5);
+    jest.useRealTimers();
+  });
+
+  describe('delta refresh', () => {
+    const makeConnection = (minutes, delay) => ({
+      departureTime: 1699362720 + minutes * 60,
+      arrivalTime: 1699367220 + minutes * 60,
+      totalDelayMinutes: delay,
+      numChanges: 0,
+      sections: [{
+        departureStation: 'Zürich HB', arrivalStation: 'Bern',
+        departureTime: 1699362720 + minutes * 60, arrivalTime: 1699367220 + minutes * 60,
+        platform: '7', trainType: 'IC ' + minutes, delayMinutes: delay
+      }]
+    });
+
+    const request = (version) => messageHandler.handleAppMessage({
+      payload: {
+        REQUEST_CONNECTIONS: 1,
+        DEPARTURE_STATION_ID: '8503000',
+        ARRIVAL_STATION_ID: '8509000',
+        CONNECTION_VERSION: version
+      }
+    });
+
+    // Acks resolve the transport's promises, so results are stored a tick later
+    const flush = () => new Promise((resolve) => setImmediate(resolve));
+
+    test('sends the full set first, then only a patch when the watch is in sync', async () => {
+      const first = [makeConnection(0, 0), makeConnection(30, 0)];
+      const second = [makeConnection(0, 2), makeConnection(30, 0)];
+      sbbApi.fetchConnections.mockImplementationOnce((from, to, callback) => callback(null, first));
+      sbbApi.fetchConnections.mockImplementationOnce((from, to, callback) => callback(null, second));
+      Pebble.sendAppMessage.mockImplementation((msg, success) => success());
+
+      request(0);
+      const full = messageCodec.decodeConnectionBatch(Pebble.sendAppMessage.mock.calls[0][0].CONNECTION_DATA);
+      expect(full.version).toBe(1);
+      await flush();
+      Pebble.sendAppMessage.mockClear();
+
+      request(1);
+      expect(Pebble.sendAppMessage).toHaveBeenCalledTimes(1);
+      const patch = messageCodec.decodeConnectionPatch(Pebble.sendAppMessage.mock.calls[0][0].CONNECTION_PATCH);
+      expect(patch.baseVersion).toBe(1);
+      expect(patch.version).toBe(2);
+      expect(patch.updates).toEqual([{
+        index: 0, from: 0, totalDelayMinutes: 2,
+        sections: [{ delayMinutes: 2, platform: '7' }]
+      }]);
+    });
+
+    test('echoes the request id, watch time and stage timings with the first message', () => {
+      const connections = [makeConnection(0, 0), makeConnection(30, 0)];
+      sbbApi.fetchConnections.mockImplementation((from, to, callback) =>
+        callback(null, connections, { fetchMs: 420, parseMs: 15 }));
+      Pebble.sendAppMessage.mockImplementation((msg, success) => success());
+
+      messageHandler.handleAppMessage({
+        payload: {
+          REQUEST_CONNECTIONS: 1,
+          DEPARTURE_STATION_ID: '8503000',
+          ARRIVAL_STATION_ID: '8509000',
+          CONNECTION_VERSION: 0,
+          REQUEST_ID: 7,
+          REQUEST_TIME: 4000000000
+        }
+      });
+
+      const calls = Pebble.sendAppMessage.mock.calls;
+      const timing = messageCodec.decodeRequestTiming(calls[0][0].REQUEST_TIMING);
+      expect(timing.requestId).toBe(7);
+      expect(timing.watchTime).toBe(4000000000);
+      expect(timing.fetchMs).toBe(420);
+      expect(timing.parseMs).toBe(15);
+      expect(timing.phoneMs).toBeGreaterThanOrEqual(0);
+      expect(calls[1][0].REQUEST_TIMING).toBeUndefined();
+    });
+
+    test('sends no timings for requests without an id', () => {
+      sbbApi.fetchConnections.mockImplementation((from, to, callback) => callback(null, [makeConnection(0, 0)]));
+      Pebble.sendAppMessage.mockImplementation((msg, success) => success());
+
+      request(0);
+      expect(Pebble.sendAppMessage.mock.calls[0][0].REQUEST_TIMING).toBeUndefined();
+    });
+
+    test('sends the full set again when the watch lost track', async () => {
+      const connections = [makeConnection(0, 0)];
+      sbbApi.fetchConnections.mockImplementation((from, to, callback) => callback(null, connections));
+      Pebble.sendAppMessage.mockImplementation((msg, success) => success());
+
+      request(0);
+      await flush();
+      Pebble.sendAppMessage.mockClear();
+      request(0);
+
+      const msg = Pebble.sendAppMessage.mock.calls[0][0];
+      expect(msg.CONNECTION_PATCH).toBeUndefined();
+      expect(messageCodec.decodeConnectionBatch(msg.CONNECTION_DATA).version).toBeGreaterThan(1);
+    });
+
+    test('patches only against a set the watch acked in full', async () => {
+      const connections = [makeConnection(0, 0), makeConnection(30, 0)];
+      sbbApi.fetchConnections.mockImplementation((from, to, callback) => callback(null, connections));
+      // The second batch never gets through
+      Pebble.sendAppMessage.mockImplementation((msg, success, failure) => {
+        const batch = msg.CONNECTION_DATA && messageCodec.decodeConnectionBatch(msg.CONNECTION_DATA);
+        if (batch && batch.firstIndex > 0) {
+          failure({ data: msg, error: 'timeout' });
+        } else {
+          success();
+        }
+      });
+
+      jest.useFakeTimers();
+      request(0);
+      jest.runAllTimers();
+      jest.useRealTimers();
+      await flush();
+      const sent = messageCodec.decodeConnectionBatch(Pebble.sendAppMessage.mock.calls[0][0].CONNECTION_DATA);
+      Pebble.sendAppMessage.mockClear();
+
+      // Even a watch claiming that version gets the whole set
+      request(sent.version);
+      const msg = Pebble.sendAppMessage.mock.calls[0][0];
+      expect(msg.CONNECTION_PATCH).toBeUndefined();
+      expect(messageCodec.decodeConnectionBatch(msg.CONNECTION_DATA).firstIndex).toBe(0);
+    });
+
+    test('an unchanged set produces an empty patch that keeps the version', () => {
+      const connections = [makeConnection(0, 0), makeConnection(30, 1)];
+      const patch = messageHandler.buildConnectionPatch(connections, connections, 5);
+      const decoded = messageCodec.decodeConnectionPatch(patch.bytes);
+
+      expect(patch.version).toBe(5);
+      expect(decoded.updates).toEqual([]);
+      expect(patch.bytes.length).toBe(5);
+    });
+
+    test('departed and added connections become moves plus full records', () => {
+      const previous = [makeConnection(0, 0), makeConnection(30, 0), makeConnection(60, 0)];
+      const next = [makeConnection(30, 0), makeConnection(60, 0), makeConnection(90, 0)];
+      const patch = messageHandler.buildConnectionPatch(previous, next, 255);
+
+      // Versions wrap around without reaching 0
+      expect(patch.version).toBe(1);
+
+      const bytes = patch.bytes;
+      const header = messageCodec.decodeConnectionPatch(bytes.slice(0, 4).concat([0]));
+      expect(header.total).toBe(3);
+      expect(bytes[4]).toBe(3);
+      // Two moves (5 bytes each with unchanged sections), then the new departure
+      const moves = bytes.slice(5, 15);
+      expect(moves).toEqual([0, 1, 0, 0, 0, 1, 2, 0, 0, 0]);
+      expect(bytes.slice(15, 17)).toEqual([2, 0xFF]);
+      expect(messageCodec.decodeConnection(bytes.slice(20))).toEqual(next[2]);
+    });
+
+    test('falls back to a full send when kept connections change order', () => {
+      const a = makeConnection(0, 0);
+      const b = makeConnection(30, 0);
+      expect(messageHandler.buildConnectionPatch([a, b], [b, a], 1)).toBeNull();
+    });
+  });
+
+  test('buildConnectionBatches splits batches that would overflow the watch inbox', () => {
+    const longName = 'Station with a rather long name';
+    const section = {
+      departureStation: longName,
+      arrivalStation: longName,
+      platform: '12AB',
+      trainType: 'InterRegio 1234'
+    };
+    const connections = Array(5).fill(null).map(() => ({
+      sections: [section, section, section, section]
+    }));
+
+    const messages = messageHandler.buildConnectionBatches(connections);
+
+    expect(messages.length).toBeGreaterThan(2);
+    let next = 0;
+    messages.forEach((msg) => {
+      expect(msg.CONNECTION_DATA.length).toBeLessThanOrEqual(504);
+      const batch = messageCodec.decodeConnectionBatch(msg.CONNECTION_DATA);
+      expect(batch.firstIndex).toBe(next);
+      next += batch.connections.length;
+    });
+    expect(next).toBe(5);
+  });
+
+  test('buildConnectionBatches shortens a connection too large for the inbox on its own', () => {
+    const longName = (leg) => 'Station ' + leg + ' ' + 'x'.repeat(40);
+    const maximal = {
+      departureTime: 1699362720,
+      arrivalTime: 1699380720,
+      totalDelayMinutes: 12,
+      numChanges: 4,
+      sections: [0, 1, 2, 3, 4].map((leg) => ({
+        departureStation: longName(leg),
+        arrivalStation: longName(leg + 1),
+        departureTime: 1699362720 + leg * 3600,
+        arrivalTime: 1699364520 + leg * 3600,
+        platform: '12A/B-XY',
+        trainType: 'EuroCity 12345678',
+        delayMinutes: 3
+      }))
+    };
+    const plain = messageCodec.encodeConnectionBatch({ firstIndex: 0, total: 2, version: 1, connections: [maximal] });
+    expect(plain.length).toBeGreaterThan(504);
+
+    const messages = messageHandler.buildConnectionBatches([maximal, maximal], 1);
+    expect(messages).toHaveLength(2);
+    messages.forEach((message) => {
+      expect(message.CONNECTION_DATA.length).toBeLessThanOrEqual(504);
+      const batch = messageCodec.decodeConnectionBatch(message.CONNECTION_DATA);
+      expect(batch.connections).toHaveLength(1);
+      const sections = batch.connections[0].sections;
+      expect(sections).toHaveLength(5);
+      expect(sections[2].departureStation.indexOf('Station 2')).toBe(0);
+      expect(sections[4].trainType).toBe(maximal.sections[4].trainType.slice(0, 15));
+    });
+  });
+
   test('handleAppMessage sends error on GPS failure', (done) => {
     locationService.requestNearbyStations.mockImplementation((callback) => {
       callback(new Error('GPS unavailable'), null);
@@ -0,0 +1,62 @@
+#include <string.h>
+#include "persist_mock.h"
+
+// Like the watch, writes larger than PERSIST_DATA_MAX_LENGTH are truncated
+uint8_t persist_storage[PERSIST_MAX_KEYS][PERSIST_DATA_MAX_LENGTH];
+static size_t persist_sizes[PERSIST_MAX_KEYS];
+static bool persist_exists_flags[PERSIST_MAX_KEYS];
+int persist_bytes_written = 0;
+int persist_write_count = 0;
+int persist_read_count = 0;
+
+bool persist_exists(uint32_t key) {
+    return persist_exists_flags[key];
+}
+
+int persist_write_data(uint32_t key, const void *data, size_t size) {
+    if (size > PERSIST_DATA_MAX_LENGTH) {
+        size = PERSIST_DATA_MAX_LENGTH;
+    }
+    memcpy(persist_storage[key], data, size);
+    persist_sizes[key] = size;
+    persist_exists_flags[key] = true;
+    persist_bytes_written += size;
+    persist_write_count++;
+    return size;
+}
+
+int persist_read_data(uint32_t key, void *buffer, size_t size) {
+    persist_read_count++;
+    if (!persist_exists_flags[key]) {
+        return -1;
+    }
+    if (size > persist_sizes[key]) {
+        size = persist_sizes[key];
+    }
+    memcpy(buffer, persist_storage[key], size);
+    return size;
+}
+
+int persist_write_int(uint32_t key, int value) {
+    return persist_write_data(key, &value, sizeof(int));
+}
+
+int persist_read_int(uint32_t key) {
+    int value = 0;
+    persist_read_data(key, &value, sizeof(int));
+    return value;
+}
+
+int persist_delete(uint32_t key) {
+    persist_exists_flags[key] = false;
+    persist_sizes[key] = 0;
+    return 0;
+}
+
+void clear_storage(void) {
+    memset(persist_exists_flags, 0, sizeof(persist_exists_flags));
+    memset(persist_sizes, 0, sizeof(persist_sizes));
+    persist_bytes_written = 0;
+    persist_write_count = 0;
+    persist_read_count = 0;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// In-memory persist_* implementation shared by the host tests
+#define PERSIST_MAX_KEYS 128
+
+extern uint8_t persist_storage[PERSIST_MAX_KEYS][PERSIST_DATA_MAX_LENGTH];
+extern int persist_bytes_written;
+extern int persist_write_count;
+extern int persist_read_count;
+
+void clear_storage(void);
@@ -6,6 +6,7 @@ global.fetch = jest.fn();
 describe('SBB API Client', () => {
   beforeEach(() => {
     fetch.mockClear();
+    sbbApi._clearCache();
   });
 
   test('fetchNearbyStations returns stations sorted by distance', (done) => {
@@ -166,6 +167,21 @@ describe('SBB API Client', () => {
     });
   });
 
+  test('fetchConnections reports fetch and parse timings', (done) => {
+    fetch.mockResolvedValueOnce({
+      ok: true,
+      json: async () => ({ connections: [] })
+    });
+
+    sbbApi.fetchConnections('8503000', '8507000', (err, result, timing) => {
+      expect(err).toBeNull();
+      expect(result).toEqual([]);
+      expect(timing.fetchMs).toBeGreaterThanOrEqual(0);
+      expect(timing.parseMs).toBeGreaterThanOrEqual(0);
+      done();
+    });
+  });
+
   test('fetchConnections handles HTTP 500 error', (done) => {
     fetch.mockRejectedValueOnce(new Error('HTTP error! status: 500'));
 
@@ -175,4 +191,134 @@ describe('SBB API Client', () => {
       done();
     });
   });
+
+  test('fetchConnections requests only the mapped fields', (done) => {
+    fetch.mockResolvedValueOnce({
+      ok: true,
+      json: async () => ({ connections: [] })
+    });
+
+    sbbApi.fetchConnections('8503000', '8507000', () => {
+      const url = fetch.mock.calls[0][0];
+      expect(url).toContain('fields[]=connections/sections/departure/platform');
+      expect(url).toContain('fields[]=connections/sections/journey/number');
+      expect(url).not.toContain('passList');
+      done();
+    });
+  });
+
+  test('fetchConnections converts timestamps to unix seconds', (done) => {
+    fetch.mockResolvedValueOnce({
+      ok: true,
+      json: async () => ({
+        connections: [{
+          from: { departure: '2025-11-07T14:32:00+0100', delay: 2 },
+          to: { arrival: '2025-11-07T15:47:00+0100' },
+          sections: [{
+            departure: { station: { name: 'Zürich HB' }, departure: '2025-11-07T14:32:00+0100' },
+            arrival: { station: { name: 'Bern' }, arrival: '2025-11-07T15:47:00+0100' },
+            journey: null
+          }]
+        }]
+      })
+    });
+
+    sbbApi.fetchConnections('8503000', '8507000', (err, result) => {
+      expect(err).toBeNull();
+      expect(result[0].departureTime).toBe(Date.UTC(2025, 10, 7, 13, 32) / 1000);
+      expect(result[0].arrivalTime).toBe(Date.UTC(2025, 10, 7, 14, 47) / 1000);
+      expect(result[0].totalDelayMinutes).toBe(2);
+      expect(result[0].sections[0].departureTime).toBe(result[0].departureTime);
+      expect(result[0].sections[0].trainType).toBe('Walk');
+      expect(result[0].sections[0].platform).toBe('N/A');
+      done();
+    });
+  });
+
+  test('parseTimestamp matches Date for API timestamps', () => {
+    [
+      '2025-11-07T14:32:00+0100',
+      '2025-07-01T00:05:30+0200',
+      '2025-12-31T23:59:59-0330',
+      '2024-02-29T12:00:00+0000'
+    ].forEach((text) => {
+      expect(sbbApi.parseTimestamp(text)).toBe(Math.floor(new Date(text).getTime() / 1000));
+    });
+    expect(sbbApi.parseTimestamp('2025-11-07T14:32:00Z')).toBe(Date.UTC(2025, 10, 7, 14, 32) / 1000);
+  });
+
+  describe('connection cache', () => {
+    const response = (departure) => ({
+      ok: true,
+      json: async () => ({
+        connections: [{
+          from: { departure: departure, delay: 0 },
+          to: { arrival: '2025-11-07T16:02:00+0100' },
+          sections: []
+        }]
+      })
+    });
+
+    beforeEach(() => {
+      jest.useFakeTimers();
+      jest.setSystemTime(new Date('2025-11-07T14:00:10Z'));
+    });
+
+    afterEach(() => {
+      jest.useRealTimers();
+    });
+
+    const fetchAsync = (from, to) => new Promise((resolve) => {
+      sbbApi.fetchConnections(from, to, (err, result, timing) => resolve({ err, result, timing }));
+    });
+
+    test('concurrent requests for a route share one fetch', async () => {
+      fetch.mockResolvedValueOnce(response('2025-11-07T14:32:00+0100'));
+
+      const [a, b] = await Promise.all([
+        fetchAsync('8503000', '8507000'),
+        fetchAsync('8503000', '8507000')
+      ]);
+
+      expect(fetch).toHaveBeenCalledTimes(1);
+      expect(a.result).toHaveLength(1);
+      expect(b.result).toBe(a.result);
+    });
+
+    test('serves a repeat request from the cache without network access', async () => {
+      fetch.mockResolvedValueOnce(response('2025-11-07T14:32:00+0100'));
+      const first = await fetchAsync('8503000', '8507000');
+
+      jest.advanceTimersByTime(10 * 1000);
+      const second = await fetchAsync('8503000', '8507000');
+
+      expect(fetch).toHaveBeenCalledTimes(1);
+      expect(second.result).toBe(first.result);
+      expect(second.timing).toEqual({ fetchMs: 0, parseMs: 0 });
+    });
+
+    test('fetches again once the entry is stale or for another route', async () => {
+      fetch.mockResolvedValue(response('2025-11-07T14:32:00+0100'));
+      await fetchAsync('8503000', '8507000');
+
+      await fetchAsync('8503000', '8508500');
+      expect(fetch).toHaveBeenCalledTimes(2);
+
+      jest.advanceTimersByTime(sbbApi.CONNECTION_CACHE_TTL_MS);
+      await fetchAsync('8503000', '8507000');
+      expect(fetch).toHaveBeenCalledTimes(3);
+      fetch.mockReset();
+    });
+
+    test('does not cache failures', async () => {
+      fetch.mockRejectedValueOnce(new Error('Network error'));
+      const failed = await fetchAsync('8503000', '8507000');
+      expect(failed.err).toBeTruthy();
+
+      fetch.mockResolvedValueOnce(response('2025-11-07T14:32:00+0100'));
+      const retried = await fetchAsync('8503000', '8507000');
+      expect(retried.err).toBeNull();
+      expect(fetch).toHaveBeenCalledTimes(2);
+    });
+  });
 });
@@ -0,0 +1,86 @@
+const stationIndex = require('../src/pkjs/station_index');
+const fixture = require('./stations_fixture.json');
+const bundled = require('../src/pkjs/stations.json');
+
+// Stations scattered over Switzerland's bounding box, reproducibly
+function randomStations(count, seed) {
+  let state = seed;
+  const random = () => {
+    state = (state * 1103515245 + 12345) % 2147483648;
+    return state / 2147483648;
+  };
+  return Array.from({ length: count }, (_, i) =>
+    [8500000 + i, `Station ${i}`, 45.8 + random() * 2.0, 5.9 + random() * 4.6]);
+}
+
+function bruteForce(rows, lat, lon, k, maxMeters) {
+  return rows
+    .map((row) => ({ id: String(row[0]), distance: stationIndex.haversineMeters(lat, lon, row[2], row[3]) }))
+    .filter((entry) => entry.distance <= (maxMeters || Infinity))
+    .sort((a, b) => a.distance - b.distance)
+    .slice(0, k)
+    .map((entry) => entry.id);
+}
+
+describe('Station index', () => {
+  test('haversine distance matches known values', () => {
+    // Zürich HB to Bern, about 95.5 km as the crow flies
+    expect(stationIndex.haversineMeters(47.3779, 8.5403, 46.9490, 7.4391)).toBeCloseTo(95500, -3);
+    expect(stationIndex.haversineMeters(47, 8, 47, 8)).toBe(0);
+  });
+
+  test('finds the nearest stations across cell borders', () => {
+    const index = stationIndex.buildIndex(fixture);
+    const result = stationIndex.nearest(index, 47.0, 8.0, 3);
+
+    expect(result.map((station) => station.id)).toEqual(['2', '3', '1']);
+    expect(result[0]).toEqual({ id: '2', name: 'Corner SW', distance: 64 });
+  });
+
+  test('stops at maxMeters', () => {
+    const index = stationIndex.buildIndex(fixture);
+
+    expect(stationIndex.nearest(index, 47.0, 8.0, 10, 2000)).toHaveLength(4);
+    expect(stationIndex.nearest(index, 47.0, 8.0, 10, 20000)).toHaveLength(5);
+    expect(stationIndex.nearest(index, 47.5, 9.5, 10, 2000)).toEqual([]);
+  });
+
+  test('returns every station when k exceeds the list', () => {
+    const index = stationIndex.buildIndex(fixture);
+
+    expect(stationIndex.nearest(index, 40.0, 2.0, 10)).toHaveLength(fixture.length);
+    expect(stationIndex.nearest(stationIndex.buildIndex([]), 47.0, 8.0, 10)).toEqual([]);
+  });
+
+  test('agrees with a brute force search', () => {
+    const rows = randomStations(2000, 7);
+    const index = stationIndex.buildIndex(rows);
+    const queries = randomStations(50, 99);
+
+    queries.forEach((query) => {
+      const ids = stationIndex.nearest(index, query[2], query[3], 10).map((station) => station.id);
+      expect(ids).toEqual(bruteForce(rows, query[2], query[3], 10));
+    });
+    queries.forEach((query) => {
+      const ids = stationIndex.nearest(index, query[2], query[3], 10, 3000).map((station) => station.id);
+      expect(ids).toEqual(bruteForce(rows, query[2], query[3], 10, 3000));
+    });
+  });
+
+  test('bundled stations are well formed', () => {
+    const ids = {};
+    bundled.forEach((row) => {
+      expect(row).toHaveLength(4);
+      expect(typeof row[1]).toBe('string');
+      expect(row[2]).toBeGreaterThan(45.8);
+      expect(row[2]).toBeLessThan(47.9);
+      expect(row[3]).toBeGreaterThan(5.9);
+      expect(row[3]).toBeLessThan(10.5);
+      expect(ids[row[0]]).toBeUndefined();
+      ids[row[0]] = true;
+    });
+
+    const index = stationIndex.buildIndex(bundled);
+    expect(stationIndex.nearest(index, 47.3769, 8.5417, 1)[0].id).toBe('8503000');
+  });
+});
@@ -0,0 +1,63 @@
+// Benchmarks the offline station index: build time, memory and nearest
+// queries for the bundled list and for a synthetic list the size of the full
+// Swiss network. Each result is the fastest of BENCH_RUNS runs.
+//
+//   npm run bench:stations   (node --expose-gc for the memory column)
+
+const stationIndex = require('../src/pkjs/station_index');
+const bundled = require('../src/pkjs/stations.json');
+
+const BENCH_RUNS = 5;
+const QUERIES = 10000;
+const SWISS_STOPS = 27000;
+
+function randomRows(count, seed) {
+  let state = seed;
+  const random = () => {
+    state = (state * 1103515245 + 12345) % 2147483648;
+    return state / 2147483648;
+  };
+  return Array.from({ length: count }, (_, i) =>
+    [8500000 + i, `Station ${i}`, 45.8 + random() * 2.0, 5.9 + random() * 4.6]);
+}
+
+function best(fn) {
+  let fastest = Infinity;
+  for (let run = 0; run < BENCH_RUNS; run++) {
+    const start = process.hrtime.bigint();
+    fn();
+    fastest = Math.min(fastest, Number(process.hrtime.bigint() - start));
+  }
+  return fastest;
+}
+
+function heapUsed() {
+  if (global.gc) {
+    global.gc();
+  }
+  return process.memoryUsage().heapUsed;
+}
+
+function bench(name, rows) {
+  const queries = randomRows(QUERIES, 99);
+  const before = heapUsed();
+  const index = stationIndex.buildIndex(rows);
+  const bytes = Math.max(0, heapUsed() - before);
+  const buildNs = best(() => stationIndex.buildIndex(rows));
+  const nearestNs = best(() => {
+    queries.forEach((query) => stationIndex.nearest(index, query[2], query[3], 10));
+  });
+  const radiusNs = best(() => {
+    queries.forEach((query) => stationIndex.nearest(index, query[2], query[3], 10, 2000));
+  });
+
+  console.log(`${name.padEnd(22)} ${String(rows.length).padStart(6)} stations  ` +
+    `build ${(buildNs / 1e6).toFixed(2).padStart(7)} ms  ` +
+    `heap ${global.gc ? (bytes / 1024).toFixed(0).padStart(6) + ' KiB' : '     n/a'}  ` +
+    `k=10 ${(nearestNs / QUERIES / 1000).toFixed(2).padStart(6)} us/query  ` +
+    `k=10 r=2km ${(radiusNs / QUERIES / 1000).toFixed(2).padStart(6)} us/query`);
+  return index;
+}
+
+bench('bundled', bundled);
+bench('synthetic full network', randomRows(SWISS_STOPS, 7));
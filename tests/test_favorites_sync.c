@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "../src/favorites_sync.h"
+#include "../src/storage.h"
+#include "persist_mock.h"
+
+static FavoriteDestination s_list[3];
+
+static void store_list(void) {
+    clear_storage();
+    storage_reset();
+    favorites_sync_reset();
+
+    s_list[0] = create_favorite_destination("8507000", "Bern", "Work");
+    s_list[1] = create_favorite_destination("8508500", "Interlaken Ost", "Hiking");
+    s_list[2] = create_favorite_destination("8503000", "Zürich HB", "Home");
+    FavoritesSync sync = { 7, 1111 };
+    storage_set_favorite_destinations(s_list, 3, &sync);
+    storage_flush();
+    persist_write_count = 0;
+}
+
+static FavoritesDelta make_delta(uint8_t count, uint8_t changes, uint16_t version, int32_t hash) {
+    FavoritesDelta delta;
+    memset(&delta, 0, sizeof(delta));
+    delta.count = count;
+    delta.changes = changes;
+    delta.sync.version = version;
+    delta.sync.hash = hash;
+    delta.has_base = true;
+    delta.base_hash = 1111;
+    return delta;
+}
+
+void test_is_current_compares_stamps(void) {
+    store_list();
+
+    FavoritesSync phone = { 7, 1111 };
+    assert(favorites_sync_is_current(&phone));
+    phone.version = 8;
+    assert(!favorites_sync_is_current(&phone));
+    phone.version = 7;
+    phone.hash = 2222;
+    assert(!favorites_sync_is_current(&phone));
+
+    // An unsynced list never matches
+    storage_set_favorite_destinations(s_list, 3, NULL);
+    FavoritesSync unsynced = { 0, 0 };
+    assert(!favorites_sync_is_current(&unsynced));
+
+    printf("test_is_current_compares_stamps: PASS\n");
+}
+
+void test_delta_replaces_only_changed_entries(void) {
+    store_list();
+
+    FavoritesDelta delta = make_delta(3, 1, 8, 2222);
+    assert(favorites_sync_begin(&delta) == FAVORITES_SYNC_WAITING);
+    FavoriteDestination gym = create_favorite_destination("8503003", "Zürich Stadelhofen", "Gym");
+    assert(favorites_sync_receive(1, &gym) == FAVORITES_SYNC_COMMITTED);
+
+    FavoriteDestination loaded[MAX_FAVORITE_DESTINATIONS];
+    assert(storage_get_favorite_destinations(loaded) == 3);
+    assert(strcmp(loaded[0].label, "Work") == 0);
+    assert(strcmp(loaded[1].label, "Gym") == 0);
+    assert(strcmp(loaded[2].label, "Home") == 0);
+    assert(storage_get_favorites_sync().version == 8);
+    assert(storage_get_favorites_sync().hash == 2222);
+    assert(!storage_is_dirty());
+
+    // Entries after the commit are ignored
+    assert(favorites_sync_receive(0, &gym) == FAVORITES_SYNC_REJECTED);
+
+    printf("test_delta_replaces_only_changed_entries: PASS\n");
+}
+
+void test_delta_without_changes_truncates(void) {
+    store_list();
+
+    // Last favorite removed: nothing but the header is sent
+    FavoritesDelta delta = make_delta(2, 0, 8, 3333);
+    assert(favorites_sync_begin(&delta) == FAVORITES_SYNC_COMMITTED);
+
+    FavoriteDestination loaded[MAX_FAVORITE_DESTINATIONS];
+    assert(storage_get_favorite_destinations(loaded) == 2);
+    assert(strcmp(loaded[1].label, "Hiking") == 0);
+    assert(persist_write_count > 0);
+
+    printf("test_delta_without_changes_truncates: PASS\n");
+}
+
+void test_delta_against_another_list_is_rejected(void) {
+    store_list();
+
+    FavoritesDelta delta = make_delta(3, 1, 8, 2222);
+    delta.base_hash = 9999;
+    assert(favorites_sync_begin(&delta) == FAVORITES_SYNC_REJECTED);
+    FavoriteDestination gym = create_favorite_destination("8503003", "Zürich Stadelhofen", "Gym");
+    assert(favorites_sync_receive(1, &gym) == FAVORITES_SYNC_REJECTED);
+
+    FavoriteDestination loaded[MAX_FAVORITE_DESTINATIONS];
+    assert(storage_get_favorite_destinations(loaded) == 3);
+    assert(strcmp(loaded[1].label, "Hiking") == 0);
+    assert(storage_get_favorites_sync().hash == 1111);
+    assert(persist_write_count == 0);
+
+    printf("test_delta_against_another_list_is_rejected: PASS\n");
+}
+
+void test_full_list_without_indices(void) {
+    store_list();
+
+    // What phones without delta sync send: a count, then every entry in order
+    FavoritesDelta delta = make_delta(2, 2, 0, 0);
+    delta.has_base = false;
+    assert(favorites_sync_begin(&delta) == FAVORITES_SYNC_WAITING);
+    assert(favorites_sync_receive(-1, &s_list[2]) == FAVORITES_SYNC_WAITING);
+    assert(favorites_sync_receive(-1, &s_list[0]) == FAVORITES_SYNC_COMMITTED);
+
+    FavoriteDestination loaded[MAX_FAVORITE_DESTINATIONS];
+    assert(storage_get_favorite_destinations(loaded) == 2);
+    assert(strcmp(loaded[0].label, "Home") == 0);
+    assert(strcmp(loaded[1].label, "Work") == 0);
+    assert(storage_get_favorites_sync().hash == 0);
+
+    printf("test_full_list_without_indices: PASS\n");
+}
+
+void test_delta_grows_list(void) {
+    store_list();
+
+    FavoritesDelta delta = make_delta(4, 1, 8, 4444);
+    assert(favorites_sync_begin(&delta) == FAVORITES_SYNC_WAITING);
+    FavoriteDestination gym = create_favorite_destination("8503003", "Zürich Stadelhofen", "Gym");
+    assert(favorites_sync_receive(7, &gym) == FAVORITES_SYNC_REJECTED);
+    assert(favorites_sync_receive(3, &gym) == FAVORITES_SYNC_COMMITTED);
+
+    // Survives a restart
+    storage_reset();
+    FavoriteDestination loaded[MAX_FAVORITE_DESTINATIONS];
+    assert(storage_get_favorite_destinations(loaded) == 4);
+    assert(strcmp(loaded[2].label, "Home") == 0);
+    assert(strcmp(loaded[3].label, "Gym") == 0);
+    assert(storage_get_favorites_sync().version == 8);
+
+    printf("test_delta_grows_list: PASS\n");
+}
+
+int main(void) {
+    printf("Running favorites sync tests...\n\n");
+
+    test_is_current_compares_stamps();
+    test_delta_replaces_only_changed_entries();
+    test_delta_without_changes_truncates();
+    test_delta_against_another_list_is_rejected();
+    test_full_list_without_indices();
+    test_delta_grows_list();
+
+    printf("\nAll favorites sync tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "../src/last_result.h"
+#include "../src/storage.h"
+#include "../src/persistence.h"
+#include "persist_mock.h"
+
+#define NOW 1699362000
+
+static Connection make_connection(int minutes, int delay) {
+    Connection conn;
+    memset(&conn, 0, sizeof(conn));
+    conn.num_sections = 2;
+    conn.departure_time = NOW + minutes * 60;
+    conn.arrival_time = NOW + (minutes + 56) * 60;
+    conn.total_delay_minutes = delay;
+    conn.num_changes = 1;
+    conn.sections[0].departure_station = string_pool_intern("Zürich HB");
+    conn.sections[0].arrival_station = string_pool_intern("Olten");
+    conn.sections[0].delay_minutes = delay;
+    strcpy(conn.sections[0].platform, "31");
+    strcpy(conn.sections[0].train_type, "IC 8");
+    strcpy(conn.sections[1].train_type, "IR 15");
+    return conn;
+}
+
+static LastResult make_result(const char *from, const char *to, time_t received_at) {
+    Connection conns[3] = { make_connection(-10, 0), make_connection(-3, 5), make_connection(20, 0) };
+    SavedConnection route = create_saved_connection(from, "From", to, "To");
+    LastResult result;
+    last_result_build(&result, &route, conns, 3, received_at);
+    return result;
+}
+
+void test_restore_drops_departed_rows(void) {
+    string_pool_reset();
+    LastResult result = make_result("8503000", "8507000", NOW - 600);
+    assert(result.count == 3);
+
+    Connection restored[MAX_CONNECTION_RESULTS];
+    // The first left 10 minutes ago; the second is 3 minutes late and still here
+    assert(last_result_restore(&result, NOW, restored) == 2);
+    assert(restored[0].departure_time == NOW - 3 * 60);
+    assert(restored[0].total_delay_minutes == 5);
+    assert(restored[0].num_changes == 1);
+    assert(restored[0].num_sections == 1);
+    assert(restored[0].sections[0].delay_minutes == 5);
+    assert(strcmp(restored[0].sections[0].platform, "31") == 0);
+    assert(strcmp(restored[0].sections[0].train_type, "IC 8") == 0);
+    assert(restored[0].sections[0].departure_station == STRING_REF_NONE);
+    assert(restored[1].departure_time == NOW + 20 * 60);
+
+    // Everything gone an hour later
+    assert(last_result_restore(&result, NOW + 3600, restored) == 0);
+
+    printf("test_restore_drops_departed_rows: PASS\n");
+}
+
+void test_results_round_trip(void) {
+    clear_storage();
+    string_pool_reset();
+
+    LastResult results[2];
+    results[0] = make_result("8503000", "8507000", NOW);
+    results[1] = make_result("8507000", "8508500", NOW - 60);
+    save_last_results(results, 2);
+
+    LastResult loaded[LAST_RESULT_ROUTES];
+    assert(load_last_results(loaded) == 2);
+    assert(memcmp(&loaded[0], &results[0], sizeof(LastResult)) == 0);
+    assert(memcmp(&loaded[1], &results[1], sizeof(LastResult)) == 0);
+
+    // A damaged record loads as empty instead of as garbage
+    persist_storage[PERSIST_RECORD_LAST_RESULTS + 1][0] ^= 0xFF;
+    assert(load_last_results(loaded) == 0);
+
+    printf("test_results_round_trip: PASS\n");
+}
+
+void test_storage_keeps_recent_routes(void) {
+    clear_storage();
+    storage_reset();
+    string_pool_reset();
+
+    const char *ids[] = { "8500010", "8503000", "8505000", "8507000", "8508500" };
+    for (int i = 0; i < 5; i++) {
+        LastResult result = make_result(ids[i], "8509000", NOW + i);
+        storage_set_last_result(&result);
+    }
+    assert(persist_write_count == 0);
+    assert(storage_is_dirty());
+
+    // Opening a route again refreshes it in place
+    LastResult again = make_result("8505000", "8509000", NOW + 10);
+    storage_set_last_result(&again);
+
+    storage_flush();
+    assert(!storage_is_dirty());
+    storage_reset();
+
+    LastResult found;
+    SavedConnection oldest = create_saved_connection("8500010", "Basel SBB", "8509000", "Chur");
+    assert(!storage_get_last_result(&oldest, &found));
+    SavedConnection route = create_saved_connection("8505000", "Luzern", "8509000", "Chur");
+    assert(storage_get_last_result(&route, &found));
+    assert(found.received_at == NOW + 10);
+
+    LastResult loaded[LAST_RESULT_ROUTES];
+    assert(load_last_results(loaded) == LAST_RESULT_ROUTES);
+    assert(strcmp(loaded[0].departure_station_id, "8505000") == 0);
+    assert(strcmp(loaded[1].departure_station_id, "8508500") == 0);
+    assert(strcmp(loaded[3].departure_station_id, "8503000") == 0);
+
+    printf("test_storage_keeps_recent_routes: PASS\n");
+}
+
+int main(void) {
+    test_restore_drops_departed_rows();
+    test_results_round_trip();
+    test_storage_keeps_recent_routes();
+    printf("\nAll last result tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "../src/latency.h"
+
+void test_empty_stage(void) {
+    latency_reset();
+    assert(latency_count(LATENCY_TOTAL) == 0);
+    assert(latency_percentile(LATENCY_TOTAL, 50) == 0);
+
+    printf("test_empty_stage: PASS\n");
+}
+
+void test_percentiles_use_bucket_bounds(void) {
+    latency_reset();
+    for (int i = 0; i < 9; i++) {
+        latency_record(LATENCY_FETCH, 100);  // < 128
+    }
+    latency_record(LATENCY_FETCH, 3000);     // < 4096
+
+    assert(latency_count(LATENCY_FETCH) == 10);
+    assert(latency_percentile(LATENCY_FETCH, 50) == 128);
+    assert(latency_percentile(LATENCY_FETCH, 90) == 128);
+    assert(latency_percentile(LATENCY_FETCH, 100) == 4096);
+    assert(latency_count(LATENCY_PARSE) == 0);
+
+    printf("test_percentiles_use_bucket_bounds: PASS\n");
+}
+
+void test_slow_samples_land_in_last_bucket(void) {
+    latency_reset();
+    latency_record(LATENCY_TOTAL, 0);
+    latency_record(LATENCY_TOTAL, 4000000000u);
+
+    assert(latency_percentile(LATENCY_TOTAL, 50) == LATENCY_BUCKET_BASE_MS);
+    assert(latency_percentile(LATENCY_TOTAL, 100) ==
+           (uint32_t)LATENCY_BUCKET_BASE_MS << (LATENCY_BUCKETS - 1));
+
+    printf("test_slow_samples_land_in_last_bucket: PASS\n");
+}
+
+void test_old_samples_fade_out(void) {
+    latency_reset();
+    for (int i = 0; i < LATENCY_WINDOW; i++) {
+        latency_record(LATENCY_BLUETOOTH, 2000);
+    }
+    assert(latency_percentile(LATENCY_BLUETOOTH, 50) == 2048);
+
+    // Each full window halves what came before
+    for (int i = 0; i < 2 * LATENCY_WINDOW; i++) {
+        latency_record(LATENCY_BLUETOOTH, 50);
+    }
+    assert(latency_count(LATENCY_BLUETOOTH) <= LATENCY_WINDOW);
+    assert(latency_percentile(LATENCY_BLUETOOTH, 50) == 64);
+    assert(latency_percentile(LATENCY_BLUETOOTH, 90) == 64);
+
+    printf("test_old_samples_fade_out: PASS\n");
+}
+
+int main(void) {
+    test_empty_stage();
+    test_percentiles_use_bucket_bounds();
+    test_slow_samples_land_in_last_bucket();
+    test_old_samples_fade_out();
+    printf("\nAll latency tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "../src/marquee.h"
+
+// Mock menu: one selected cell, redraws counted instead of performed
+static MenuIndex s_selected = { 0, 0 };
+static int s_dirty_marks = 0;
+static int s_menu_handle;
+
+MenuIndex menu_layer_get_selected_index(const MenuLayer *menu_layer) {
+    (void)menu_layer;
+    return s_selected;
+}
+
+Layer *menu_layer_get_layer(const MenuLayer *menu_layer) {
+    (void)menu_layer;
+    return NULL;
+}
+
+void layer_mark_dirty(Layer *layer) {
+    (void)layer;
+    s_dirty_marks++;
+}
+
+// Mock timer: a single pending timer fired by the test
+static AppTimerCallback s_timer_callback = NULL;
+static void *s_timer_data = NULL;
+static uint32_t s_timer_delay = 0;
+static int s_timer_handle;
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+    s_timer_callback = callback;
+    s_timer_data = callback_data;
+    s_timer_delay = timeout_ms;
+    return (AppTimer *)&s_timer_handle;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+    (void)timer_handle;
+    s_timer_callback = NULL;
+}
+
+static void fire_timer(void) {
+    AppTimerCallback callback = s_timer_callback;
+    assert(callback != NULL);
+    s_timer_callback = NULL;
+    callback(s_timer_data);
+}
+
+static Marquee s_marquee;
+
+static void reset(void) {
+    s_selected = (MenuIndex){ 0, 0 };
+    s_dirty_marks = 0;
+    s_timer_callback = NULL;
+    marquee_init(&s_marquee, (MenuLayer *)&s_menu_handle);
+}
+
+void test_scrolls_selected_cell_then_stops(void) {
+    reset();
+    const char *text = "Basel SBB";  // 9 characters, 6 visible
+    MenuIndex cell = { 0, 0 };
+
+    marquee_restart(&s_marquee);
+    assert(s_timer_delay == MARQUEE_WAIT_MS);
+    assert(marquee_text(&s_marquee, &cell, text, 6) == text);
+
+    // Three steps to show the end of the text, "el SBB"
+    for (int step = 1; step <= 3; step++) {
+        fire_timer();
+        assert(s_timer_delay == MARQUEE_STEP_MS);
+        assert(s_dirty_marks == step);
+        assert(marquee_text(&s_marquee, &cell, text, 6) == text + step);
+    }
+    assert(strcmp(text + 3, "el SBB") == 0);
+
+    // One more step goes back to the start
+    fire_timer();
+    assert(s_dirty_marks == 4);
+    assert(marquee_text(&s_marquee, &cell, text, 6) == text);
+
+    // Fully scrolled: no further redraws
+    fire_timer();
+    assert(s_timer_callback == NULL);
+    assert(s_dirty_marks == 4);
+
+    printf("test_scrolls_selected_cell_then_stops: PASS\n");
+}
+
+void test_short_text_never_redraws(void) {
+    reset();
+    MenuIndex cell = { 0, 0 };
+
+    marquee_restart(&s_marquee);
+    marquee_text(&s_marquee, &cell, "Bern", 6);
+    fire_timer();
+
+    assert(s_timer_callback == NULL);
+    assert(s_dirty_marks == 0);
+
+    printf("test_short_text_never_redraws: PASS\n");
+}
+
+void test_only_selected_cell_scrolls(void) {
+    reset();
+    const char *text = "Interlaken Ost";
+    MenuIndex selected = { 1, 2 };
+    MenuIndex other = { 0, 2 };
+    s_selected = selected;
+
+    marquee_restart(&s_marquee);
+    marquee_text(&s_marquee, &selected, text, 6);
+    fire_timer();
+
+    assert(marquee_text(&s_marquee, &other, text, 6) == text);
+    assert(marquee_text(&s_marquee, &selected, text, 6) == text + 1);
+
+    printf("test_only_selected_cell_scrolls: PASS\n");
+}
+
+void test_skips_whole_utf8_characters(void) {
+    reset();
+    const char *text = "Zürich Flughafen";
+    MenuIndex cell = { 0, 0 };
+
+    marquee_restart(&s_marquee);
+    marquee_text(&s_marquee, &cell, text, 6);
+    fire_timer();
+    marquee_text(&s_marquee, &cell, text, 6);
+    fire_timer();
+
+    // "ü" is two bytes; two characters in is "rich Flughafen"
+    assert(strcmp(marquee_text(&s_marquee, &cell, text, 6), "rich Flughafen") == 0);
+
+    printf("test_skips_whole_utf8_characters: PASS\n");
+}
+
+void test_pause_and_restart(void) {
+    reset();
+    const char *text = "Interlaken Ost";
+    MenuIndex cell = { 0, 0 };
+
+    marquee_restart(&s_marquee);
+    marquee_text(&s_marquee, &cell, text, 6);
+    fire_timer();
+    marquee_text(&s_marquee, &cell, text, 6);
+
+    // Covered by another window: the timer stops
+    marquee_pause(&s_marquee);
+    assert(s_timer_callback == NULL);
+
+    // Back on top: starts over from the beginning after the wait
+    int marks = s_dirty_marks;
+    marquee_restart(&s_marquee);
+    assert(s_dirty_marks == marks + 1);
+    assert(s_timer_delay == MARQUEE_WAIT_MS);
+    assert(marquee_text(&s_marquee, &cell, text, 6) == text);
+
+    printf("test_pause_and_restart: PASS\n");
+}
+
+int main(void) {
+    test_scrolls_selected_cell_then_stops();
+    test_short_text_never_redraws();
+    test_only_selected_cell_scrolls();
+    test_skips_whole_utf8_characters();
+    test_pause_and_restart();
+    printf("\nAll marquee tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "../src/message_codec.h"
+
+// Produced by gen_codec_fixture.js with the JS encoder (see Makefile)
+#define FIXTURE_PATH "codec_fixture.bin"
+#define PATCH_FIXTURE_PATH "codec_patch_fixture.bin"
+
+static uint8_t s_fixture[512];
+static size_t s_fixture_length;
+
+static void load_fixture(void) {
+    FILE *file = fopen(FIXTURE_PATH, "rb");
+    assert(file != NULL);
+    s_fixture_length = fread(s_fixture, 1, sizeof(s_fixture), file);
+    fclose(file);
+    assert(s_fixture_length > 0);
+}
+
+// Offset of the first connection after the batch header
+static size_t s_first_offset;
+
+void test_decode_batch_header(void) {
+    ConnectionBatch batch;
+    s_first_offset = message_codec_decode_connection_batch(s_fixture, s_fixture_length, &batch);
+
+    assert(s_first_offset == 5);
+    assert(batch.first_index == 2);
+    assert(batch.total == 4);
+    assert(batch.version == 9);
+    assert(batch.count == 2);
+
+    printf("test_decode_batch_header: PASS\n");
+}
+
+void test_decode_js_encoded_connection(void) {
+    Connection conn;
+    size_t consumed = message_codec_decode_connection(s_fixture + s_first_offset,
+                                                      s_fixture_length - s_first_offset, &conn);
+
+    assert(consumed > 0);
+    assert(conn.departure_time == 1699362720);
+    assert(conn.arrival_time == 1699367220);
+    assert(conn.total_delay_minutes == -1);
+    assert(conn.num_changes == 1);
+    assert(conn.num_sections == 2);
+
+    assert(strcmp(string_pool_get(conn.sections[0].departure_station), "Zürich HB") == 0);
+    assert(strcmp(string_pool_get(conn.sections[0].arrival_station), "Olten") == 0);
+    // Consecutive legs share the interned name
+    assert(conn.sections[1].departure_station == conn.sections[0].arrival_station);
+    assert(conn.sections[0].departure_time == 1699362720);
+    assert(conn.sections[0].arrival_time == 1699365000);
+    assert(strcmp(conn.sections[0].platform, "7") == 0);
+    assert(strcmp(conn.sections[0].train_type, "IC 712") == 0);
+    assert(conn.sections[0].delay_minutes == 3);
+
+    assert(strcmp(conn.sections[1].train_type, "IR 2518") == 0);
+    assert(strcmp(conn.sections[1].platform, "11AB") == 0);
+
+    // Second connection follows directly
+    size_t offset = s_first_offset + consumed;
+    Connection later;
+    consumed = message_codec_decode_connection(s_fixture + offset, s_fixture_length - offset, &later);
+    assert(offset + consumed == s_fixture_length);
+    assert(later.departure_time == 1699364520);
+    assert(later.num_sections == 0);
+
+    printf("test_decode_js_encoded_connection: PASS\n");
+}
+
+void test_long_names_fit_struct(void) {
+    Connection conn;
+    message_codec_decode_connection(s_fixture + s_first_offset, s_fixture_length - s_first_offset, &conn);
+
+    // Encoder truncates to MAX_STATION_NAME_LENGTH - 1 bytes
+    assert(strlen(string_pool_get(conn.sections[1].arrival_station)) == MAX_STATION_NAME_LENGTH - 1);
+    assert(strncmp(string_pool_get(conn.sections[1].arrival_station), "Bern Wankdorf", 13) == 0);
+
+    printf("test_long_names_fit_struct: PASS\n");
+}
+
+void test_reject_truncated_payload(void) {
+    ConnectionBatch batch;
+    Connection conn;
+
+    for (size_t length = 0; length < s_first_offset; length++) {
+        assert(message_codec_decode_connection_batch(s_fixture, length, &batch) == 0);
+    }
+    // Every proper prefix of the first connection is rejected
+    const uint8_t *first = s_fixture + s_first_offset;
+    size_t first_length = message_codec_decode_connection(first, s_fixture_length - s_first_offset, &conn);
+    for (size_t length = 0; length < first_length; length++) {
+        assert(message_codec_decode_connection(first, length, &conn) == 0);
+    }
+
+    printf("test_reject_truncated_payload: PASS\n");
+}
+
+void test_reject_wrong_version(void) {
+    uint8_t payload[512];
+    memcpy(payload, s_fixture, s_fixture_length);
+    payload[0] = MESSAGE_CODEC_VERSION + 1;
+
+    ConnectionBatch batch;
+    assert(message_codec_decode_connection_batch(payload, s_fixture_length, &batch) == 0);
+
+    printf("test_reject_wrong_version: PASS\n");
+}
+
+void test_reject_too_many_sections(void) {
+    // times, delay, changes, then a section count of 6
+    uint8_t payload[] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6 };
+
+    Connection conn;
+    assert(message_codec_decode_connection(payload, sizeof(payload), &conn) == 0);
+
+    printf("test_reject_too_many_sections: PASS\n");
+}
+
+void test_reject_oversized_batch(void) {
+    uint8_t payload[] = { MESSAGE_CODEC_VERSION, 0, 6, 1, MAX_CONNECTION_RESULTS + 1 };
+
+    ConnectionBatch batch;
+    assert(message_codec_decode_connection_batch(payload, sizeof(payload), &batch) == 0);
+
+    printf("test_reject_oversized_batch: PASS\n");
+}
+
+void test_decode_station_list(void) {
+    // One station: "8503000", "Bern", 1200 m
+    uint8_t payload[] = { MESSAGE_CODEC_VERSION, 1,
+                          7, '8', '5', '0', '3', '0', '0', '0',
+                          4, 'B', 'e', 'r', 'n',
+                          0xB0, 0x04 };
+
+    StationList list;
+    size_t offset = message_codec_decode_station_list(payload, sizeof(payload), &list);
+    assert(offset == 2);
+    assert(list.count == 1);
+
+    Station station;
+    assert(message_codec_decode_station(payload + offset, sizeof(payload) - offset, &station)
+           == sizeof(payload) - offset);
+    assert(strcmp(station.id, "8503000") == 0);
+    assert(strcmp(station.name, "Bern") == 0);
+    assert(station.distance_meters == 1200);
+
+    printf("test_decode_station_list: PASS\n");
+}
+
+void test_decode_js_encoded_patch(void) {
+    uint8_t patch_data[512];
+    FILE *file = fopen(PATCH_FIXTURE_PATH, "rb");
+    assert(file != NULL);
+    size_t length = fread(patch_data, 1, sizeof(patch_data), file);
+    fclose(file);
+
+    ConnectionPatch patch;
+    size_t offset = message_codec_decode_connection_patch(patch_data, length, &patch);
+    assert(offset == 5);
+    assert(patch.base_version == 9);
+    assert(patch.version == 10);
+    assert(patch.total == 2);
+    assert(patch.count == 2);
+
+    // The delayed departure moved up, its sections unchanged
+    ConnectionUpdate update;
+    size_t consumed = message_codec_decode_connection_update(patch_data + offset, length - offset, &update);
+    assert(consumed > 0);
+    assert(update.index == 0);
+    assert(update.from == 1);
+    assert(update.total_delay_minutes == 4);
+    assert(update.num_sections == 0);
+    offset += consumed;
+
+    // The new departure is followed by its full record
+    consumed = message_codec_decode_connection_update(patch_data + offset, length - offset, &update);
+    assert(update.index == 1);
+    assert(update.from == CONNECTION_UPDATE_ADDED);
+    offset += consumed;
+
+    Connection conn;
+    consumed = message_codec_decode_connection(patch_data + offset, length - offset, &conn);
+    assert(consumed > 0);
+    assert(conn.departure_time == 1699366320);
+    assert(offset + consumed == length);
+
+    printf("test_decode_js_encoded_patch: PASS\n");
+}
+
+int main(void) {
+    load_fixture();
+    test_decode_batch_header();
+    test_decode_js_encoded_connection();
+    test_long_names_fit_struct();
+    test_reject_truncated_payload();
+    test_reject_wrong_version();
+    test_reject_too_many_sections();
+    test_reject_oversized_batch();
+    test_decode_station_list();
+    test_decode_js_encoded_patch();
+    printf("\nAll message_codec tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "../src/outbox_queue.h"
+
+// Mock AppMessage outbox: results are scripted per call
+static AppMessageResult s_begin_result = APP_MSG_OK;
+static AppMessageResult s_send_result = APP_MSG_OK;
+static int s_sends = 0;
+static int s_last_written = -1;
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+    *iterator = NULL;
+    return s_begin_result;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+    if (s_send_result == APP_MSG_OK) {
+        s_sends++;
+    }
+    return s_send_result;
+}
+
+// Mock timer: a single pending timer fired by the test
+static AppTimerCallback s_timer_callback = NULL;
+static uint32_t s_timer_delay = 0;
+static int s_timer_handle;
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+    s_timer_callback = callback;
+    s_timer_delay = timeout_ms;
+    (void)callback_data;
+    return (AppTimer *)&s_timer_handle;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+    (void)timer_handle;
+    s_timer_callback = NULL;
+}
+
+static void fire_timer(void) {
+    AppTimerCallback callback = s_timer_callback;
+    assert(callback != NULL);
+    s_timer_callback = NULL;
+    callback(NULL);
+}
+
+static void write_value(DictionaryIterator *iter, const void *payload) {
+    (void)iter;
+    s_last_written = *(const int *)payload;
+}
+
+static int s_failed_value = -1;
+
+static void record_failure(const void *payload) {
+    s_failed_value = *(const int *)payload;
+}
+
+static void reset(void) {
+    outbox_queue_reset();
+    s_begin_result = APP_MSG_OK;
+    s_send_result = APP_MSG_OK;
+    s_sends = 0;
+    s_last_written = -1;
+    s_failed_value = -1;
+    s_timer_callback = NULL;
+}
+
+void test_sends_one_message_at_a_time(void) {
+    reset();
+    int first = 1, second = 2;
+    outbox_queue_send(OUTBOX_KEY_NONE, write_value, NULL, &first, sizeof(first));
+    outbox_queue_send(OUTBOX_KEY_NONE, write_value, NULL, &second, sizeof(second));
+
+    assert(s_sends == 1);
+    assert(s_last_written == 1);
+    assert(outbox_queue_pending() == 2);
+
+    outbox_queue_handle_sent();
+    assert(s_sends == 2);
+    assert(s_last_written == 2);
+
+    outbox_queue_handle_sent();
+    assert(outbox_queue_pending() == 0);
+
+    printf("test_sends_one_message_at_a_time: PASS\n");
+}
+
+void test_retries_busy_outbox_with_backoff(void) {
+    reset();
+    int value = 7;
+    s_begin_result = APP_MSG_BUSY;
+    outbox_queue_send(OUTBOX_KEY_NONE, write_value, NULL, &value, sizeof(value));
+
+    assert(s_sends == 0);
+    assert(s_timer_delay == OUTBOX_RETRY_BASE_MS);
+
+    fire_timer();
+    assert(s_timer_delay == OUTBOX_RETRY_BASE_MS * 2);
+
+    s_begin_result = APP_MSG_OK;
+    fire_timer();
+    assert(s_sends == 1);
+    assert(s_last_written == 7);
+
+    printf("test_retries_busy_outbox_with_backoff: PASS\n");
+}
+
+void test_resends_after_outbox_failure(void) {
+    reset();
+    int value = 3;
+    outbox_queue_send(OUTBOX_KEY_NONE, write_value, NULL, &value, sizeof(value));
+    assert(s_sends == 1);
+
+    outbox_queue_handle_failed(APP_MSG_SEND_TIMEOUT);
+    assert(s_sends == 1);
+    fire_timer();
+    assert(s_sends == 2);
+    assert(outbox_queue_pending() == 1);
+
+    printf("test_resends_after_outbox_failure: PASS\n");
+}
+
+void test_drops_after_max_retries(void) {
+    reset();
+    int value = 9, next = 10;
+    s_send_result = APP_MSG_NOT_CONNECTED;
+    outbox_queue_send(OUTBOX_KEY_NONE, write_value, record_failure, &value, sizeof(value));
+    outbox_queue_send(OUTBOX_KEY_NONE, write_value, NULL, &next, sizeof(next));
+
+    for (int i = 0; i < OUTBOX_MAX_RETRIES; i++) {
+        fire_timer();
+    }
+    assert(s_failed_value == 9);
+    assert(outbox_queue_pending() == 1);
+
+    // The next message starts with a fresh retry budget
+    s_send_result = APP_MSG_OK;
+    fire_timer();
+    assert(s_last_written == 10);
+    assert(s_sends == 1);
+
+    printf("test_drops_after_max_retries: PASS\n");
+}
+
+void test_coalesces_pending_requests(void) {
+    reset();
+    int blocker = 0, refresh = 1, user = 2;
+    outbox_queue_send(OUTBOX_KEY_NONE, write_value, NULL, &blocker, sizeof(blocker));
+    outbox_queue_send(OUTBOX_KEY_REQUEST_CONNECTIONS, write_value, NULL, &refresh, sizeof(refresh));
+    outbox_queue_send(OUTBOX_KEY_REQUEST_CONNECTIONS, write_value, NULL, &user, sizeof(user));
+
+    assert(outbox_queue_pending() == 2);
+    outbox_queue_handle_sent();
+    assert(s_last_written == 2);
+
+    // An identical request while the same one is in flight is dropped
+    outbox_queue_send(OUTBOX_KEY_REQUEST_CONNECTIONS, write_value, NULL, &user, sizeof(user));
+    assert(outbox_queue_pending() == 1);
+
+    // A different payload is queued behind it
+    outbox_queue_send(OUTBOX_KEY_REQUEST_CONNECTIONS, write_value, NULL, &refresh, sizeof(refresh));
+    assert(outbox_queue_pending() == 2);
+
+    printf("test_coalesces_pending_requests: PASS\n");
+}
+
+void test_rejects_oversized_payload(void) {
+    reset();
+    uint8_t payload[OUTBOX_MAX_PAYLOAD + 1];
+    memset(payload, 0, sizeof(payload));
+    assert(!outbox_queue_send(OUTBOX_KEY_NONE, write_value, NULL, payload, sizeof(payload)));
+    assert(outbox_queue_pending() == 0);
+
+    printf("test_rejects_oversized_payload: PASS\n");
+}
+
+int main(void) {
+    test_sends_one_message_at_a_time();
+    test_retries_busy_outbox_with_backoff();
+    test_resends_after_outbox_failure();
+    test_drops_after_max_retries();
+    test_coalesces_pending_requests();
+    test_rejects_oversized_payload();
+    printf("\nAll outbox_queue tests passed!\n");
+    return 0;
+}
@@ -6,15 +6,78 @@
 #include <stdbool.h>
 #include <time.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <string.h>
 
 // Prevent actual pebble.h from being included
 #define PEBBLE_H
 
 // Mock persist function declarations
+#define PERSIST_DATA_MAX_LENGTH 256
 bool persist_exists(uint32_t key);
 int persist_write_data(uint32_t key, const void *data, size_t size);
 int persist_read_data(uint32_t key, void *buffer, size_t size);
 int persist_write_int(uint32_t key, int value);
 int persist_read_int(uint32_t key);
+int persist_delete(uint32_t key);
+
+// Mock logging: format the arguments so they count as used, print nothing
+#define APP_LOG(level, ...) ((void)snprintf(NULL, 0, __VA_ARGS__))
+
+// Mock clock, see clock_mock.c
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+
+// Mock AppMessage and timer declarations
+typedef enum {
+    APP_MSG_OK = 0,
+    APP_MSG_SEND_TIMEOUT = 2,
+    APP_MSG_NOT_CONNECTED = 8,
+    APP_MSG_BUSY = 64,
+} AppMessageResult;
+
+typedef struct DictionaryIterator DictionaryIterator;
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+void app_timer_cancel(AppTimer *timer_handle);
+
+// Mock battery and focus declarations
+typedef struct {
+    uint8_t charge_percent;
+    bool is_charging;
+    bool is_plugged;
+} BatteryChargeState;
+BatteryChargeState battery_state_service_peek(void);
+typedef void (*AppFocusHandler)(bool in_focus);
+void app_focus_service_subscribe(AppFocusHandler handler);
+void app_focus_service_unsubscribe(void);
+
+// Mock background worker declarations
+typedef struct {
+    uint16_t data0;
+    uint16_t data1;
+    uint16_t data2;
+} AppWorkerMessage;
+typedef enum {
+    APP_WORKER_RESULT_SUCCESS = 0,
+} AppWorkerResult;
+bool app_worker_is_running(void);
+AppWorkerResult app_worker_launch(void);
+AppWorkerResult app_worker_kill(void);
+void app_worker_send_message(uint8_t type, AppWorkerMessage *data);
+
+// Mock menu declarations
+typedef struct Layer Layer;
+typedef struct MenuLayer MenuLayer;
+typedef struct {
+    uint16_t section;
+    uint16_t row;
+} MenuIndex;
+MenuIndex menu_layer_get_selected_index(const MenuLayer *menu_layer);
+Layer *menu_layer_get_layer(const MenuLayer *menu_layer);
+void layer_mark_dirty(Layer *layer);
 
 #endif
@@ -2,42 +2,12 @@
 #include <assert.h>
 #include <string.h>
 #include "../src/persistence.h"
-
-// Mock persist functions for testing
-#define PERSIST_DATA_MAX_LENGTH 4096
-static uint8_t persist_storage[10][PERSIST_DATA_MAX_LENGTH];
-static bool persist_exists_flags[10];
-
-bool persist_exists(uint32_t key) {
-    return persist_exists_flags[key];
-}
-
-int persist_write_data(uint32_t key, const void *data, size_t size) {
-    memcpy(persist_storage[key], data, size);
-    persist_exists_flags[key] = true;
-    return size;
-}
-
-int persist_read_data(uint32_t key, void *buffer, size_t size) {
-    memcpy(buffer, persist_storage[key], size);
-    return size;
-}
-
-int persist_write_int(uint32_t key, int value) {
-    memcpy(persist_storage[key], &value, sizeof(int));
-    persist_exists_flags[key] = true;
-    return sizeof(int);
-}
-
-int persist_read_int(uint32_t key) {
-    int value;
-    memcpy(&value, persist_storage[key], sizeof(int));
-    return value;
-}
+#include "../src/pinned_connection.h"
+#include "persist_mock.h"
 
 void test_save_and_load_connections(void) {
     // Clear storage for test isolation
-    memset(persist_exists_flags, 0, sizeof(persist_exists_flags));
+    clear_storage();
 
     SavedConnection conns[2];
     conns[0] = create_saved_connection("8503000", "Zürich HB", "8507000", "Bern");
@@ -57,7 +27,7 @@ void test_save_and_load_connections(void) {
 
 void test_load_when_empty(void) {
     // Clear storage for test isolation
-    memset(persist_exists_flags, 0, sizeof(persist_exists_flags));
+    clear_storage();
 
     SavedConnection loaded[MAX_SAVED_CONNECTIONS];
     int count = load_connections(loaded);
@@ -69,7 +39,7 @@ void test_load_when_empty(void) {
 
 void test_connection_limit_reached(void) {
     // Clear storage for test isolation
-    memset(persist_exists_flags, 0, sizeof(persist_exists_flags));
+    clear_storage();
 
     SavedConnection conns[MAX_SAVED_CONNECTIONS];
     for (int i = 0; i < MAX_SAVED_CONNECTIONS; i++) {
@@ -84,7 +54,7 @@ void test_connection_limit_reached(void) {
 
 void test_save_and_load_favorites(void) {
     // Clear storage for test isolation
-    memset(persist_exists_flags, 0, sizeof(persist_exists_flags));
+    clear_storage();
 
     Station favorites[2];
     favorites[0] = create_station("8503000", "Zürich HB", 0);
@@ -105,7 +75,7 @@ void test_save_and_load_favorites(void) {
 
 void test_load_favorites_when_empty(void) {
     // Clear storage for test isolation
-    memset(persist_exists_flags, 0, sizeof(persist_exists_flags));
+    clear_storage();
 
     Station loaded[MAX_FAVORITE_STATIONS];
     int count = load_favorites(loaded);
@@ -115,12 +85,229 @@ void test_load_favorites_when_empty(void) {
     printf("test_load_favorites_when_empty: PASS\n");
 }
 
+static void fill_connections(SavedConnection *conns, int count) {
+    char dep[MAX_STATION_NAME_LENGTH];
+    char arr[MAX_STATION_NAME_LENGTH];
+    for (int i = 0; i < count; i++) {
+        snprintf(dep, sizeof(dep), "Departure station %d", i % 100);
+        snprintf(arr, sizeof(arr), "Arrival station %d", i % 100);
+        conns[i] = create_saved_connection("8503000", dep, "8507000", arr);
+    }
+}
+
+void test_records_span_multiple_keys(void) {
+    clear_storage();
+
+    SavedConnection conns[MAX_SAVED_CONNECTIONS];
+    fill_connections(conns, MAX_SAVED_CONNECTIONS);
+    save_connections(conns, MAX_SAVED_CONNECTIONS);
+
+    // Larger than one key, so it must have been split
+    assert(persist_exists(PERSIST_RECORD_CONNECTIONS + 2));
+
+    SavedConnection loaded[MAX_SAVED_CONNECTIONS];
+    int count = load_connections(loaded);
+
+    assert(count == MAX_SAVED_CONNECTIONS);
+    for (int i = 0; i < count; i++) {
+        assert(strcmp(loaded[i].departure_station_name, conns[i].departure_station_name) == 0);
+        assert(strcmp(loaded[i].arrival_station_name, conns[i].arrival_station_name) == 0);
+        assert(strcmp(loaded[i].arrival_station_id, "8507000") == 0);
+    }
+
+    printf("test_records_span_multiple_keys: PASS\n");
+}
+
+void test_packed_records_are_smaller_than_structs(void) {
+    clear_storage();
+
+    SavedConnection conns[MAX_SAVED_CONNECTIONS];
+    for (int i = 0; i < MAX_SAVED_CONNECTIONS; i++) {
+        conns[i] = create_saved_connection("8503000", "Zürich HB", "8507000", "Bern");
+    }
+    save_connections(conns, MAX_SAVED_CONNECTIONS);
+
+    assert(persist_bytes_written < (int)(sizeof(SavedConnection) * MAX_SAVED_CONNECTIONS) / 2);
+
+    printf("test_packed_records_are_smaller_than_structs: PASS\n");
+}
+
+void test_corrupt_record_is_ignored(void) {
+    clear_storage();
+
+    SavedConnection conns[2];
+    conns[0] = create_saved_connection("8503000", "Zürich HB", "8507000", "Bern");
+    conns[1] = create_saved_connection("8507000", "Bern", "8508500", "Interlaken");
+    save_connections(conns, 2);
+
+    persist_storage[PERSIST_RECORD_CONNECTIONS + 1][5] ^= 0x20;
+
+    SavedConnection loaded[MAX_SAVED_CONNECTIONS];
+    assert(load_connections(loaded) == 0);
+
+    printf("test_corrupt_record_is_ignored: PASS\n");
+}
+
+void test_shrinking_record_drops_stale_chunks(void) {
+    clear_storage();
+
+    SavedConnection conns[MAX_SAVED_CONNECTIONS];
+    fill_connections(conns, MAX_SAVED_CONNECTIONS);
+    save_connections(conns, MAX_SAVED_CONNECTIONS);
+    assert(persist_exists(PERSIST_RECORD_CONNECTIONS + 2));
+
+    save_connections(conns, 1);
+    assert(persist_exists(PERSIST_RECORD_CONNECTIONS + 1));
+    assert(!persist_exists(PERSIST_RECORD_CONNECTIONS + 2));
+
+    SavedConnection loaded[MAX_SAVED_CONNECTIONS];
+    assert(load_connections(loaded) == 1);
+
+    printf("test_shrinking_record_drops_stale_chunks: PASS\n");
+}
+
+void test_migrates_legacy_connections(void) {
+    clear_storage();
+
+    // Old builds dumped the array under one key; the watch kept 256 bytes
+    SavedConnection conns[3];
+    conns[0] = create_saved_connection("8503000", "Zürich HB", "8507000", "Bern");
+    conns[1] = create_saved_connection("8507000", "Bern", "8508500", "Interlaken");
+    conns[2] = create_saved_connection("8500010", "Basel SBB", "8503000", "Zürich HB");
+    persist_write_int(PERSIST_KEY_NUM_CONNECTIONS, 3);
+    persist_write_data(PERSIST_KEY_CONNECTIONS, conns, sizeof(conns));
+
+    SavedConnection loaded[MAX_SAVED_CONNECTIONS];
+    int count = load_connections(loaded);
+
+    assert(count == 2);
+    assert(strcmp(loaded[1].arrival_station_name, "Interlaken") == 0);
+    assert(!persist_exists(PERSIST_KEY_CONNECTIONS));
+    assert(!persist_exists(PERSIST_KEY_NUM_CONNECTIONS));
+
+    // Second load comes from the migrated record
+    memset(loaded, 0, sizeof(loaded));
+    assert(load_connections(loaded) == 2);
+    assert(strcmp(loaded[0].departure_station_name, "Zürich HB") == 0);
+
+    printf("test_migrates_legacy_connections: PASS\n");
+}
+
+void test_save_and_load_favorite_destinations(void) {
+    clear_storage();
+
+    FavoriteDestination favorites[MAX_FAVORITE_DESTINATIONS];
+    for (int i = 0; i < MAX_FAVORITE_DESTINATIONS; i++) {
+        favorites[i] = create_favorite_destination("8507000", "Bern", "Work");
+    }
+    favorites[9] = create_favorite_destination("8508500", "Interlaken Ost", "Hiking");
+    save_favorite_destinations(favorites, MAX_FAVORITE_DESTINATIONS, NULL);
+
+    FavoriteDestination loaded[MAX_FAVORITE_DESTINATIONS];
+    int count = load_favorite_destinations(loaded, NULL);
+
+    assert(count == MAX_FAVORITE_DESTINATIONS);
+    assert(strcmp(loaded[0].label, "Work") == 0);
+    assert(strcmp(loaded[9].name, "Interlaken Ost") == 0);
+    assert(strcmp(loaded[9].label, "Hiking") == 0);
+
+    printf("test_save_and_load_favorite_destinations: PASS\n");
+}
+
+void test_favorite_destinations_keep_sync_stamp(void) {
+    clear_storage();
+
+    FavoriteDestination favorites[2];
+    favorites[0] = create_favorite_destination("8507000", "Bern", "Work");
+    favorites[1] = create_favorite_destination("8508500", "Interlaken Ost", "Hiking");
+    FavoritesSync sync = { 41000, -123456789 };
+    save_favorite_destinations(favorites, 2, &sync);
+
+    FavoriteDestination loaded[MAX_FAVORITE_DESTINATIONS];
+    FavoritesSync loaded_sync;
+    assert(load_favorite_destinations(loaded, &loaded_sync) == 2);
+    assert(loaded_sync.version == 41000);
+    assert(loaded_sync.hash == -123456789);
+    assert(strcmp(loaded[1].label, "Hiking") == 0);
+
+    // Lists stored before sync stamps load as never synced
+    PersistRecord record;
+    persist_record_begin_write(&record, PERSIST_RECORD_FAVORITE_DESTINATIONS, 1);
+    persist_record_write_u8(&record, 1);
+    persist_record_write_string(&record, "8503000");
+    persist_record_write_string(&record, "Zürich HB");
+    persist_record_write_string(&record, "Home");
+    assert(persist_record_end_write(&record));
+
+    assert(load_favorite_destinations(loaded, &loaded_sync) == 1);
+    assert(loaded_sync.version == 0 && loaded_sync.hash == 0);
+    assert(strcmp(loaded[0].label, "Home") == 0);
+
+    printf("test_favorite_destinations_keep_sync_stamp: PASS\n");
+}
+
+void test_save_and_load_pinned_connection(void) {
+    clear_storage();
+    string_pool_reset();
+
+    PinnedConnection pinned;
+    memset(&pinned, 0, sizeof(pinned));
+    pinned.is_active = true;
+    pinned.pinned_at = 1700000000;
+    pinned.route = create_saved_connection("8503000", "Zürich HB", "8508500", "Interlaken Ost");
+    pinned.connection.num_sections = 5;
+    pinned.connection.departure_time = 1700000600;
+    pinned.connection.arrival_time = 1700010000;
+    pinned.connection.total_delay_minutes = -2;
+    pinned.connection.num_changes = 4;
+    for (int i = 0; i < 5; i++) {
+        JourneySection *section = &pinned.connection.sections[i];
+        section->departure_station = string_pool_intern(i == 0 ? "Zürich HB" : "Bern");
+        section->arrival_station = string_pool_intern("Interlaken Ost");
+        section->departure_time = 1700000600 + i * 600;
+        section->arrival_time = 1700001200 + i * 600;
+        snprintf(section->platform, sizeof(section->platform), "%d", i + 1);
+        snprintf(section->train_type, sizeof(section->train_type), "IC%d", i);
+        section->delay_minutes = i;
+    }
+    save_pinned_connection(&pinned);
+
+    PinnedConnection loaded = load_pinned_connection();
+
+    assert(loaded.is_active);
+    assert(loaded.pinned_at == 1700000000);
+    assert(strcmp(loaded.route.arrival_station_name, "Interlaken Ost") == 0);
+    assert(loaded.connection.num_sections == 5);
+    assert(loaded.connection.arrival_time == 1700010000);
+    assert(loaded.connection.total_delay_minutes == -2);
+    assert(strcmp(string_pool_get(loaded.connection.sections[0].departure_station), "Zürich HB") == 0);
+    assert(strcmp(string_pool_get(loaded.connection.sections[4].arrival_station), "Interlaken Ost") == 0);
+    assert(strcmp(loaded.connection.sections[4].platform, "5") == 0);
+    assert(strcmp(loaded.connection.sections[4].train_type, "IC4") == 0);
+    assert(loaded.connection.sections[4].delay_minutes == 4);
+
+    clear_pinned_connection();
+    loaded = load_pinned_connection();
+    assert(!loaded.is_active);
+    assert(!persist_exists(PERSIST_RECORD_PINNED_CONNECTION));
+
+    printf("test_save_and_load_pinned_connection: PASS\n");
+}
+
 int main(void) {
     test_save_and_load_connections();
     test_load_when_empty();
     test_connection_limit_reached();
     test_save_and_load_favorites();
     test_load_favorites_when_empty();
+    test_records_span_multiple_keys();
+    test_packed_records_are_smaller_than_structs();
+    test_corrupt_record_is_ignored();
+    test_shrinking_record_drops_stale_chunks();
+    test_migrates_legacy_connections();
+    test_save_and_load_favorite_destinations();
+    test_favorite_destinations_keep_sync_stamp();
+    test_save_and_load_pinned_connection();
     printf("\nAll persistence tests passed!\n");
     return 0;
 }
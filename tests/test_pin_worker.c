@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "../src/pin_worker.h"
+#include "persist_mock.h"
+
+// Mock worker control
+static bool s_running = false;
+static int s_launches = 0;
+static int s_kills = 0;
+static int s_messages = 0;
+
+bool app_worker_is_running(void) {
+    return s_running;
+}
+
+AppWorkerResult app_worker_launch(void) {
+    s_running = true;
+    s_launches++;
+    return APP_WORKER_RESULT_SUCCESS;
+}
+
+AppWorkerResult app_worker_kill(void) {
+    s_running = false;
+    s_kills++;
+    return APP_WORKER_RESULT_SUCCESS;
+}
+
+void app_worker_send_message(uint8_t type, AppWorkerMessage *data) {
+    (void)data;
+    assert(type == PIN_WORKER_MSG_CHANGED);
+    s_messages++;
+}
+
+static void reset(void) {
+    clear_storage();
+    s_running = false;
+    s_launches = 0;
+    s_kills = 0;
+    s_messages = 0;
+}
+
+static PinnedConnection make_pin(time_t departure, int delay) {
+    PinnedConnection pinned;
+    memset(&pinned, 0, sizeof(pinned));
+    pinned.is_active = true;
+    pinned.connection.num_sections = 1;
+    pinned.connection.departure_time = departure;
+    pinned.connection.arrival_time = departure + 3600;
+    pinned.connection.sections[0].delay_minutes = delay;
+    strcpy(pinned.connection.sections[0].platform, "7");
+    return pinned;
+}
+
+void test_summary_states(void) {
+    time_t now = 1699360000;
+    PinSummary summary;
+    PinnedConnection pinned = make_pin(now + 3600, 0);
+
+    assert(pin_worker_build_summary(&pinned, now, &summary));
+    assert(pin_summary_state(&summary, now) == PIN_SUMMARY_WAITING);
+    assert(strcmp(summary.platform, "7") == 0);
+    assert(summary.flags == 0);
+
+    assert(pin_summary_state(&summary, now + 3600 - PIN_SUMMARY_IMMINENT_SECONDS) == PIN_SUMMARY_IMMINENT);
+    assert(pin_summary_state(&summary, now + 3600) == PIN_SUMMARY_DEPARTED);
+    assert(pin_summary_state(&summary, now + 7201) == PIN_SUMMARY_EXPIRED);
+
+    // A delay pushes the wake-up back
+    pinned = make_pin(now + 3600, 10);
+    pin_worker_build_summary(&pinned, now, &summary);
+    assert(pin_summary_state(&summary, now + 3600 - PIN_SUMMARY_IMMINENT_SECONDS) == PIN_SUMMARY_WAITING);
+    assert(pin_summary_state(&summary, now + 4200 - PIN_SUMMARY_IMMINENT_SECONDS) == PIN_SUMMARY_IMMINENT);
+
+    printf("test_summary_states: PASS\n");
+}
+
+void test_nothing_to_track(void) {
+    time_t now = 1699360000;
+    PinSummary summary;
+    PinnedConnection pinned = make_pin(now + 3600, 0);
+
+    pinned.is_active = false;
+    assert(!pin_worker_build_summary(&pinned, now, &summary));
+
+    pinned = make_pin(now - 7200, 0);
+    assert(!pin_worker_build_summary(&pinned, now, &summary));
+
+    printf("test_nothing_to_track: PASS\n");
+}
+
+void test_closing_in_the_window_marks_it_seen(void) {
+    time_t now = 1699360000;
+    PinSummary summary;
+    PinnedConnection pinned = make_pin(now + 60, 0);
+
+    assert(pin_worker_build_summary(&pinned, now, &summary));
+    assert(summary.flags & PIN_SUMMARY_FLAG_SEEN);
+
+    printf("test_closing_in_the_window_marks_it_seen: PASS\n");
+}
+
+void test_sync_starts_updates_and_stops_worker(void) {
+    reset();
+    PinnedConnection pinned = make_pin(time(NULL) + 3600, 0);
+
+    pin_worker_sync(&pinned);
+    assert(s_launches == 1);
+    assert(persist_exists(PIN_SUMMARY_KEY));
+    assert(persist_write_count == 1);
+
+    // Same pin: no flash write, no message
+    pin_worker_sync(&pinned);
+    assert(persist_write_count == 1);
+    assert(s_messages == 0);
+    assert(s_launches == 1);
+
+    pinned.connection.sections[0].delay_minutes = 4;
+    pin_worker_sync(&pinned);
+    assert(persist_write_count == 2);
+    assert(s_messages == 1);
+
+    pinned.is_active = false;
+    pin_worker_sync(&pinned);
+    assert(s_kills == 1);
+    assert(!persist_exists(PIN_SUMMARY_KEY));
+
+    printf("test_sync_starts_updates_and_stops_worker: PASS\n");
+}
+
+int main(void) {
+    test_summary_states();
+    test_nothing_to_track();
+    test_closing_in_the_window_marks_it_seen();
+    test_sync_starts_updates_and_stops_worker();
+    printf("\nAll pin_worker tests passed!\n");
+    return 0;
+}
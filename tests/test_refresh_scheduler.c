@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "../src/refresh_scheduler.h"
+
+// Mock timer: a single pending timer fired by the test
+static AppTimerCallback s_timer_callback = NULL;
+static void *s_timer_data = NULL;
+static uint32_t s_timer_delay = 0;
+static int s_timer_handle;
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+    s_timer_callback = callback;
+    s_timer_data = callback_data;
+    s_timer_delay = timeout_ms;
+    return (AppTimer *)&s_timer_handle;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+    (void)timer_handle;
+    s_timer_callback = NULL;
+}
+
+static void fire_timer(void) {
+    AppTimerCallback callback = s_timer_callback;
+    assert(callback != NULL);
+    s_timer_callback = NULL;
+    callback(s_timer_data);
+}
+
+static BatteryChargeState s_battery = { 80, false, false };
+
+BatteryChargeState battery_state_service_peek(void) {
+    return s_battery;
+}
+
+static AppFocusHandler s_focus_handler = NULL;
+
+void app_focus_service_subscribe(AppFocusHandler handler) {
+    s_focus_handler = handler;
+}
+
+void app_focus_service_unsubscribe(void) {
+    s_focus_handler = NULL;
+}
+
+static int s_refreshes = 0;
+
+static void refresh(void) {
+    s_refreshes++;
+}
+
+static const BatteryChargeState FULL = { 80, false, false };
+
+void test_interval_follows_next_departure(void) {
+    time_t now = 1699360000;
+    assert(refresh_scheduler_interval_ms(0, now, 0, FULL) == 60000);
+    assert(refresh_scheduler_interval_ms(now + 2 * 60, now, 0, FULL) == REFRESH_MIN_INTERVAL_MS);
+    assert(refresh_scheduler_interval_ms(now + 20 * 60, now, 0, FULL) == 60000);
+    assert(refresh_scheduler_interval_ms(now + 90 * 60, now, 0, FULL) == 5 * 60000);
+    assert(refresh_scheduler_interval_ms(now + 5 * 60 * 60, now, 0, FULL) == 15 * 60000);
+
+    printf("test_interval_follows_next_departure: PASS\n");
+}
+
+void test_interval_backs_off(void) {
+    time_t now = 1699360000;
+    time_t soon = now + 60;
+    assert(refresh_scheduler_interval_ms(soon, now, 1, FULL) == 2 * REFRESH_MIN_INTERVAL_MS);
+    assert(refresh_scheduler_interval_ms(soon, now, 3, FULL) == 8 * REFRESH_MIN_INTERVAL_MS);
+    assert(refresh_scheduler_interval_ms(soon, now, 200, FULL) == 16 * REFRESH_MIN_INTERVAL_MS);
+
+    BatteryChargeState low = { 20, false, false };
+    BatteryChargeState critical = { 5, false, false };
+    BatteryChargeState charging = { 5, true, true };
+    assert(refresh_scheduler_interval_ms(soon, now, 0, low) == 2 * REFRESH_MIN_INTERVAL_MS);
+    assert(refresh_scheduler_interval_ms(soon, now, 0, critical) == 4 * REFRESH_MIN_INTERVAL_MS);
+    assert(refresh_scheduler_interval_ms(soon, now, 0, charging) == REFRESH_MIN_INTERVAL_MS);
+
+    // Everything together is still capped
+    assert(refresh_scheduler_interval_ms(0, now, 10, critical) == REFRESH_MAX_INTERVAL_MS);
+
+    printf("test_interval_backs_off: PASS\n");
+}
+
+void test_refreshes_and_replans(void) {
+    RefreshScheduler scheduler;
+    s_refreshes = 0;
+    refresh_scheduler_init(&scheduler, refresh);
+    assert(s_timer_callback != NULL);
+    assert(s_timer_delay == 60000);
+
+    fire_timer();
+    assert(s_refreshes == 1);
+
+    // A far departure stretches the wait; a failure doubles it
+    refresh_scheduler_succeeded(&scheduler, time(NULL) + 5 * 60 * 60);
+    assert(s_timer_delay > 14 * 60000 && s_timer_delay <= 15 * 60000);
+    refresh_scheduler_failed(&scheduler);
+    assert(s_timer_delay > 29 * 60000);
+
+    refresh_scheduler_deinit(&scheduler);
+    assert(s_timer_callback == NULL);
+    assert(s_focus_handler == NULL);
+
+    printf("test_refreshes_and_replans: PASS\n");
+}
+
+void test_pauses_while_hidden_or_unfocused(void) {
+    RefreshScheduler scheduler;
+    s_refreshes = 0;
+    refresh_scheduler_init(&scheduler, refresh);
+    assert(s_focus_handler != NULL);
+
+    refresh_scheduler_pause(&scheduler, REFRESH_PAUSE_HIDDEN);
+    assert(s_timer_callback == NULL);
+    s_focus_handler(false);
+
+    // Both reasons have to clear before the timer runs again
+    refresh_scheduler_resume(&scheduler, REFRESH_PAUSE_HIDDEN);
+    assert(s_timer_callback == NULL);
+    s_focus_handler(true);
+    assert(s_timer_callback != NULL);
+    assert(s_timer_delay <= 60000);
+
+    // Overdue after a long pause: refresh right away
+    refresh_scheduler_pause(&scheduler, REFRESH_PAUSE_HIDDEN);
+    scheduler.last_refresh -= 120;
+    refresh_scheduler_resume(&scheduler, REFRESH_PAUSE_HIDDEN);
+    assert(s_timer_delay == 0);
+    fire_timer();
+    assert(s_refreshes == 1);
+
+    refresh_scheduler_deinit(&scheduler);
+
+    printf("test_pauses_while_hidden_or_unfocused: PASS\n");
+}
+
+int main(void) {
+    test_interval_follows_next_departure();
+    test_interval_backs_off();
+    test_refreshes_and_replans();
+    test_pauses_while_hidden_or_unfocused();
+    printf("\nAll refresh_scheduler tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "../src/row_model.h"
+
+// 2024-01-15 08:02 UTC
+#define T0 1705305720
+
+static Connection make_connection(void) {
+    Connection conn;
+    memset(&conn, 0, sizeof(conn));
+    conn.num_sections = 2;
+    conn.departure_time = T0;
+    conn.arrival_time = T0 + 58 * 60;
+    conn.num_changes = 1;
+
+    JourneySection *first = &conn.sections[0];
+    first->departure_station = string_pool_intern("Zürich HB");
+    first->arrival_station = string_pool_intern("Olten");
+    first->departure_time = T0;
+    first->arrival_time = T0 + 30 * 60;
+    snprintf(first->train_type, sizeof(first->train_type), "IC 1");
+    snprintf(first->platform, sizeof(first->platform), "7");
+    return conn;
+}
+
+void test_connection_row(void) {
+    string_pool_reset();
+    Connection conn = make_connection();
+    ConnectionRow row;
+
+    row_model_build_connection(&conn, &row);
+    assert(strcmp(row.header, "IC 1 | Pl.7") == 0);
+    assert(strcmp(row.time_text, "08:02 - 09:00 | 1 chg") == 0);
+    assert(strcmp(row.footer, "On time") == 0);
+
+    conn.num_changes = 0;
+    conn.total_delay_minutes = 75;
+    conn.sections[0].platform[0] = '\0';
+    row_model_build_connection(&conn, &row);
+    assert(strcmp(row.header, "IC 1") == 0);
+    assert(strcmp(row.time_text, "08:02 - 09:00") == 0);
+    assert(strcmp(row.footer, "+60+ min delay") == 0);
+
+    conn.total_delay_minutes = 4;
+    row_model_build_connection(&conn, &row);
+    assert(strcmp(row.footer, "+4 min delay") == 0);
+
+    printf("test_connection_row: PASS\n");
+}
+
+void test_journey_rows(void) {
+    string_pool_reset();
+    Connection conn = make_connection();
+
+    JourneySummaryRow summary;
+    row_model_build_summary(&conn, &summary);
+    assert(strcmp(summary.title, "08:02 - 09:00") == 0);
+    assert(strcmp(summary.subtitle, "1 changes") == 0);
+
+    JourneySectionRow section;
+    conn.sections[0].delay_minutes = 3;
+    row_model_build_section(&conn.sections[0], &section);
+    assert(strcmp(section.departure, "Zürich HB | Pl.7") == 0);
+    assert(strcmp(section.train, "IC 1 → 08:02") == 0);
+    assert(strcmp(section.arrival_info, "Arr: 08:32 | +3 min") == 0);
+
+    conn.sections[0].platform[0] = '\0';
+    conn.sections[0].delay_minutes = 0;
+    row_model_build_section(&conn.sections[0], &section);
+    assert(strcmp(section.departure, "Zürich HB") == 0);
+    assert(strcmp(section.arrival_info, "Arr: 08:32") == 0);
+
+    printf("test_journey_rows: PASS\n");
+}
+
+int main(void) {
+    setenv("TZ", "UTC", 1);
+    tzset();
+    test_connection_row();
+    test_journey_rows();
+    printf("\nAll row_model tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "../src/storage.h"
+#include "../src/persistence.h"
+#include "persist_mock.h"
+
+void test_favorites_are_written_once_on_flush(void) {
+    clear_storage();
+    storage_reset();
+
+    FavoriteDestination favorites[MAX_FAVORITE_DESTINATIONS];
+    for (int i = 0; i < MAX_FAVORITE_DESTINATIONS; i++) {
+        favorites[i] = create_favorite_destination("8507000", "Bern", "Work");
+        // Receiving one favorite at a time must not touch flash
+        storage_set_favorite_destinations(favorites, i + 1, NULL);
+    }
+    assert(persist_write_count == 0);
+    assert(storage_is_dirty());
+
+    // Reads see the pending list
+    FavoriteDestination loaded[MAX_FAVORITE_DESTINATIONS];
+    assert(storage_get_favorite_destinations(loaded) == MAX_FAVORITE_DESTINATIONS);
+
+    storage_flush();
+    int writes = persist_write_count;
+    assert(writes > 0);
+    assert(!storage_is_dirty());
+
+    // Nothing left to write
+    storage_flush();
+    assert(persist_write_count == writes);
+
+    memset(loaded, 0, sizeof(loaded));
+    assert(load_favorite_destinations(loaded, NULL) == MAX_FAVORITE_DESTINATIONS);
+    assert(strcmp(loaded[9].label, "Work") == 0);
+
+    printf("test_favorites_are_written_once_on_flush: PASS\n");
+}
+
+void test_pin_and_clear_coalesce(void) {
+    clear_storage();
+    storage_reset();
+    string_pool_reset();
+
+    PinnedConnection pinned;
+    memset(&pinned, 0, sizeof(pinned));
+    pinned.is_active = true;
+    pinned.route = create_saved_connection("8503000", "Zürich HB", "8507000", "Bern");
+    pinned.connection.num_sections = 1;
+    pinned.connection.sections[0].departure_station = string_pool_intern("Zürich HB");
+    pinned.connection.sections[0].arrival_station = string_pool_intern("Bern");
+
+    storage_set_pinned_connection(&pinned);
+    assert(persist_write_count == 0);
+
+    // The dirty pin keeps its names alive across a collect
+    string_pool_collect();
+    string_pool_collect();
+    PinnedConnection current = storage_get_pinned_connection();
+    assert(current.is_active);
+    assert(strcmp(string_pool_get(current.connection.sections[0].arrival_station), "Bern") == 0);
+
+    storage_clear_pinned_connection();
+    current = storage_get_pinned_connection();
+    assert(!current.is_active);
+
+    storage_flush();
+    assert(!persist_exists(PERSIST_RECORD_PINNED_CONNECTION));
+    assert(!load_pinned_connection().is_active);
+
+    printf("test_pin_and_clear_coalesce: PASS\n");
+}
+
+void test_connections_are_read_once(void) {
+    clear_storage();
+    storage_reset();
+
+    SavedConnection conns[2];
+    conns[0] = create_saved_connection("8503000", "Zürich HB", "8507000", "Bern");
+    conns[1] = create_saved_connection("8507000", "Bern", "8508500", "Interlaken");
+    save_connections(conns, 2);
+
+    int count = 0;
+    const SavedConnection *cached = storage_get_connections(&count);
+    assert(count == 2);
+    int reads = persist_read_count;
+
+    // Later reads and the limit check come from RAM
+    cached = storage_get_connections(&count);
+    assert(!storage_is_connection_limit_reached());
+    assert(persist_read_count == reads);
+    assert(strcmp(cached[1].arrival_station_name, "Interlaken") == 0);
+
+    printf("test_connections_are_read_once: PASS\n");
+}
+
+void test_added_connections_are_written_through(void) {
+    clear_storage();
+    storage_reset();
+
+    SavedConnection conn = create_saved_connection("8503000", "Zürich HB", "8507000", "Bern");
+    for (int i = 0; i < MAX_SAVED_CONNECTIONS; i++) {
+        assert(storage_add_connection(&conn));
+    }
+    assert(storage_is_connection_limit_reached());
+    assert(!storage_add_connection(&conn));
+
+    // Flash matches RAM without a flush
+    SavedConnection loaded[MAX_SAVED_CONNECTIONS];
+    assert(load_connections(loaded) == MAX_SAVED_CONNECTIONS);
+
+    int count = 0;
+    storage_get_connections(&count);
+    assert(count == MAX_SAVED_CONNECTIONS);
+
+    printf("test_added_connections_are_written_through: PASS\n");
+}
+
+int main(void) {
+    test_favorites_are_written_once_on_flush();
+    test_pin_and_clear_coalesce();
+    test_connections_are_read_once();
+    test_added_connections_are_written_through();
+    printf("\nAll storage tests passed!\n");
+    return 0;
+}
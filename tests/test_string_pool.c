@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "../src/string_pool.h"
+
+// Root used by the tests: keeps s_rooted[0..s_num_rooted) alive
+static StringRef s_rooted[STRING_POOL_MAX_ENTRIES];
+static int s_num_rooted = 0;
+
+static void mark_rooted(void) {
+    for (int i = 0; i < s_num_rooted; i++) {
+        string_pool_mark(s_rooted[i]);
+    }
+}
+
+static void reset(void) {
+    string_pool_reset();
+    s_num_rooted = 0;
+    string_pool_register_root(mark_rooted);
+}
+
+void test_intern_deduplicates(void) {
+    reset();
+    StringRef a = string_pool_intern("Olten");
+    StringRef b = string_pool_intern("Bern");
+    StringRef c = string_pool_intern("Olten");
+
+    assert(a != STRING_REF_NONE);
+    assert(a == c);
+    assert(a != b);
+    assert(strcmp(string_pool_get(a), "Olten") == 0);
+    assert(strcmp(string_pool_get(b), "Bern") == 0);
+    assert(string_pool_count() == 2);
+
+    printf("test_intern_deduplicates: PASS\n");
+}
+
+void test_empty_and_invalid_refs(void) {
+    reset();
+    assert(string_pool_intern("") == STRING_REF_NONE);
+    assert(string_pool_intern(NULL) == STRING_REF_NONE);
+    assert(strcmp(string_pool_get(STRING_REF_NONE), "") == 0);
+    assert(strcmp(string_pool_get(200), "") == 0);
+
+    printf("test_empty_and_invalid_refs: PASS\n");
+}
+
+void test_collect_keeps_rooted_entries(void) {
+    reset();
+    StringRef kept = string_pool_intern("Zürich HB");
+    StringRef dropped = string_pool_intern("Basel SBB");
+    s_rooted[s_num_rooted++] = kept;
+
+    // Everything interned since the last collect survives the first one
+    string_pool_collect();
+    assert(string_pool_count() == 2);
+
+    string_pool_collect();
+    assert(string_pool_count() == 1);
+    assert(strcmp(string_pool_get(kept), "Zürich HB") == 0);
+    assert(strcmp(string_pool_get(dropped), "") == 0);
+
+    printf("test_collect_keeps_rooted_entries: PASS\n");
+}
+
+void test_full_pool_reclaims_unreachable_entries(void) {
+    reset();
+    char name[32];
+
+    // Fill the pool with names nobody holds on to
+    for (int i = 0; i < STRING_POOL_MAX_ENTRIES; i++) {
+        snprintf(name, sizeof(name), "Old station %d", i);
+        assert(string_pool_intern(name) != STRING_REF_NONE);
+    }
+    string_pool_collect();
+
+    // Interning more reclaims them, keeping the new (fresh) names intact
+    StringRef first = string_pool_intern("Lausanne");
+    StringRef second = string_pool_intern("Genève");
+    assert(first != STRING_REF_NONE);
+    assert(second != STRING_REF_NONE);
+    assert(strcmp(string_pool_get(first), "Lausanne") == 0);
+    assert(strcmp(string_pool_get(second), "Genève") == 0);
+    assert(string_pool_count() == 2);
+
+    printf("test_full_pool_reclaims_unreachable_entries: PASS\n");
+}
+
+void test_fresh_entries_survive_a_full_pool(void) {
+    reset();
+    char name[32];
+
+    // A half-decoded connection holds these refs only on the stack
+    int interned = 0;
+    for (int i = 0; i < STRING_POOL_MAX_ENTRIES + 4; i++) {
+        snprintf(name, sizeof(name), "Station %d", i);
+        if (string_pool_intern(name) != STRING_REF_NONE) {
+            interned++;
+        }
+    }
+    assert(interned == STRING_POOL_MAX_ENTRIES);
+    assert(strcmp(string_pool_get(1), "Station 0") == 0);
+
+    printf("test_fresh_entries_survive_a_full_pool: PASS\n");
+}
+
+void test_compaction_preserves_refs(void) {
+    reset();
+    StringRef a = string_pool_intern("Aarau");
+    StringRef b = string_pool_intern("Brugg AG");
+    StringRef c = string_pool_intern("Chur");
+    s_rooted[s_num_rooted++] = a;
+    s_rooted[s_num_rooted++] = c;
+    string_pool_collect();
+    string_pool_collect();
+
+    assert(strcmp(string_pool_get(b), "") == 0);
+    assert(strcmp(string_pool_get(a), "Aarau") == 0);
+    assert(strcmp(string_pool_get(c), "Chur") == 0);
+
+    // The freed slot and bytes are reused
+    StringRef d = string_pool_intern("Davos Platz");
+    assert(d == b);
+    assert(strcmp(string_pool_get(c), "Chur") == 0);
+    assert(strcmp(string_pool_get(d), "Davos Platz") == 0);
+
+    printf("test_compaction_preserves_refs: PASS\n");
+}
+
+void test_long_name_is_shortened_when_bytes_run_out(void) {
+    reset();
+    char name[256];
+
+    // Rooted long names leave less room than the next name needs
+    memset(name, 'a', 99);
+    name[99] = '\0';
+    int rooted = STRING_POOL_BYTES / 100;
+    for (int i = 0; i < rooted; i++) {
+        name[0] = 'A' + i;
+        s_rooted[s_num_rooted++] = string_pool_intern(name);
+    }
+    string_pool_collect();
+    string_pool_collect();
+    int left = STRING_POOL_BYTES - rooted * 100;
+
+    // Ends in "ü" (two bytes) right where the cut would fall
+    memset(name, 'b', sizeof(name));
+    name[left - 2] = (char)0xC3;
+    name[left - 1] = (char)0xBC;
+    name[200] = '\0';
+    StringRef ref = string_pool_intern(name);
+    assert(ref != STRING_REF_NONE);
+    assert((int)strlen(string_pool_get(ref)) == left - 2);
+    assert(strncmp(string_pool_get(ref), name, left - 2) == 0);
+
+    printf("test_long_name_is_shortened_when_bytes_run_out: PASS\n");
+}
+
+static void noop_root_0(void) {}
+static void noop_root_1(void) {}
+static void noop_root_2(void) {}
+static void noop_root_3(void) {}
+static void noop_root_4(void) {}
+static void noop_root_5(void) {}
+
+void test_roots_are_limited_and_can_be_unregistered(void) {
+    reset();
+    StringPoolRootMarker extra[] = { noop_root_0, noop_root_1, noop_root_2, noop_root_3, noop_root_4 };
+
+    // reset() registered mark_rooted already
+    for (int i = 0; i < STRING_POOL_MAX_ROOTS - 1; i++) {
+        assert(string_pool_register_root(extra[i]));
+    }
+    assert(string_pool_register_root(extra[0]));  // Registering again is fine
+    assert(!string_pool_register_root(noop_root_5));
+
+    string_pool_unregister_root(extra[2]);
+    assert(string_pool_register_root(noop_root_5));
+
+    // The remaining roots still mark their entries
+    StringRef kept = string_pool_intern("Brig");
+    s_rooted[s_num_rooted++] = kept;
+    string_pool_unregister_root(extra[0]);
+    string_pool_collect();
+    string_pool_collect();
+    assert(strcmp(string_pool_get(kept), "Brig") == 0);
+
+    printf("test_roots_are_limited_and_can_be_unregistered: PASS\n");
+}
+
+int main(void) {
+    test_intern_deduplicates();
+    test_empty_and_invalid_refs();
+    test_collect_keeps_rooted_entries();
+    test_full_pool_reclaims_unreachable_entries();
+    test_fresh_entries_survive_a_full_pool();
+    test_compaction_preserves_refs();
+    test_long_name_is_shortened_when_bytes_run_out();
+    test_roots_are_limited_and_can_be_unregistered();
+    printf("\nAll string_pool tests passed!\n");
+    return 0;
+}
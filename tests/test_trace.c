@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "../src/trace.h"
+#include "clock_mock.h"
+
+static int32_t read_i32(const uint8_t *in) {
+    return (int32_t)(in[0] | in[1] << 8 | in[2] << 16 | (uint32_t)in[3] << 24);
+}
+
+void test_records_in_order(void) {
+    trace_reset();
+    assert(trace_count() == 0);
+
+    clock_mock_ms = 1500;
+    trace(TRACE_APP_START, 0, 0);
+    clock_mock_ms = 1750;
+    trace(TRACE_CONNECTIONS_SHOWN, 3, 16);
+
+    assert(trace_count() == 2);
+    TraceRecord first = trace_get(0);
+    TraceRecord second = trace_get(1);
+    assert(first.event == TRACE_APP_START);
+    assert(first.time_ms == 1500);
+    assert(second.event == TRACE_CONNECTIONS_SHOWN);
+    assert(second.time_ms == 1750);
+    assert(second.a == 3);
+    assert(second.b == 16);
+
+    printf("test_records_in_order: PASS\n");
+}
+
+void test_wraps_keeping_newest(void) {
+    trace_reset();
+    for (int i = 0; i < TRACE_CAPACITY + 10; i++) {
+        trace(TRACE_OUTBOX_SENT, i, 0);
+    }
+
+    assert(trace_count() == TRACE_CAPACITY);
+    assert(trace_get(0).a == 10);
+    assert(trace_get(TRACE_CAPACITY - 1).a == TRACE_CAPACITY + 9);
+
+    printf("test_wraps_keeping_newest: PASS\n");
+}
+
+void test_empty_buffer_is_one_chunk(void) {
+    trace_reset();
+    uint8_t buffer[TRACE_CHUNK_MAX_SIZE];
+
+    assert(trace_chunk_count() == 1);
+    assert(trace_encode_chunk(0, buffer, sizeof(buffer)) == TRACE_CHUNK_HEADER_SIZE);
+    assert(buffer[0] == 0);
+    assert(buffer[1] == 1);
+    assert(trace_encode_chunk(1, buffer, sizeof(buffer)) == 0);
+
+    printf("test_empty_buffer_is_one_chunk: PASS\n");
+}
+
+void test_encodes_chunks(void) {
+    trace_reset();
+    clock_mock_ms = 70000;
+    for (int i = 0; i < TRACE_RECORDS_PER_CHUNK + 2; i++) {
+        trace(TRACE_OUTBOX_RETRY, -i, 100000 + i);
+    }
+    assert(trace_chunk_count() == 2);
+
+    uint8_t buffer[TRACE_CHUNK_MAX_SIZE];
+    size_t size = trace_encode_chunk(0, buffer, sizeof(buffer));
+    assert(size == TRACE_CHUNK_MAX_SIZE);
+    assert(buffer[0] == 0);
+    assert(buffer[1] == 2);
+
+    size = trace_encode_chunk(1, buffer, sizeof(buffer));
+    assert(size == TRACE_CHUNK_HEADER_SIZE + 2 * TRACE_RECORD_SIZE);
+    assert(buffer[0] == 1);
+
+    // Last record: -17 and 100017
+    const uint8_t *record = &buffer[TRACE_CHUNK_HEADER_SIZE + TRACE_RECORD_SIZE];
+    assert(read_i32(record) == 70000);
+    assert(record[4] == TRACE_OUTBOX_RETRY);
+    assert((int16_t)(record[6] | record[7] << 8) == -17);
+    assert(read_i32(&record[8]) == 100017);
+
+    // A short buffer only takes whole records
+    size = trace_encode_chunk(0, buffer, TRACE_CHUNK_HEADER_SIZE + TRACE_RECORD_SIZE + 5);
+    assert(size == TRACE_CHUNK_HEADER_SIZE + TRACE_RECORD_SIZE);
+
+    printf("test_encodes_chunks: PASS\n");
+}
+
+int main(void) {
+    test_records_in_order();
+    test_wraps_keeping_newest();
+    test_empty_buffer_is_one_chunk();
+    test_encodes_chunks();
+    printf("\nAll trace tests passed!\n");
+    return 0;
+}
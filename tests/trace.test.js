@@ -0,0 +1,52 @@
+const trace = require('../src/pkjs/trace');
+
+// Packs records the way trace_encode_chunk in src/trace.c does
+function chunk(index, count, records) {
+  const bytes = [index, count];
+  records.forEach((r) => {
+    bytes.push(r.time & 0xFF, (r.time >> 8) & 0xFF, (r.time >> 16) & 0xFF, (r.time >>> 24) & 0xFF);
+    bytes.push(r.event, 0, r.a & 0xFF, (r.a >> 8) & 0xFF);
+    bytes.push(r.b & 0xFF, (r.b >> 8) & 0xFF, (r.b >> 16) & 0xFF, (r.b >>> 24) & 0xFF);
+  });
+  return bytes;
+}
+
+describe('Trace', () => {
+  beforeEach(() => {
+    jest.spyOn(console, 'log').mockImplementation(() => {});
+  });
+
+  afterEach(() => {
+    console.log.mockRestore();
+  });
+
+  test('decodes signed fields and event names', () => {
+    const records = trace.decodeChunk(chunk(0, 1, [
+      { time: 3000000000, event: 5, a: -2, b: -100000 }
+    ]));
+
+    expect(records).toEqual([
+      { timeMs: 3000000000, event: 'OUTBOX_RETRY', a: -2, b: -100000 }
+    ]);
+  });
+
+  test('returns the records once every chunk arrived', () => {
+    const first = chunk(0, 2, [{ time: 10, event: 1, a: 0, b: 0 }]);
+    const second = chunk(1, 2, [{ time: 20, event: 8, a: 3, b: 16 }]);
+
+    expect(trace.handleTraceData(second)).toBeNull();
+    const records = trace.handleTraceData(first);
+
+    expect(records.map((r) => r.event)).toEqual(['APP_START', 'CONNECTIONS_SHOWN']);
+    expect(records[1].b).toBe(16);
+  });
+
+  test('formats latency summaries as percentiles', () => {
+    const record = { timeMs: 5, event: 'LATENCY_SUMMARY', a: 3, b: (1024 << 16) | 256 };
+    expect(trace.formatRecord(record)).toBe('5 LATENCY_SUMMARY fetch p50 256 ms p90 1024 ms');
+  });
+
+  test('answers an empty buffer with no records', () => {
+    expect(trace.handleTraceData([0, 1])).toEqual([]);
+  });
+});
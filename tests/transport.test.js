@@ -0,0 +1,104 @@
+const transport = require('../src/pkjs/transport');
+
+// Mock Pebble: each send is held until the test acks or nacks it
+global.Pebble = {
+  sendAppMessage: jest.fn()
+};
+
+let pending;
+
+function ack() {
+  pending.shift().success({});
+}
+
+function nack() {
+  pending.shift().failure({ error: 'NACK' });
+}
+
+function sentKeys() {
+  return Pebble.sendAppMessage.mock.calls.map((call) => Object.keys(call[0])[0]);
+}
+
+describe('Transport', () => {
+  beforeEach(() => {
+    jest.useFakeTimers();
+    transport.reset();
+    pending = [];
+    Pebble.sendAppMessage.mockReset();
+    Pebble.sendAppMessage.mockImplementation((msg, success, failure) => {
+      pending.push({ success, failure });
+    });
+  });
+
+  afterEach(() => {
+    jest.useRealTimers();
+  });
+
+  test('sends the next message as soon as the previous one is acked', () => {
+    transport.send({ A: 1 });
+    transport.send({ B: 1 });
+    transport.send({ C: 1 });
+
+    expect(sentKeys()).toEqual(['A']);
+    ack();
+    expect(sentKeys()).toEqual(['A', 'B']);
+    ack();
+    ack();
+    expect(sentKeys()).toEqual(['A', 'B', 'C']);
+    expect(transport.pending()).toBe(0);
+  });
+
+  test('resolves once the watch acks the message', async () => {
+    const sent = transport.send({ A: 1 });
+    ack();
+    await expect(sent).resolves.toEqual({});
+  });
+
+  test('retries a NACKed message with exponential backoff', () => {
+    transport.send({ A: 1 });
+    transport.send({ B: 1 });
+
+    nack();
+    jest.advanceTimersByTime(transport.RETRY_BASE_DELAY_MS - 1);
+    expect(sentKeys()).toEqual(['A']);
+    jest.advanceTimersByTime(1);
+    expect(sentKeys()).toEqual(['A', 'A']);
+
+    nack();
+    jest.advanceTimersByTime(transport.RETRY_BASE_DELAY_MS * 2);
+    expect(sentKeys()).toEqual(['A', 'A', 'A']);
+
+    // Ordering is preserved across retries
+    ack();
+    expect(sentKeys()).toEqual(['A', 'A', 'A', 'B']);
+  });
+
+  test('rejects after the retry budget and moves on', async () => {
+    const failed = transport.send({ A: 1 });
+    transport.send({ B: 1 });
+
+    for (let i = 0; i < transport.MAX_RETRIES; i++) {
+      nack();
+      jest.runAllTimers();
+    }
+    nack();
+
+    await expect(failed).rejects.toThrow('not acknowledged');
+    expect(sentKeys()).toEqual(['A', 'A', 'A', 'A', 'B']);
+  });
+
+  test('user-facing messages go ahead of queued background sync', () => {
+    transport.send({ NUM_FAVORITES: 2 }, transport.PRIORITY_LOW);
+    transport.send({ FAVORITE_DESTINATION_ID: 1 }, transport.PRIORITY_LOW);
+    transport.send({ FAVORITE_DESTINATION_ID: 2 }, transport.PRIORITY_LOW);
+    transport.send({ CONNECTION_DATA: [] }, transport.PRIORITY_HIGH);
+
+    ack();
+    ack();
+    ack();
+    ack();
+    expect(sentKeys()).toEqual([
+      'NUM_FAVORITES', 'CONNECTION_DATA', 'FAVORITE_DESTINATION_ID', 'FAVORITE_DESTINATION_ID'
+    ]);
+  });
+});
@@ -0,0 +1,462 @@
+// Generates the packed AppMessage codec from protocol/messages.json:
+//   src/message_codec.h / src/message_codec.c  - watch-side decoder
+//   src/pkjs/message_codec.js                  - phone-side encoder/decoder
+//
+// Usage: node tools/gen_codec.js [--check]
+//   --check  exit non-zero if the checked-in files are out of date
+
+var fs = require('fs');
+var path = require('path');
+
+var ROOT = path.join(__dirname, '..');
+var SCHEMA_PATH = path.join(ROOT, 'protocol', 'messages.json');
+var HEADER = 'Generated by tools/gen_codec.js from protocol/messages.json - do not edit.';
+
+var INT_TYPES = {
+    u8: { bytes: 1, signed: false, c: 'uint8_t', min: 0, max: 0xFF },
+    i8: { bytes: 1, signed: true, c: 'int8_t', min: -0x80, max: 0x7F },
+    u16: { bytes: 2, signed: false, c: 'uint16_t', min: 0, max: 0xFFFF },
+    i16: { bytes: 2, signed: true, c: 'int16_t', min: -0x8000, max: 0x7FFF },
+    u32: { bytes: 4, signed: false, c: 'uint32_t', min: 0, max: 0xFFFFFFFF },
+    i32: { bytes: 4, signed: true, c: 'int32_t', min: -0x80000000, max: 0x7FFFFFFF }
+};
+
+function camel(name) {
+    return name.replace(/_([a-z])/g, function(m, c) { return c.toUpperCase(); })
+               .replace(/^[a-z]/, function(c) { return c.toUpperCase(); });
+}
+
+function findRecord(schema, name) {
+    for (var i = 0; i < schema.records.length; i++) {
+        if (schema.records[i].name === name) {
+            return schema.records[i];
+        }
+    }
+    throw new Error('Unknown record: ' + name);
+}
+
+function validate(schema) {
+    schema.records.forEach(function(record) {
+        record.fields.forEach(function(field) {
+            if (field.intern && field.type !== 'string') {
+                throw new Error(record.name + '.' + field.name + ': only strings can be interned');
+            }
+            if (field.type === 'string') {
+                if (!(field.max > 1 && field.max <= 256)) {
+                    throw new Error(record.name + '.' + field.name + ': string max must be 2..256');
+                }
+            } else if (field.type === 'list') {
+                findRecord(schema, field.of);
+                if (!(field.max > 0 && field.max <= 255) || !field.count) {
+                    throw new Error(record.name + '.' + field.name + ': list needs max (1..255) and count');
+                }
+                if (field.stream && record.fields[record.fields.length - 1] !== field) {
+                    throw new Error(record.name + '.' + field.name + ': stream list must be the last field');
+                }
+            } else if (!INT_TYPES[field.type]) {
+                throw new Error(record.name + '.' + field.name + ': unknown type ' + field.type);
+            }
+        });
+    });
+}
+
+// Integer widths actually used, so the generated C has no unused helpers
+function usedWidths(schema) {
+    var widths = {};
+    schema.records.forEach(function(record) {
+        if (record.message) {
+            widths[1] = true;
+        }
+        record.fields.forEach(function(field) {
+            if (INT_TYPES[field.type]) {
+                widths[INT_TYPES[field.type].bytes] = true;
+            } else {
+                widths[1] = true;  // string length / list count prefix
+            }
+        });
+    });
+    return widths;
+}
+
+function usesIntern(schema) {
+    return schema.records.some(function(record) {
+        return record.fields.some(function(field) { return field.intern; });
+    });
+}
+
+function usesType(schema, type) {
+    return schema.records.some(function(record) {
+        return record.fields.some(function(field) { return field.type === type; });
+    });
+}
+
+// ---------------------------------------------------------------------------
+// C decoder
+
+function generateCHeader(schema) {
+    var lines = [];
+    lines.push('// ' + HEADER);
+    lines.push('#pragma once');
+    lines.push('#include "data_models.h"');
+    lines.push('');
+    lines.push('#define MESSAGE_CODEC_VERSION ' + schema.version);
+    schema.records.forEach(function(record) {
+        if (!record.define) {
+            return;
+        }
+        lines.push('');
+        lines.push('typedef struct {');
+        record.fields.forEach(function(field) {
+            if (field.type === 'list') {
+                lines.push('    uint8_t ' + field.count + ';  // ' + field.of + ' records that follow');
+            } else {
+                lines.push('    ' + INT_TYPES[field.type].c + ' ' + field.c + ';');
+            }
+        });
+        lines.push('} ' + record.c_type + ';');
+    });
+    lines.push('');
+    lines.push('// Each decoder reads one packed record straight out of an AppMessage byte');
+    lines.push('// array and returns the number of bytes consumed, or 0 if the payload is');
+    lines.push('// truncated, malformed or was encoded with a different schema version.');
+    lines.push('// Streamed lists are not decoded: the return value is the offset of the');
+    lines.push('// first list item, which the caller decodes one at a time.');
+    schema.records.forEach(function(record) {
+        lines.push('size_t message_codec_decode_' + record.name + '(const uint8_t *data, size_t length, ' +
+                   record.c_type + ' *out);');
+    });
+    return lines.join('\n') + '\n';
+}
+
+function cReadExpr(type) {
+    var info = INT_TYPES[type];
+    var raw = 'read_u' + (info.bytes * 8) + '(reader)';
+    return info.signed ? '(' + info.c + ')' + raw : raw;
+}
+
+function generateCSource(schema) {
+    var widths = usedWidths(schema);
+    var lines = [];
+    lines.push('// ' + HEADER);
+    lines.push('#include "message_codec.h"');
+    if (usesIntern(schema)) {
+        lines.push('#include "string_pool.h"');
+    }
+    lines.push('#include <string.h>');
+    lines.push('');
+    lines.push('typedef struct {');
+    lines.push('    const uint8_t *pos;');
+    lines.push('    const uint8_t *end;');
+    lines.push('    bool ok;');
+    lines.push('} CodecReader;');
+    lines.push('');
+    lines.push('static bool reader_has(CodecReader *reader, size_t count) {');
+    lines.push('    if (!reader->ok || (size_t)(reader->end - reader->pos) < count) {');
+    lines.push('        reader->ok = false;');
+    lines.push('        return false;');
+    lines.push('    }');
+    lines.push('    return true;');
+    lines.push('}');
+    if (widths[1]) {
+        lines.push('');
+        lines.push('static uint8_t read_u8(CodecReader *reader) {');
+        lines.push('    if (!reader_has(reader, 1)) {');
+        lines.push('        return 0;');
+        lines.push('    }');
+        lines.push('    return *reader->pos++;');
+        lines.push('}');
+    }
+    if (widths[2]) {
+        lines.push('');
+        lines.push('static uint16_t read_u16(CodecReader *reader) {');
+        lines.push('    if (!reader_has(reader, 2)) {');
+        lines.push('        return 0;');
+        lines.push('    }');
+        lines.push('    uint16_t value = (uint16_t)(reader->pos[0] | (reader->pos[1] << 8));');
+        lines.push('    reader->pos += 2;');
+        lines.push('    return value;');
+        lines.push('}');
+    }
+    if (widths[4]) {
+        lines.push('');
+        lines.push('static uint32_t read_u32(CodecReader *reader) {');
+        lines.push('    if (!reader_has(reader, 4)) {');
+        lines.push('        return 0;');
+        lines.push('    }');
+        lines.push('    uint32_t value = (uint32_t)reader->pos[0] |');
+        lines.push('                     ((uint32_t)reader->pos[1] << 8) |');
+        lines.push('                     ((uint32_t)reader->pos[2] << 16) |');
+        lines.push('                     ((uint32_t)reader->pos[3] << 24);');
+        lines.push('    reader->pos += 4;');
+        lines.push('    return value;');
+        lines.push('}');
+    }
+    if (usesType(schema, 'string')) {
+        lines.push('');
+        lines.push('// Strings are a length byte followed by UTF-8 without terminator');
+        lines.push('static void read_string(CodecReader *reader, char *dest, size_t dest_size) {');
+        lines.push('    uint8_t length = read_u8(reader);');
+        lines.push('    if (!reader_has(reader, length)) {');
+        lines.push('        dest[0] = \'\\0\';');
+        lines.push('        return;');
+        lines.push('    }');
+        lines.push('    size_t copy = length < dest_size ? length : dest_size - 1;');
+        lines.push('    memcpy(dest, reader->pos, copy);');
+        lines.push('    dest[copy] = \'\\0\';');
+        lines.push('    reader->pos += length;');
+        lines.push('}');
+    }
+
+    schema.records.forEach(function(record) {
+        lines.push('');
+        lines.push('static void read_' + record.name + '(CodecReader *reader, ' + record.c_type + ' *out) {');
+        record.fields.forEach(function(field) {
+            if (field.type === 'string' && field.intern) {
+                // Interned strings are stored in the pool; the struct keeps a StringRef
+                lines.push('    {');
+                lines.push('        char ' + field.c + '[' + field.max + '];');
+                lines.push('        read_string(reader, ' + field.c + ', sizeof(' + field.c + '));');
+                lines.push('        out->' + field.c + ' = string_pool_intern(' + field.c + ');');
+                lines.push('    }');
+            } else if (field.type === 'string') {
+                lines.push('    read_string(reader, out->' + field.c + ', sizeof(out->' + field.c + '));');
+            } else if (field.type === 'list' && field.stream) {
+                lines.push('    out->' + field.count + ' = read_u8(reader);');
+                lines.push('    if (out->' + field.count + ' > ' + field.max + ') {');
+                lines.push('        reader->ok = false;');
+                lines.push('    }');
+            } else if (field.type === 'list') {
+                var countVar = field.count;
+                lines.push('    uint8_t ' + countVar + ' = read_u8(reader);');
+                lines.push('    if (' + countVar + ' > sizeof(out->' + field.c + ') / sizeof(out->' + field.c + '[0])) {');
+                lines.push('        reader->ok = false;');
+                lines.push('        return;');
+                lines.push('    }');
+                lines.push('    out->' + countVar + ' = ' + countVar + ';');
+                lines.push('    for (int i = 0; i < ' + countVar + ' && reader->ok; i++) {');
+                lines.push('        read_' + field.of + '(reader, &out->' + field.c + '[i]);');
+                lines.push('    }');
+            } else {
+                lines.push('    out->' + field.c + ' = ' + cReadExpr(field.type) + ';');
+            }
+        });
+        lines.push('}');
+    });
+
+    schema.records.forEach(function(record) {
+        lines.push('');
+        lines.push('size_t message_codec_decode_' + record.name + '(const uint8_t *data, size_t length, ' +
+                   record.c_type + ' *out) {');
+        lines.push('    CodecReader reader = { data, data + length, data != NULL };');
+        lines.push('    memset(out, 0, sizeof(*out));');
+        if (record.message) {
+            lines.push('    if (read_u8(&reader) != MESSAGE_CODEC_VERSION) {');
+            lines.push('        return 0;');
+            lines.push('    }');
+        }
+        lines.push('    read_' + record.name + '(&reader, out);');
+        lines.push('    return reader.ok ? (size_t)(reader.pos - data) : 0;');
+        lines.push('}');
+    });
+    return lines.join('\n') + '\n';
+}
+
+// ---------------------------------------------------------------------------
+// JS encoder / decoder
+
+function generateJs(schema) {
+    var lines = [];
+    var exportsList = ['SCHEMA_VERSION: SCHEMA_VERSION'];
+    lines.push('// ' + HEADER);
+    lines.push('');
+    lines.push('var SCHEMA_VERSION = ' + schema.version + ';');
+    lines.push('');
+    lines.push('function clampInt(value, min, max) {');
+    lines.push('    var n = Math.floor(Number(value) || 0);');
+    lines.push('    return n < min ? min : (n > max ? max : n);');
+    lines.push('}');
+    lines.push('');
+    lines.push('function writeInt(out, value, bytes, min, max) {');
+    lines.push('    var n = clampInt(value, min, max);');
+    lines.push('    for (var i = 0; i < bytes; i++) {');
+    lines.push('        out.push(n & 0xFF);');
+    lines.push('        n = Math.floor(n / 256);');
+    lines.push('    }');
+    lines.push('}');
+    lines.push('');
+    lines.push('// UTF-8 encode, truncated on a character boundary so the watch can store');
+    lines.push('// it with a terminator in a maxBytes-sized buffer');
+    lines.push('function writeString(out, value, maxBytes) {');
+    lines.push('    var str = value === undefined || value === null ? \'\' : String(value);');
+    lines.push('    var bytes = [];');
+    lines.push('    for (var i = 0; i < str.length; i++) {');
+    lines.push('        var code = str.charCodeAt(i);');
+    lines.push('        if (code >= 0xD800 && code <= 0xDBFF && i + 1 < str.length) {');
+    lines.push('            code = 0x10000 + ((code - 0xD800) << 10) + (str.charCodeAt(++i) - 0xDC00);');
+    lines.push('        }');
+    lines.push('        var encoded;');
+    lines.push('        if (code < 0x80) {');
+    lines.push('            encoded = [code];');
+    lines.push('        } else if (code < 0x800) {');
+    lines.push('            encoded = [0xC0 | (code >> 6), 0x80 | (code & 0x3F)];');
+    lines.push('        } else if (code < 0x10000) {');
+    lines.push('            encoded = [0xE0 | (code >> 12), 0x80 | ((code >> 6) & 0x3F), 0x80 | (code & 0x3F)];');
+    lines.push('        } else {');
+    lines.push('            encoded = [0xF0 | (code >> 18), 0x80 | ((code >> 12) & 0x3F),');
+    lines.push('                       0x80 | ((code >> 6) & 0x3F), 0x80 | (code & 0x3F)];');
+    lines.push('        }');
+    lines.push('        if (bytes.length + encoded.length > maxBytes - 1) {');
+    lines.push('            break;');
+    lines.push('        }');
+    lines.push('        bytes.push.apply(bytes, encoded);');
+    lines.push('    }');
+    lines.push('    out.push(bytes.length);');
+    lines.push('    out.push.apply(out, bytes);');
+    lines.push('}');
+    lines.push('');
+    lines.push('function Reader(bytes) {');
+    lines.push('    this.bytes = bytes;');
+    lines.push('    this.pos = 0;');
+    lines.push('}');
+    lines.push('');
+    lines.push('Reader.prototype.take = function(count) {');
+    lines.push('    if (this.pos + count > this.bytes.length) {');
+    lines.push('        throw new Error(\'Truncated payload\');');
+    lines.push('    }');
+    lines.push('    var start = this.pos;');
+    lines.push('    this.pos += count;');
+    lines.push('    return start;');
+    lines.push('};');
+    lines.push('');
+    lines.push('Reader.prototype.readInt = function(bytes, signed) {');
+    lines.push('    var start = this.take(bytes);');
+    lines.push('    var n = 0;');
+    lines.push('    for (var i = bytes - 1; i >= 0; i--) {');
+    lines.push('        n = n * 256 + this.bytes[start + i];');
+    lines.push('    }');
+    lines.push('    var limit = Math.pow(2, bytes * 8);');
+    lines.push('    return signed && n >= limit / 2 ? n - limit : n;');
+    lines.push('};');
+    lines.push('');
+    lines.push('Reader.prototype.readString = function() {');
+    lines.push('    var length = this.readInt(1, false);');
+    lines.push('    var start = this.take(length);');
+    lines.push('    var escaped = \'\';');
+    lines.push('    for (var i = start; i < start + length; i++) {');
+    lines.push('        escaped += \'%\' + (\'0\' + this.bytes[i].toString(16)).slice(-2);');
+    lines.push('    }');
+    lines.push('    return decodeURIComponent(escaped);');
+    lines.push('};');
+
+    schema.records.forEach(function(record) {
+        var fn = camel(record.name);
+        lines.push('');
+        lines.push('function encode' + fn + 'Into(out, value) {');
+        record.fields.forEach(function(field) {
+            var access = 'value.' + field.name;
+            if (field.type === 'string') {
+                lines.push('    writeString(out, ' + access + ', ' + field.max + ');');
+            } else if (field.type === 'list') {
+                lines.push('    var ' + field.name + ' = (' + access + ' || []).slice(0, ' + field.max + ');');
+                lines.push('    out.push(' + field.name + '.length);');
+                lines.push('    for (var i = 0; i < ' + field.name + '.length; i++) {');
+                lines.push('        encode' + camel(field.of) + 'Into(out, ' + field.name + '[i]);');
+                lines.push('    }');
+            } else {
+                var info = INT_TYPES[field.type];
+                lines.push('    writeInt(out, ' + access + ', ' + info.bytes + ', ' + info.min + ', ' + info.max + ');');
+            }
+        });
+        lines.push('    return out;');
+        lines.push('}');
+        lines.push('');
+        lines.push('function encode' + fn + '(value) {');
+        lines.push('    return encode' + fn + 'Into(' + (record.message ? '[SCHEMA_VERSION]' : '[]') + ', value);');
+        lines.push('}');
+        lines.push('');
+        lines.push('function read' + fn + '(reader) {');
+        lines.push('    var value = {};');
+        record.fields.forEach(function(field) {
+            if (field.type === 'string') {
+                lines.push('    value.' + field.name + ' = reader.readString();');
+            } else if (field.type === 'list') {
+                lines.push('    var ' + field.name + 'Count = reader.readInt(1, false);');
+                lines.push('    value.' + field.name + ' = [];');
+                lines.push('    for (var i = 0; i < ' + field.name + 'Count; i++) {');
+                lines.push('        value.' + field.name + '.push(read' + camel(field.of) + '(reader));');
+                lines.push('    }');
+            } else {
+                var info = INT_TYPES[field.type];
+                lines.push('    value.' + field.name + ' = reader.readInt(' + info.bytes + ', ' + info.signed + ');');
+            }
+        });
+        lines.push('    return value;');
+        lines.push('}');
+        lines.push('');
+        lines.push('function decode' + fn + '(bytes) {');
+        lines.push('    var reader = new Reader(bytes);');
+        if (record.message) {
+            lines.push('    if (reader.readInt(1, false) !== SCHEMA_VERSION) {');
+            lines.push('        throw new Error(\'Unsupported schema version\');');
+            lines.push('    }');
+        }
+        lines.push('    return read' + fn + '(reader);');
+        lines.push('}');
+        exportsList.push('encode' + fn + ': encode' + fn);
+        exportsList.push('encode' + fn + 'Into: encode' + fn + 'Into');
+        exportsList.push('decode' + fn + ': decode' + fn);
+    });
+
+    lines.push('');
+    lines.push('module.exports = {');
+    lines.push(exportsList.map(function(e) { return '    ' + e; }).join(',\n'));
+    lines.push('};');
+    return lines.join('\n') + '\n';
+}
+
+function generate(schema) {
+    validate(schema);
+    var outputs = {};
+    outputs['src/message_codec.h'] = generateCHeader(schema);
+    outputs['src/message_codec.c'] = generateCSource(schema);
+    outputs['src/pkjs/message_codec.js'] = generateJs(schema);
+    return outputs;
+}
+
+function loadSchema() {
+    return JSON.parse(fs.readFileSync(SCHEMA_PATH, 'utf8'));
+}
+
+function main() {
+    var check = process.argv.indexOf('--check') !== -1;
+    var outputs = generate(loadSchema());
+    var stale = [];
+
+    Object.keys(outputs).forEach(function(relPath) {
+        var target = path.join(ROOT, relPath);
+        var current = fs.existsSync(target) ? fs.readFileSync(target, 'utf8') : null;
+        if (current === outputs[relPath]) {
+            return;
+        }
+        if (check) {
+            stale.push(relPath);
+        } else {
+            fs.writeFileSync(target, outputs[relPath]);
+            console.log('Wrote ' + relPath);
+        }
+    });
+
+    if (stale.length > 0) {
+        console.error('Out of date: ' + stale.join(', ') + ' (run: npm run codec)');
+        process.exit(1);
+    }
+}
+
+if (require.main === module) {
+    main();
+}
+
+module.exports = {
+    generate: generate,
+    loadSchema: loadSchema
+};
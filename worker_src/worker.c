@@ -0,0 +1,75 @@
+#include <pebble_worker.h>
+#include "../src/pin_summary.h"
+
+// Background worker for the pinned journey. It only reads the small
+// PinSummary record, checks it once a minute and launches the app once the
+// departure is imminent. It has no phone connection: live delays and
+// platforms come from the refresh the app runs when it opens.
+
+static PinSummary s_summary;
+static bool s_tracking = false;
+static bool s_woke_app = false;
+
+static void load_summary(void) {
+    s_tracking = persist_read_data(PIN_SUMMARY_KEY, &s_summary, sizeof(s_summary)) == (int)sizeof(s_summary) &&
+                 s_summary.version == PIN_SUMMARY_VERSION;
+    s_woke_app = s_tracking && (s_summary.flags & PIN_SUMMARY_FLAG_SEEN);
+}
+
+static void check_pin(void) {
+    if (!s_tracking) {
+        return;
+    }
+
+    switch (pin_summary_state(&s_summary, time(NULL))) {
+        case PIN_SUMMARY_IMMINENT:
+            if (!s_woke_app) {
+                s_woke_app = true;
+                worker_launch_app();
+            }
+            break;
+        case PIN_SUMMARY_EXPIRED:
+            // Nothing left to count down; stay idle until the app pins again
+            s_tracking = false;
+            tick_timer_service_unsubscribe();
+            break;
+        default:
+            break;
+    }
+}
+
+static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
+    check_pin();
+}
+
+static void start_tracking(void) {
+    load_summary();
+    if (s_tracking) {
+        tick_timer_service_subscribe(MINUTE_UNIT, tick_handler);
+        check_pin();
+    } else {
+        tick_timer_service_unsubscribe();
+    }
+}
+
+static void app_message_handler(uint16_t type, AppWorkerMessage *data) {
+    if (type == PIN_WORKER_MSG_CHANGED) {
+        start_tracking();
+    }
+}
+
+static void init(void) {
+    app_worker_message_subscribe(app_message_handler);
+    start_tracking();
+}
+
+static void deinit(void) {
+    tick_timer_service_unsubscribe();
+    app_worker_message_unsubscribe();
+}
+
+int main(void) {
+    init();
+    worker_event_loop();
+    deinit();
+}